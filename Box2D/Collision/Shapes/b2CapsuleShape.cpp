@@ -0,0 +1,188 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Collision/Shapes/b2CapsuleShape.h>
+#include <new>
+
+void b2CapsuleShape::Set(const b2Vec2& v1, const b2Vec2& v2, float32 radius)
+{
+	// If the code crashes here, it means your centers are too close together.
+	// Use a circle instead.
+	b2Assert(b2DistanceSquared(v1, v2) > b2_linearSlop * b2_linearSlop);
+	b2Assert(radius > 0.0f);
+
+	m_vertex1 = v1;
+	m_vertex2 = v2;
+	m_radius = radius;
+}
+
+b2Shape* b2CapsuleShape::Clone(b2BlockAllocator* allocator) const
+{
+	void* mem = allocator->Allocate(sizeof(b2CapsuleShape));
+	b2CapsuleShape* clone = new (mem) b2CapsuleShape;
+	*clone = *this;
+	return clone;
+}
+
+int32 b2CapsuleShape::GetChildCount() const
+{
+	return 1;
+}
+
+bool b2CapsuleShape::TestPoint(const b2Transform& transform, const b2Vec2& p) const
+{
+	b2Vec2 localPoint = b2MulT(transform, p);
+
+	// Find the closest point on the segment.
+	b2Vec2 e = m_vertex2 - m_vertex1;
+	float32 t = b2Dot(localPoint - m_vertex1, e) / b2Dot(e, e);
+	t = b2Clamp(t, 0.0f, 1.0f);
+	b2Vec2 closest = m_vertex1 + t * e;
+
+	return b2DistanceSquared(localPoint, closest) <= m_radius * m_radius;
+}
+
+// The ray is tested against the two sides and the two end circles. The
+// closest hit is the entry point into the capsule.
+bool b2CapsuleShape::RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
+							const b2Transform& xf, int32 childIndex) const
+{
+	B2_NOT_USED(childIndex);
+
+	// Put the ray into the capsule's frame of reference.
+	b2Vec2 p1 = b2MulT(xf.q, input.p1 - xf.p);
+	b2Vec2 p2 = b2MulT(xf.q, input.p2 - xf.p);
+	b2Vec2 d = p2 - p1;
+
+	float32 rr = b2Dot(d, d);
+	if (rr < b2_epsilon)
+	{
+		return false;
+	}
+
+	b2Vec2 e = m_vertex2 - m_vertex1;
+	float32 length = e.Normalize();
+	b2Vec2 normal = b2Cross(e, 1.0f);
+
+	bool hit = false;
+	float32 fraction = input.maxFraction;
+	b2Vec2 hitNormal;
+
+	// Sides
+	for (int32 i = 0; i < 2; ++i)
+	{
+		b2Vec2 n = i == 0 ? normal : -normal;
+
+		// The ray must enter through the side.
+		float32 denominator = b2Dot(n, d);
+		if (denominator >= 0.0f)
+		{
+			continue;
+		}
+
+		float32 numerator = b2Dot(n, m_vertex1 - p1) + m_radius;
+		float32 t = numerator / denominator;
+		if (t < 0.0f || fraction < t)
+		{
+			continue;
+		}
+
+		// Is the hit between the end circles?
+		b2Vec2 q = p1 + t * d;
+		float32 s = b2Dot(q - m_vertex1, e);
+		if (s < 0.0f || length < s)
+		{
+			continue;
+		}
+
+		hit = true;
+		fraction = t;
+		hitNormal = n;
+	}
+
+	// End circles, see b2CircleShape::RayCast.
+	for (int32 i = 0; i < 2; ++i)
+	{
+		b2Vec2 center = i == 0 ? m_vertex1 : m_vertex2;
+		b2Vec2 s = p1 - center;
+		float32 b = b2Dot(s, s) - m_radius * m_radius;
+		float32 c = b2Dot(s, d);
+		float32 sigma = c * c - rr * b;
+		if (sigma < 0.0f)
+		{
+			continue;
+		}
+
+		float32 a = -(c + b2Sqrt(sigma));
+		if (0.0f <= a && a <= fraction * rr)
+		{
+			hit = true;
+			fraction = a / rr;
+			hitNormal = s + fraction * d;
+			hitNormal.Normalize();
+		}
+	}
+
+	if (hit == false)
+	{
+		return false;
+	}
+
+	output->fraction = fraction;
+	output->normal = b2Mul(xf.q, hitNormal);
+	return true;
+}
+
+void b2CapsuleShape::ComputeAABB(b2AABB* aabb, const b2Transform& xf, int32 childIndex) const
+{
+	B2_NOT_USED(childIndex);
+
+	b2Vec2 v1 = b2Mul(xf, m_vertex1);
+	b2Vec2 v2 = b2Mul(xf, m_vertex2);
+
+	b2Vec2 r(m_radius, m_radius);
+	aabb->lowerBound = b2Min(v1, v2) - r;
+	aabb->upperBound = b2Max(v1, v2) + r;
+}
+
+void b2CapsuleShape::ComputeMass(b2MassData* massData, float32 density) const
+{
+	// The capsule is a box between the centers plus a circle split over the ends.
+	float32 radius = m_radius;
+	float32 rr = radius * radius;
+	float32 length = b2Distance(m_vertex1, m_vertex2);
+	float32 ll = length * length;
+
+	float32 circleMass = density * b2_pi * rr;
+	float32 boxMass = density * 2.0f * radius * length;
+
+	massData->mass = circleMass + boxMass;
+	massData->center = 0.5f * (m_vertex1 + m_vertex2);
+
+	// Each half circle has its centroid lc beyond a center. The half circles are
+	// moved out to the ends with the parallel axis theorem.
+	float32 lc = 4.0f * radius / (3.0f * b2_pi);
+	float32 h = 0.5f * length;
+	float32 circleInertia = circleMass * (0.5f * rr + h * h + 2.0f * h * lc);
+	float32 boxInertia = boxMass * (4.0f * rr + ll) / 12.0f;
+	massData->I = circleInertia + boxInertia;
+
+	// Shift to the shape origin.
+	massData->I += massData->mass * b2Dot(massData->center, massData->center);
+}
@@ -30,7 +30,7 @@ b2ChainShape::~b2ChainShape()
 
 void b2ChainShape::CreateLoop(const b2Vec2* vertices, int32 count)
 {
-	b2Assert(m_vertices == NULL && m_count == 0);
+	b2Assert(m_vertices == NULL && m_count == 0 && m_tree.IsEmpty());
 	b2Assert(count >= 3);
 	for (int32 i = 1; i < count; ++i)
 	{
@@ -52,7 +52,7 @@ void b2ChainShape::CreateLoop(const b2Vec2* vertices, int32 count)
 
 void b2ChainShape::CreateChain(const b2Vec2* vertices, int32 count)
 {
-	b2Assert(m_vertices == NULL && m_count == 0);
+	b2Assert(m_vertices == NULL && m_count == 0 && m_tree.IsEmpty());
 	b2Assert(count >= 2);
 	for (int32 i = 1; i < count; ++i)
 	{
@@ -85,6 +85,29 @@ void b2ChainShape::SetNextVertex(const b2Vec2& nextVertex)
 	m_hasNextVertex = true;
 }
 
+void b2ChainShape::BuildTree()
+{
+	b2Assert(m_tree.IsEmpty());
+	b2Assert(m_count >= 2);
+
+	int32 edgeCount = m_count - 1;
+	b2AABB* aabbs = (b2AABB*)b2Alloc(edgeCount * sizeof(b2AABB));
+
+	// Include the radius so the tree bounds the edges as the narrow-phase sees them.
+	b2Vec2 r(m_radius, m_radius);
+	for (int32 i = 0; i < edgeCount; ++i)
+	{
+		b2Vec2 v1 = m_vertices[i];
+		b2Vec2 v2 = m_vertices[i + 1];
+		aabbs[i].lowerBound = b2Min(v1, v2) - r;
+		aabbs[i].upperBound = b2Max(v1, v2) + r;
+	}
+
+	m_tree.Build(aabbs, edgeCount);
+
+	b2Free(aabbs);
+}
+
 b2Shape* b2ChainShape::Clone(b2BlockAllocator* allocator) const
 {
 	void* mem = allocator->Allocate(sizeof(b2ChainShape));
@@ -94,11 +117,20 @@ b2Shape* b2ChainShape::Clone(b2BlockAllocator* allocator) const
 	clone->m_nextVertex = m_nextVertex;
 	clone->m_hasPrevVertex = m_hasPrevVertex;
 	clone->m_hasNextVertex = m_hasNextVertex;
+
+	clone->m_tree.Copy(m_tree);
+
 	return clone;
 }
 
 int32 b2ChainShape::GetChildCount() const
 {
+	// A chain with a tree is a single child.
+	if (HasTree())
+	{
+		return 1;
+	}
+
 	// edge count = vertex count - 1
 	return m_count - 1;
 }
@@ -147,6 +179,11 @@ bool b2ChainShape::RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
 {
 	b2Assert(childIndex < m_count);
 
+	if (HasTree())
+	{
+		return RayCastTree(output, input, xf);
+	}
+
 	b2EdgeShape edgeShape;
 
 	int32 i1 = childIndex;
@@ -162,10 +199,75 @@ bool b2ChainShape::RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
 	return edgeShape.RayCast(output, input, xf, 0);
 }
 
+// Casts the ray against the edges reported by the chain tree.
+struct b2ChainRayCastCallback
+{
+	float32 RayCastCallback(const b2RayCastInput& localInput, int32 edge)
+	{
+		b2EdgeShape edgeShape;
+		edgeShape.m_vertex1 = chain->m_vertices[edge];
+		edgeShape.m_vertex2 = chain->m_vertices[edge + 1];
+
+		b2RayCastInput subInput = *input;
+		subInput.maxFraction = localInput.maxFraction;
+
+		b2RayCastOutput edgeOutput;
+		if (edgeShape.RayCast(&edgeOutput, subInput, *xf, 0))
+		{
+			*output = edgeOutput;
+			hit = true;
+			return edgeOutput.fraction;
+		}
+
+		return -1.0f;
+	}
+
+	const b2ChainShape* chain;
+	const b2RayCastInput* input;
+	const b2Transform* xf;
+	b2RayCastOutput* output;
+	bool hit;
+};
+
+bool b2ChainShape::RayCastTree(b2RayCastOutput* output, const b2RayCastInput& input,
+								const b2Transform& xf) const
+{
+	b2ChainRayCastCallback callback;
+	callback.chain = this;
+	callback.input = &input;
+	callback.xf = &xf;
+	callback.output = output;
+	callback.hit = false;
+
+	// The tree is traversed in local space and the edges are cast in world space.
+	// The fraction is the same in both.
+	b2RayCastInput localInput;
+	localInput.p1 = b2MulT(xf, input.p1);
+	localInput.p2 = b2MulT(xf, input.p2);
+	localInput.maxFraction = input.maxFraction;
+	m_tree.RayCast(&callback, localInput);
+
+	return callback.hit;
+}
+
 void b2ChainShape::ComputeAABB(b2AABB* aabb, const b2Transform& xf, int32 childIndex) const
 {
 	b2Assert(childIndex < m_count);
 
+	if (HasTree())
+	{
+		// Rotate the bounds of the tree.
+		const b2AABB& bounds = m_tree.GetAABB();
+		b2Vec2 center = b2Mul(xf, bounds.GetCenter());
+		b2Vec2 extents = bounds.GetExtents();
+		float32 c = b2Abs(xf.q.c);
+		float32 s = b2Abs(xf.q.s);
+		b2Vec2 r(c * extents.x + s * extents.y, s * extents.x + c * extents.y);
+		aabb->lowerBound = center - r;
+		aabb->upperBound = center + r;
+		return;
+	}
+
 	int32 i1 = childIndex;
 	int32 i2 = childIndex + 1;
 	if (i2 == m_count)
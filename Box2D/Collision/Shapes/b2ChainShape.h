@@ -20,6 +20,7 @@
 #define B2_CHAIN_SHAPE_H
 
 #include <Box2D/Collision/Shapes/b2Shape.h>
+#include <Box2D/Collision/b2StaticTree.h>
 
 class b2EdgeShape;
 
@@ -55,15 +56,32 @@ public:
 	/// Don't call this for loops.
 	void SetNextVertex(const b2Vec2& nextVertex);
 
+	/// Build a bounding volume tree over the edges. The chain then has a single child,
+	/// so a fixture needs one broad-phase proxy and each overlapping fixture gets one
+	/// contact with a manifold per touching edge. Use this for large terrain.
+	/// Call this after CreateLoop or CreateChain and before creating a fixture.
+	void BuildTree();
+
+	/// Does this chain have a bounding volume tree?
+	bool HasTree() const;
+
 	/// Implement b2Shape. Vertices are cloned using b2Alloc.
 	b2Shape* Clone(b2BlockAllocator* allocator) const;
 
 	/// @see b2Shape::GetChildCount
 	int32 GetChildCount() const;
 
-	/// Get a child edge.
+	/// Get the number of edges. This is the child count unless the chain has a tree.
+	int32 GetEdgeCount() const;
+
+	/// Get a child edge. The index is an edge index, see GetEdgeCount.
 	void GetChildEdge(b2EdgeShape* edge, int32 index) const;
 
+	/// Query the edges whose bounds overlap the supplied local AABB. The callback
+	/// receives edge indices. The chain must have a tree.
+	template <typename T>
+	void Query(T* callback, const b2AABB& aabb) const;
+
 	/// This always return false.
 	/// @see b2Shape::TestPoint
 	bool TestPoint(const b2Transform& transform, const b2Vec2& p) const;
@@ -75,6 +93,10 @@ public:
 	/// @see b2Shape::ComputeAABB
 	void ComputeAABB(b2AABB* aabb, const b2Transform& transform, int32 childIndex) const;
 
+	/// Ray cast against all edges of a chain with a tree.
+	bool RayCastTree(b2RayCastOutput* output, const b2RayCastInput& input,
+					const b2Transform& transform) const;
+
 	/// Chains have zero mass.
 	/// @see b2Shape::ComputeMass
 	void ComputeMass(b2MassData* massData, float32 density) const;
@@ -87,6 +109,9 @@ public:
 
 	b2Vec2 m_prevVertex, m_nextVertex;
 	bool m_hasPrevVertex, m_hasNextVertex;
+
+	/// The edge tree. Empty unless BuildTree was called.
+	b2StaticTree m_tree;
 };
 
 inline b2ChainShape::b2ChainShape()
@@ -99,4 +124,21 @@ inline b2ChainShape::b2ChainShape()
 	m_hasNextVertex = false;
 }
 
+inline bool b2ChainShape::HasTree() const
+{
+	return m_tree.IsEmpty() == false;
+}
+
+inline int32 b2ChainShape::GetEdgeCount() const
+{
+	// edge count = vertex count - 1
+	return m_count - 1;
+}
+
+template <typename T>
+inline void b2ChainShape::Query(T* callback, const b2AABB& aabb) const
+{
+	m_tree.Query(callback, aabb);
+}
+
 #endif
@@ -0,0 +1,194 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Collision/Shapes/b2CompoundShape.h>
+#include <new>
+
+b2CompoundShape::~b2CompoundShape()
+{
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_polygons[i].~b2PolygonShape();
+	}
+
+	b2Free(m_polygons);
+	m_polygons = NULL;
+	m_count = 0;
+}
+
+void b2CompoundShape::Create(const b2PolygonShape* polygons, int32 count)
+{
+	b2Assert(m_polygons == NULL && m_count == 0);
+	b2Assert(count >= 1);
+
+	m_count = count;
+	m_polygons = (b2PolygonShape*)b2Alloc(count * sizeof(b2PolygonShape));
+	b2AABB* aabbs = (b2AABB*)b2Alloc(count * sizeof(b2AABB));
+
+	b2Transform identity;
+	identity.SetIdentity();
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		// The contact solver uses the radius of the compound for every manifold.
+		b2Assert(polygons[i].m_radius == m_radius);
+
+		new (m_polygons + i) b2PolygonShape(polygons[i]);
+		m_polygons[i].ComputeAABB(aabbs + i, identity, 0);
+	}
+
+	m_tree.Build(aabbs, count);
+
+	b2Free(aabbs);
+}
+
+b2Shape* b2CompoundShape::Clone(b2BlockAllocator* allocator) const
+{
+	void* mem = allocator->Allocate(sizeof(b2CompoundShape));
+	b2CompoundShape* clone = new (mem) b2CompoundShape;
+	clone->Create(m_polygons, m_count);
+	return clone;
+}
+
+int32 b2CompoundShape::GetChildCount() const
+{
+	return 1;
+}
+
+// Tests the point against the polygons reported by the compound tree.
+struct b2CompoundPointCallback
+{
+	bool QueryCallback(int32 index)
+	{
+		if (compound->m_polygons[index].TestPoint(*xf, p))
+		{
+			inside = true;
+			return false;
+		}
+
+		return true;
+	}
+
+	const b2CompoundShape* compound;
+	const b2Transform* xf;
+	b2Vec2 p;
+	bool inside;
+};
+
+bool b2CompoundShape::TestPoint(const b2Transform& xf, const b2Vec2& p) const
+{
+	b2CompoundPointCallback callback;
+	callback.compound = this;
+	callback.xf = &xf;
+	callback.p = p;
+	callback.inside = false;
+
+	b2AABB aabb;
+	aabb.lowerBound = b2MulT(xf, p);
+	aabb.upperBound = aabb.lowerBound;
+	m_tree.Query(&callback, aabb);
+
+	return callback.inside;
+}
+
+// Casts the ray against the polygons reported by the compound tree.
+struct b2CompoundRayCastCallback
+{
+	float32 RayCastCallback(const b2RayCastInput& localInput, int32 index)
+	{
+		b2RayCastInput subInput = *input;
+		subInput.maxFraction = localInput.maxFraction;
+
+		b2RayCastOutput polygonOutput;
+		if (compound->m_polygons[index].RayCast(&polygonOutput, subInput, *xf, 0))
+		{
+			*output = polygonOutput;
+			hit = true;
+			return polygonOutput.fraction;
+		}
+
+		return -1.0f;
+	}
+
+	const b2CompoundShape* compound;
+	const b2RayCastInput* input;
+	const b2Transform* xf;
+	b2RayCastOutput* output;
+	bool hit;
+};
+
+bool b2CompoundShape::RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
+								const b2Transform& xf, int32 childIndex) const
+{
+	B2_NOT_USED(childIndex);
+
+	b2CompoundRayCastCallback callback;
+	callback.compound = this;
+	callback.input = &input;
+	callback.xf = &xf;
+	callback.output = output;
+	callback.hit = false;
+
+	// The tree is traversed in local space and the polygons are cast in world space.
+	// The fraction is the same in both.
+	b2RayCastInput localInput;
+	localInput.p1 = b2MulT(xf, input.p1);
+	localInput.p2 = b2MulT(xf, input.p2);
+	localInput.maxFraction = input.maxFraction;
+	m_tree.RayCast(&callback, localInput);
+
+	return callback.hit;
+}
+
+void b2CompoundShape::ComputeAABB(b2AABB* aabb, const b2Transform& xf, int32 childIndex) const
+{
+	B2_NOT_USED(childIndex);
+
+	// Rotate the bounds of the tree.
+	const b2AABB& bounds = m_tree.GetAABB();
+	b2Vec2 center = b2Mul(xf, bounds.GetCenter());
+	b2Vec2 extents = bounds.GetExtents();
+	float32 c = b2Abs(xf.q.c);
+	float32 s = b2Abs(xf.q.s);
+	b2Vec2 r(c * extents.x + s * extents.y, s * extents.x + c * extents.y);
+	aabb->lowerBound = center - r;
+	aabb->upperBound = center + r;
+}
+
+void b2CompoundShape::ComputeMass(b2MassData* massData, float32 density) const
+{
+	massData->mass = 0.0f;
+	massData->center.SetZero();
+	massData->I = 0.0f;
+
+	// The polygon inertia is about the shape origin, so it adds up directly.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2MassData polygonMass;
+		m_polygons[i].ComputeMass(&polygonMass, density);
+		massData->mass += polygonMass.mass;
+		massData->center += polygonMass.mass * polygonMass.center;
+		massData->I += polygonMass.I;
+	}
+
+	if (massData->mass > 0.0f)
+	{
+		massData->center *= 1.0f / massData->mass;
+	}
+}
@@ -0,0 +1,113 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_COMPOUND_SHAPE_H
+#define B2_COMPOUND_SHAPE_H
+
+#include <Box2D/Collision/Shapes/b2Shape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Collision/b2StaticTree.h>
+
+/// A compound shape is a set of convex polygons under a bounding volume tree.
+/// The compound has a single child, so a fixture needs one broad-phase proxy. The
+/// narrow-phase uses the tree to collide only the polygons that are near each other,
+/// giving one contact per fixture pair with a manifold per touching pair of polygons.
+/// Use this instead of a fixture per polygon for bodies with many convex parts.
+/// Since there may be many polygons, they are allocated using b2Alloc.
+/// The polygons must have the default polygon radius.
+class b2CompoundShape : public b2Shape
+{
+public:
+	b2CompoundShape();
+
+	/// The destructor frees the polygons using b2Free.
+	~b2CompoundShape();
+
+	/// Create the compound and build the tree.
+	/// @param polygons an array of polygons, these are copied
+	/// @param count the polygon count
+	void Create(const b2PolygonShape* polygons, int32 count);
+
+	/// Implement b2Shape. Polygons are cloned using b2Alloc.
+	b2Shape* Clone(b2BlockAllocator* allocator) const;
+
+	/// @see b2Shape::GetChildCount
+	int32 GetChildCount() const;
+
+	/// Get the number of polygons.
+	int32 GetShapeCount() const;
+
+	/// Get a polygon by index.
+	const b2PolygonShape* GetShape(int32 index) const;
+
+	/// Query the polygons whose bounds overlap the supplied local AABB. The callback
+	/// receives polygon indices.
+	template <typename T>
+	void Query(T* callback, const b2AABB& aabb) const;
+
+	/// Test a point for containment in any polygon.
+	/// @see b2Shape::TestPoint
+	bool TestPoint(const b2Transform& transform, const b2Vec2& p) const;
+
+	/// Implement b2Shape. This reports the closest polygon hit.
+	bool RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
+					const b2Transform& transform, int32 childIndex) const;
+
+	/// @see b2Shape::ComputeAABB
+	void ComputeAABB(b2AABB* aabb, const b2Transform& transform, int32 childIndex) const;
+
+	/// @see b2Shape::ComputeMass
+	void ComputeMass(b2MassData* massData, float32 density) const;
+
+	/// The polygons. Owned by this class.
+	b2PolygonShape* m_polygons;
+
+	/// The polygon count.
+	int32 m_count;
+
+	/// The polygon tree.
+	b2StaticTree m_tree;
+};
+
+inline b2CompoundShape::b2CompoundShape()
+{
+	m_type = e_compound;
+	m_radius = b2_polygonRadius;
+	m_polygons = NULL;
+	m_count = 0;
+}
+
+inline int32 b2CompoundShape::GetShapeCount() const
+{
+	return m_count;
+}
+
+inline const b2PolygonShape* b2CompoundShape::GetShape(int32 index) const
+{
+	b2Assert(0 <= index && index < m_count);
+	return m_polygons + index;
+}
+
+template <typename T>
+inline void b2CompoundShape::Query(T* callback, const b2AABB& aabb) const
+{
+	m_tree.Query(callback, aabb);
+}
+
+#endif
@@ -39,6 +39,8 @@ void b2PolygonShape::SetAsBox(float32 hx, float32 hy)
 	m_normals[2].Set(0.0f, 1.0f);
 	m_normals[3].Set(-1.0f, 0.0f);
 	m_centroid.SetZero();
+	m_boxExtents.Set(hx, hy);
+	m_isBox = true;
 }
 
 void b2PolygonShape::SetAsBox(float32 hx, float32 hy, const b2Vec2& center, float32 angle)
@@ -53,6 +55,8 @@ void b2PolygonShape::SetAsBox(float32 hx, float32 hy, const b2Vec2& center, floa
 	m_normals[2].Set(0.0f, 1.0f);
 	m_normals[3].Set(-1.0f, 0.0f);
 	m_centroid = center;
+	m_boxExtents.Set(hx, hy);
+	m_isBox = true;
 
 	b2Transform xf;
 	xf.p = center;
@@ -218,6 +222,7 @@ void b2PolygonShape::Set(const b2Vec2* vertices, int32 count)
 	}
 	
 	m_count = m;
+	m_isBox = false;
 
 	// Copy vertices.
 	for (int32 i = 0; i < m; ++i)
@@ -375,6 +380,16 @@ void b2PolygonShape::ComputeMass(b2MassData* massData, float32 density) const
 
 	b2Assert(m_count >= 3);
 
+	if (m_isBox)
+	{
+		// Closed form for a box: I = m * (w^2 + h^2) / 12 about the center.
+		float32 hx = m_boxExtents.x, hy = m_boxExtents.y;
+		massData->mass = density * 4.0f * hx * hy;
+		massData->center = m_centroid;
+		massData->I = massData->mass * ((hx * hx + hy * hy) / 3.0f + b2Dot(m_centroid, m_centroid));
+		return;
+	}
+
 	b2Vec2 center; center.Set(0.0f, 0.0f);
 	float32 area = 0.0f;
 	float32 I = 0.0f;
@@ -78,10 +78,21 @@ public:
 	/// @returns true if valid
 	bool Validate() const;
 
+	/// Was this polygon built with SetAsBox? Boxes use dedicated collision
+	/// and mass routines.
+	bool IsBox() const { return m_isBox; }
+
+	/// Get the box frame in local coordinates. Only valid for boxes.
+	b2Transform GetBoxTransform() const;
+
 	b2Vec2 m_centroid;
 	b2Vec2 m_vertices[b2_maxPolygonVertices];
 	b2Vec2 m_normals[b2_maxPolygonVertices];
 	int32 m_count;
+
+	/// Box half-widths, only valid if m_isBox is set.
+	b2Vec2 m_boxExtents;
+	bool m_isBox;
 };
 
 inline b2PolygonShape::b2PolygonShape()
@@ -90,6 +101,20 @@ inline b2PolygonShape::b2PolygonShape()
 	m_radius = b2_polygonRadius;
 	m_count = 0;
 	m_centroid.SetZero();
+	m_boxExtents.SetZero();
+	m_isBox = false;
+}
+
+inline b2Transform b2PolygonShape::GetBoxTransform() const
+{
+	b2Assert(m_isBox);
+
+	// The second normal is the box x-axis.
+	b2Transform xf;
+	xf.p = m_centroid;
+	xf.q.s = m_normals[1].y;
+	xf.q.c = m_normals[1].x;
+	return xf;
 }
 
 inline const b2Vec2& b2PolygonShape::GetVertex(int32 index) const
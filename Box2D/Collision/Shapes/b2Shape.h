@@ -49,7 +49,9 @@ public:
 		e_edge = 1,
 		e_polygon = 2,
 		e_chain = 3,
-		e_typeCount = 4
+		e_compound = 4,
+		e_capsule = 5,
+		e_typeCount = 6
 	};
 
 	virtual ~b2Shape() {}
@@ -17,24 +17,27 @@
 */
 
 #include <Box2D/Collision/b2BroadPhase.h>
+#include <Box2D/Common/b2AllocatorInterface.h>
+#include <Box2D/Common/b2Snapshot.h>
 
-b2BroadPhase::b2BroadPhase()
+b2BroadPhase::b2BroadPhase(b2AllocatorInterface* allocator) : m_tree(allocator)
 {
+	m_memory = allocator ? allocator : b2GetDefaultAllocator();
 	m_proxyCount = 0;
 
 	m_pairCapacity = 16;
 	m_pairCount = 0;
-	m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+	m_pairBuffer = (b2Pair*)m_memory->Allocate(m_pairCapacity * sizeof(b2Pair));
 
 	m_moveCapacity = 16;
 	m_moveCount = 0;
-	m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+	m_moveBuffer = (int32*)m_memory->Allocate(m_moveCapacity * sizeof(int32));
 }
 
 b2BroadPhase::~b2BroadPhase()
 {
-	b2Free(m_moveBuffer);
-	b2Free(m_pairBuffer);
+	m_memory->Free(m_moveBuffer);
+	m_memory->Free(m_pairBuffer);
 }
 
 int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
@@ -52,6 +55,71 @@ void b2BroadPhase::DestroyProxy(int32 proxyId)
 	m_tree.DestroyProxy(proxyId);
 }
 
+void b2BroadPhase::CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds)
+{
+	m_tree.CreateProxies(aabbs, userData, count, proxyIds);
+	m_proxyCount += count;
+	for (int32 i = 0; i < count; ++i)
+	{
+		BufferMove(proxyIds[i]);
+	}
+}
+
+void b2BroadPhase::DestroyProxies(const int32* proxyIds, int32 count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	// Unbuffer the moves in one pass over the buffer rather than one per proxy.
+	int32* sorted = (int32*)m_memory->Allocate(count * sizeof(int32));
+	memcpy(sorted, proxyIds, count * sizeof(int32));
+	std::sort(sorted, sorted + count);
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		if (std::binary_search(sorted, sorted + count, m_moveBuffer[i]))
+		{
+			m_moveBuffer[i] = e_nullProxy;
+		}
+	}
+	m_memory->Free(sorted);
+
+	m_proxyCount -= count;
+	m_tree.DestroyProxies(proxyIds, count);
+}
+
+void b2BroadPhase::Clear()
+{
+	m_tree.Clear();
+	m_proxyCount = 0;
+	m_moveCount = 0;
+	m_pairCount = 0;
+}
+
+void b2BroadPhase::SaveState(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_proxyCount);
+	snapshot->Write(m_moveCount);
+	snapshot->Write(m_moveBuffer, m_moveCount * sizeof(int32));
+	m_tree.SaveState(snapshot);
+}
+
+void b2BroadPhase::RestoreState(b2SnapshotReader* reader)
+{
+	m_proxyCount = reader->Read<int32>();
+	m_moveCount = reader->Read<int32>();
+	if (m_moveCapacity < m_moveCount)
+	{
+		m_memory->Free(m_moveBuffer);
+		m_moveCapacity = m_moveCount;
+		m_moveBuffer = (int32*)m_memory->Allocate(m_moveCapacity * sizeof(int32));
+	}
+	reader->Read(m_moveBuffer, m_moveCount * sizeof(int32));
+	m_pairCount = 0;
+	m_tree.RestoreState(reader);
+}
+
 void b2BroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
 {
 	bool buffer = m_tree.MoveProxy(proxyId, aabb, displacement);
@@ -72,9 +140,9 @@ void b2BroadPhase::BufferMove(int32 proxyId)
 	{
 		int32* oldBuffer = m_moveBuffer;
 		m_moveCapacity *= 2;
-		m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+		m_moveBuffer = (int32*)m_memory->Allocate(m_moveCapacity * sizeof(int32));
 		memcpy(m_moveBuffer, oldBuffer, m_moveCount * sizeof(int32));
-		b2Free(oldBuffer);
+		m_memory->Free(oldBuffer);
 	}
 
 	m_moveBuffer[m_moveCount] = proxyId;
@@ -106,9 +174,9 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 	{
 		b2Pair* oldBuffer = m_pairBuffer;
 		m_pairCapacity *= 2;
-		m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+		m_pairBuffer = (b2Pair*)m_memory->Allocate(m_pairCapacity * sizeof(b2Pair));
 		memcpy(m_pairBuffer, oldBuffer, m_pairCount * sizeof(b2Pair));
-		b2Free(oldBuffer);
+		m_memory->Free(oldBuffer);
 	}
 
 	m_pairBuffer[m_pairCount].proxyIdA = b2Min(proxyId, m_queryProxyId);
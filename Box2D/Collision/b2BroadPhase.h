@@ -42,7 +42,8 @@ public:
 		e_nullProxy = -1
 	};
 
-	b2BroadPhase();
+	/// @param allocator the source of the buffers and tree nodes, or NULL for the default allocator
+	b2BroadPhase(b2AllocatorInterface* allocator = NULL);
 	~b2BroadPhase();
 
 	/// Create a proxy with an initial AABB. Pairs are not reported until
@@ -52,6 +53,22 @@ public:
 	/// Destroy a proxy. It is up to the client to remove any pairs.
 	void DestroyProxy(int32 proxyId);
 
+	/// Create a batch of proxies with initial AABBs. This bulk-builds the tree.
+	/// @param proxyIds receives the id of each proxy
+	void CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds);
+
+	/// Destroy a batch of proxies. It is up to the client to remove any pairs.
+	void DestroyProxies(const int32* proxyIds, int32 count);
+
+	/// Destroy all the proxies.
+	void Clear();
+
+	/// Write the tree and the buffered moves to a snapshot.
+	void SaveState(b2Snapshot* snapshot) const;
+
+	/// Read the tree and the buffered moves back from a snapshot.
+	void RestoreState(b2SnapshotReader* reader);
+
 	/// Call MoveProxy as many times as you like, then when you are done
 	/// call UpdatePairs to finalized the proxy pairs (for your time step).
 	void MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement);
@@ -113,6 +130,8 @@ private:
 
 	bool QueryCallback(int32 proxyId);
 
+	b2AllocatorInterface* m_memory;
+
 	b2DynamicTree m_tree;
 
 	int32 m_proxyCount;
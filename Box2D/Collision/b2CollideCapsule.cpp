@@ -0,0 +1,439 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Collision/b2Collision.h>
+#include <Box2D/Collision/b2Distance.h>
+#include <Box2D/Collision/Shapes/b2CapsuleShape.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+
+// A convex hull with a radius. Polygons are used in place and segments, the core
+// of capsules and edges, are hulls of two vertices with opposite normals.
+struct b2RoundedHull
+{
+	void Set(const b2PolygonShape* polygon)
+	{
+		vertices = polygon->m_vertices;
+		normals = polygon->m_normals;
+		count = polygon->m_count;
+		radius = polygon->m_radius;
+	}
+
+	void Set(const b2Vec2& v1, const b2Vec2& v2, float32 r)
+	{
+		buffer[0] = v1;
+		buffer[1] = v2;
+		buffer[2] = b2Cross(v2 - v1, 1.0f);
+		buffer[2].Normalize();
+		buffer[3] = -buffer[2];
+
+		vertices = buffer;
+		normals = buffer + 2;
+		count = 2;
+		radius = r;
+	}
+
+	const b2Vec2* vertices;
+	const b2Vec2* normals;
+	int32 count;
+	float32 radius;
+	b2Vec2 buffer[4];
+};
+
+// Find the max separation between hull1 and hull2 using edge normals from hull1.
+// See b2CollidePolygons.
+static float32 b2FindMaxHullSeparation(int32* edgeIndex,
+									   const b2RoundedHull& hull1, const b2Transform& xf1,
+									   const b2RoundedHull& hull2, const b2Transform& xf2)
+{
+	b2Transform xf = b2MulT(xf2, xf1);
+
+	int32 bestIndex = 0;
+	float32 maxSeparation = -b2_maxFloat;
+	for (int32 i = 0; i < hull1.count; ++i)
+	{
+		// Get hull1 normal in frame2.
+		b2Vec2 n = b2Mul(xf.q, hull1.normals[i]);
+		b2Vec2 v1 = b2Mul(xf, hull1.vertices[i]);
+
+		// Find deepest point for normal i.
+		float32 si = b2_maxFloat;
+		for (int32 j = 0; j < hull2.count; ++j)
+		{
+			float32 sij = b2Dot(n, hull2.vertices[j] - v1);
+			if (sij < si)
+			{
+				si = sij;
+			}
+		}
+
+		if (si > maxSeparation)
+		{
+			maxSeparation = si;
+			bestIndex = i;
+		}
+	}
+
+	*edgeIndex = bestIndex;
+	return maxSeparation;
+}
+
+static void b2FindIncidentHullEdge(b2ClipVertex c[2],
+								   const b2RoundedHull& hull1, const b2Transform& xf1, int32 edge1,
+								   const b2RoundedHull& hull2, const b2Transform& xf2)
+{
+	b2Assert(0 <= edge1 && edge1 < hull1.count);
+
+	// Get the normal of the reference edge in hull2's frame.
+	b2Vec2 normal1 = b2MulT(xf2.q, b2Mul(xf1.q, hull1.normals[edge1]));
+
+	// Find the incident edge on hull2.
+	int32 index = 0;
+	float32 minDot = b2_maxFloat;
+	for (int32 i = 0; i < hull2.count; ++i)
+	{
+		float32 dot = b2Dot(normal1, hull2.normals[i]);
+		if (dot < minDot)
+		{
+			minDot = dot;
+			index = i;
+		}
+	}
+
+	// Build the clip vertices for the incident edge.
+	int32 i1 = index;
+	int32 i2 = i1 + 1 < hull2.count ? i1 + 1 : 0;
+
+	c[0].v = b2Mul(xf2, hull2.vertices[i1]);
+	c[0].id.cf.indexA = (uint8)edge1;
+	c[0].id.cf.indexB = (uint8)i1;
+	c[0].id.cf.typeA = b2ContactFeature::e_face;
+	c[0].id.cf.typeB = b2ContactFeature::e_vertex;
+
+	c[1].v = b2Mul(xf2, hull2.vertices[i2]);
+	c[1].id.cf.indexA = (uint8)edge1;
+	c[1].id.cf.indexB = (uint8)i2;
+	c[1].id.cf.typeA = b2ContactFeature::e_face;
+	c[1].id.cf.typeB = b2ContactFeature::e_vertex;
+}
+
+// Distance between the cores of two hulls.
+static void b2ComputeHullDistance(b2DistanceOutput* output, b2SimplexCache* cache,
+								  const b2RoundedHull& hullA, const b2Transform& xfA,
+								  const b2RoundedHull& hullB, const b2Transform& xfB)
+{
+	b2DistanceInput input;
+	input.proxyA.m_vertices = hullA.vertices;
+	input.proxyA.m_count = hullA.count;
+	input.proxyB.m_vertices = hullB.vertices;
+	input.proxyB.m_count = hullB.count;
+	input.transformA = xfA;
+	input.transformB = xfB;
+	input.useRadii = false;
+
+	cache->count = 0;
+	b2Distance(output, cache, &input);
+}
+
+// Single point contact between the closest points of the cores. Used when the
+// reference face does not clip the incident edge, for example two collinear
+// segments end to end.
+static void b2CollideClosestFeatures(b2Manifold* manifold,
+									 const b2RoundedHull& hullA, const b2Transform& xfA,
+									 const b2RoundedHull& hullB, const b2Transform& xfB)
+{
+	manifold->pointCount = 0;
+
+	b2SimplexCache cache;
+	b2DistanceOutput output;
+	b2ComputeHullDistance(&output, &cache, hullA, xfA, hullB, xfB);
+
+	// Overlapping cores give no normal.
+	if (output.distance > hullA.radius + hullB.radius || output.distance < b2_epsilon)
+	{
+		return;
+	}
+
+	manifold->type = b2Manifold::e_circles;
+	manifold->localPoint = b2MulT(xfA, output.pointA);
+	manifold->localNormal.SetZero();
+	manifold->pointCount = 1;
+
+	b2ManifoldPoint* cp = manifold->points + 0;
+	cp->localPoint = b2MulT(xfB, output.pointB);
+	cp->id.cf.indexA = (uint8)cache.indexA[0];
+	cp->id.cf.indexB = (uint8)cache.indexB[0];
+	cp->id.cf.typeA = b2ContactFeature::e_vertex;
+	cp->id.cf.typeB = b2ContactFeature::e_vertex;
+}
+
+// Collide two rounded hulls. This is b2CollidePolygons with one addition: when the
+// cores are apart and the closest features are two vertices, the face normals
+// under estimate the distance, so the closest points give a single point contact.
+// The same happens when clipping leaves fewer than two points.
+static void b2CollideHulls(b2Manifold* manifold,
+						   const b2RoundedHull& hullA, const b2Transform& xfA,
+						   const b2RoundedHull& hullB, const b2Transform& xfB)
+{
+	manifold->pointCount = 0;
+	float32 totalRadius = hullA.radius + hullB.radius;
+	const float32 k_tol = 0.1f * b2_linearSlop;
+
+	int32 edgeA = 0;
+	float32 separationA = b2FindMaxHullSeparation(&edgeA, hullA, xfA, hullB, xfB);
+	if (separationA > totalRadius)
+	{
+		return;
+	}
+
+	int32 edgeB = 0;
+	float32 separationB = b2FindMaxHullSeparation(&edgeB, hullB, xfB, hullA, xfA);
+	if (separationB > totalRadius)
+	{
+		return;
+	}
+
+	float32 separation = b2Max(separationA, separationB);
+	if (separation > k_tol)
+	{
+		b2SimplexCache cache;
+		b2DistanceOutput output;
+		b2ComputeHullDistance(&output, &cache, hullA, xfA, hullB, xfB);
+
+		if (output.distance > totalRadius)
+		{
+			return;
+		}
+
+		if (output.distance > separation + k_tol && cache.count == 1)
+		{
+			// Vertex versus vertex.
+			int32 indexA = cache.indexA[0];
+			int32 indexB = cache.indexB[0];
+
+			manifold->type = b2Manifold::e_circles;
+			manifold->localPoint = hullA.vertices[indexA];
+			manifold->localNormal.SetZero();
+			manifold->pointCount = 1;
+
+			b2ManifoldPoint* cp = manifold->points + 0;
+			cp->localPoint = hullB.vertices[indexB];
+			cp->id.cf.indexA = (uint8)indexA;
+			cp->id.cf.indexB = (uint8)indexB;
+			cp->id.cf.typeA = b2ContactFeature::e_vertex;
+			cp->id.cf.typeB = b2ContactFeature::e_vertex;
+			return;
+		}
+	}
+
+	const b2RoundedHull* hull1;	// reference hull
+	const b2RoundedHull* hull2;	// incident hull
+	b2Transform xf1, xf2;
+	int32 edge1;				// reference edge
+	uint8 flip;
+
+	if (separationB > separationA + k_tol)
+	{
+		hull1 = &hullB;
+		hull2 = &hullA;
+		xf1 = xfB;
+		xf2 = xfA;
+		edge1 = edgeB;
+		manifold->type = b2Manifold::e_faceB;
+		flip = 1;
+	}
+	else
+	{
+		hull1 = &hullA;
+		hull2 = &hullB;
+		xf1 = xfA;
+		xf2 = xfB;
+		edge1 = edgeA;
+		manifold->type = b2Manifold::e_faceA;
+		flip = 0;
+	}
+
+	b2ClipVertex incidentEdge[2];
+	b2FindIncidentHullEdge(incidentEdge, *hull1, xf1, edge1, *hull2, xf2);
+
+	int32 iv1 = edge1;
+	int32 iv2 = edge1 + 1 < hull1->count ? edge1 + 1 : 0;
+
+	b2Vec2 v11 = hull1->vertices[iv1];
+	b2Vec2 v12 = hull1->vertices[iv2];
+
+	b2Vec2 localTangent = v12 - v11;
+	localTangent.Normalize();
+
+	b2Vec2 localNormal = b2Cross(localTangent, 1.0f);
+	b2Vec2 planePoint = 0.5f * (v11 + v12);
+
+	b2Vec2 tangent = b2Mul(xf1.q, localTangent);
+	b2Vec2 normal = b2Cross(tangent, 1.0f);
+
+	v11 = b2Mul(xf1, v11);
+	v12 = b2Mul(xf1, v12);
+
+	// Face offset.
+	float32 frontOffset = b2Dot(normal, v11);
+
+	// Side offsets. Rounded ends are covered by the closest feature cases, so the
+	// sides are only extended by the linear slop.
+	float32 sideOffset1 = -b2Dot(tangent, v11) + b2_linearSlop;
+	float32 sideOffset2 = b2Dot(tangent, v12) + b2_linearSlop;
+
+	// Clip incident edge against extruded edge1 side edges.
+	b2ClipVertex clipPoints1[2];
+	b2ClipVertex clipPoints2[2];
+	int32 np;
+
+	np = b2ClipSegmentToLine(clipPoints1, incidentEdge, -tangent, sideOffset1, iv1);
+	if (np < 2)
+	{
+		b2CollideClosestFeatures(manifold, hullA, xfA, hullB, xfB);
+		return;
+	}
+
+	np = b2ClipSegmentToLine(clipPoints2, clipPoints1, tangent, sideOffset2, iv2);
+	if (np < 2)
+	{
+		b2CollideClosestFeatures(manifold, hullA, xfA, hullB, xfB);
+		return;
+	}
+
+	manifold->localNormal = localNormal;
+	manifold->localPoint = planePoint;
+
+	int32 pointCount = 0;
+	for (int32 i = 0; i < b2_maxManifoldPoints; ++i)
+	{
+		float32 s = b2Dot(normal, clipPoints2[i].v) - frontOffset;
+
+		if (s <= totalRadius)
+		{
+			b2ManifoldPoint* cp = manifold->points + pointCount;
+			cp->localPoint = b2MulT(xf2, clipPoints2[i].v);
+			cp->id = clipPoints2[i].id;
+			if (flip)
+			{
+				// Swap features
+				b2ContactFeature cf = cp->id.cf;
+				cp->id.cf.indexA = cf.indexB;
+				cp->id.cf.indexB = cf.indexA;
+				cp->id.cf.typeA = cf.typeB;
+				cp->id.cf.typeB = cf.typeA;
+			}
+			++pointCount;
+		}
+	}
+
+	manifold->pointCount = pointCount;
+}
+
+void b2CollideCapsules(b2Manifold* manifold,
+					   const b2CapsuleShape* capsuleA, const b2Transform& xfA,
+					   const b2CapsuleShape* capsuleB, const b2Transform& xfB)
+{
+	b2RoundedHull hullA, hullB;
+	hullA.Set(capsuleA->m_vertex1, capsuleA->m_vertex2, capsuleA->m_radius);
+	hullB.Set(capsuleB->m_vertex1, capsuleB->m_vertex2, capsuleB->m_radius);
+	b2CollideHulls(manifold, hullA, xfA, hullB, xfB);
+}
+
+void b2CollideCapsuleAndCircle(b2Manifold* manifold,
+							   const b2CapsuleShape* capsuleA, const b2Transform& xfA,
+							   const b2CircleShape* circleB, const b2Transform& xfB)
+{
+	manifold->pointCount = 0;
+
+	// Compute circle in frame of capsule
+	b2Vec2 Q = b2MulT(xfA, b2Mul(xfB, circleB->m_p));
+
+	// Closest point on the segment
+	b2Vec2 A = capsuleA->m_vertex1, B = capsuleA->m_vertex2;
+	b2Vec2 e = B - A;
+	float32 t = b2Clamp(b2Dot(Q - A, e) / b2Dot(e, e), 0.0f, 1.0f);
+	b2Vec2 P = A + t * e;
+
+	float32 radius = capsuleA->m_radius + circleB->m_radius;
+	if (b2DistanceSquared(P, Q) > radius * radius)
+	{
+		return;
+	}
+
+	manifold->type = b2Manifold::e_circles;
+	manifold->localPoint = P;
+	manifold->localNormal.SetZero();
+	manifold->pointCount = 1;
+
+	manifold->points[0].localPoint = circleB->m_p;
+	manifold->points[0].id.key = 0;
+}
+
+void b2CollidePolygonAndCapsule(b2Manifold* manifold,
+								const b2PolygonShape* polygonA, const b2Transform& xfA,
+								const b2CapsuleShape* capsuleB, const b2Transform& xfB)
+{
+	b2RoundedHull hullA, hullB;
+	hullA.Set(polygonA);
+	hullB.Set(capsuleB->m_vertex1, capsuleB->m_vertex2, capsuleB->m_radius);
+	b2CollideHulls(manifold, hullA, xfA, hullB, xfB);
+}
+
+// The edge is a hull of two vertices. A vertex contact at an end of the edge that
+// lies in the region of an adjacent edge is left to that edge, as in
+// b2CollideEdgeAndCircle.
+void b2CollideEdgeAndCapsule(b2Manifold* manifold,
+							 const b2EdgeShape* edgeA, const b2Transform& xfA,
+							 const b2CapsuleShape* capsuleB, const b2Transform& xfB)
+{
+	b2RoundedHull hullA, hullB;
+	hullA.Set(edgeA->m_vertex1, edgeA->m_vertex2, edgeA->m_radius);
+	hullB.Set(capsuleB->m_vertex1, capsuleB->m_vertex2, capsuleB->m_radius);
+	b2CollideHulls(manifold, hullA, xfA, hullB, xfB);
+
+	if (manifold->pointCount == 0 || manifold->type != b2Manifold::e_circles)
+	{
+		return;
+	}
+
+	// Capsule vertex in the frame of the edge.
+	b2Vec2 Q = b2MulT(xfA, b2Mul(xfB, manifold->points[0].localPoint));
+
+	if (edgeA->m_hasVertex0 && manifold->points[0].id.cf.indexA == 0)
+	{
+		b2Vec2 e1 = edgeA->m_vertex1 - edgeA->m_vertex0;
+		if (b2Dot(e1, edgeA->m_vertex1 - Q) > 0.0f)
+		{
+			manifold->pointCount = 0;
+			return;
+		}
+	}
+
+	if (edgeA->m_hasVertex3 && manifold->points[0].id.cf.indexA == 1)
+	{
+		b2Vec2 e2 = edgeA->m_vertex3 - edgeA->m_vertex2;
+		if (b2Dot(e2, Q - edgeA->m_vertex2) > 0.0f)
+		{
+			manifold->pointCount = 0;
+			return;
+		}
+	}
+}
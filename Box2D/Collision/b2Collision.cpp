@@ -18,6 +18,9 @@
 
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Collision/b2Distance.h>
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2CompoundShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
 
 void b2WorldManifold::Initialize(const b2Manifold* manifold,
 						  const b2Transform& xfA, float32 radiusA,
@@ -230,10 +233,108 @@ int32 b2ClipSegmentToLine(b2ClipVertex vOut[2], const b2ClipVertex vIn[2],
 	return numOut;
 }
 
+// Get the tree of a shape that has many primitives under a single child. This is
+// a compound or a chain with a tree.
+static const b2StaticTree* b2GetPrimitiveTree(const b2Shape* shape)
+{
+	if (shape->GetType() == b2Shape::e_compound)
+	{
+		return &((const b2CompoundShape*)shape)->m_tree;
+	}
+
+	if (shape->GetType() == b2Shape::e_chain && ((const b2ChainShape*)shape)->HasTree())
+	{
+		return &((const b2ChainShape*)shape)->m_tree;
+	}
+
+	return NULL;
+}
+
+// Tests the primitives near a shape until one overlaps.
+struct b2PrimitiveOverlapCallback
+{
+	bool QueryCallback(int32 primitive)
+	{
+		if (treeShape->GetType() == b2Shape::e_compound)
+		{
+			const b2PolygonShape* polygon = ((const b2CompoundShape*)treeShape)->GetShape(primitive);
+			overlap = b2TestOverlap(polygon, 0, shape, index, *xfTree, *xfShape);
+		}
+		else
+		{
+			b2EdgeShape edgeShape;
+			((const b2ChainShape*)treeShape)->GetChildEdge(&edgeShape, primitive);
+			overlap = b2TestOverlap(&edgeShape, 0, shape, index, *xfTree, *xfShape);
+		}
+
+		return overlap == false;
+	}
+
+	const b2Shape* treeShape;
+	const b2Shape* shape;
+	int32 index;
+	const b2Transform* xfTree;
+	const b2Transform* xfShape;
+	bool overlap;
+};
+
+// A shape with a primitive tree is a single child, so test the primitives near the
+// other shape. The other shape may have a tree too.
+static bool b2TestTreeOverlap(const b2Shape* treeShape, const b2StaticTree* tree,
+								const b2Shape* shape, int32 index,
+								const b2Transform& xfTree, const b2Transform& xfShape)
+{
+	b2PrimitiveOverlapCallback callback;
+	callback.treeShape = treeShape;
+	callback.shape = shape;
+	callback.index = index;
+	callback.xfTree = &xfTree;
+	callback.xfShape = &xfShape;
+	callback.overlap = false;
+
+	b2AABB aabb;
+	shape->ComputeAABB(&aabb, b2MulT(xfTree, xfShape), index);
+
+	// Edge bounds leave out the radius.
+	if (shape->GetType() == b2Shape::e_edge || shape->GetType() == b2Shape::e_chain)
+	{
+		b2Vec2 r(shape->m_radius, shape->m_radius);
+		aabb.lowerBound -= r;
+		aabb.upperBound += r;
+	}
+
+	tree->Query(&callback, aabb);
+
+	return callback.overlap;
+}
+
 bool b2TestOverlap(	const b2Shape* shapeA, int32 indexA,
 					const b2Shape* shapeB, int32 indexB,
 					const b2Transform& xfA, const b2Transform& xfB)
 {
+	b2SimplexCache cache;
+	cache.count = 0;
+
+	return b2TestOverlap(shapeA, indexA, shapeB, indexB, xfA, xfB, &cache);
+}
+
+bool b2TestOverlap(	const b2Shape* shapeA, int32 indexA,
+					const b2Shape* shapeB, int32 indexB,
+					const b2Transform& xfA, const b2Transform& xfB,
+					b2SimplexCache* cache)
+{
+	const b2StaticTree* treeA = b2GetPrimitiveTree(shapeA);
+	if (treeA)
+	{
+		return b2TestTreeOverlap(shapeA, treeA, shapeB, indexB, xfA, xfB);
+	}
+
+	const b2StaticTree* treeB = b2GetPrimitiveTree(shapeB);
+	if (treeB)
+	{
+		return b2TestTreeOverlap(shapeB, treeB, shapeA, indexA, xfB, xfA);
+	}
+
 	b2DistanceInput input;
 	input.proxyA.Set(shapeA, indexA);
 	input.proxyB.Set(shapeB, indexB);
@@ -241,12 +342,9 @@ bool b2TestOverlap(	const b2Shape* shapeA, int32 indexA,
 	input.transformB = xfB;
 	input.useRadii = true;
 
-	b2SimplexCache cache;
-	cache.count = 0;
-
 	b2DistanceOutput output;
 
-	b2Distance(&output, &cache, &input);
+	b2Distance(&output, cache, &input);
 
 	return output.distance < 10.0f * b2_epsilon;
 }
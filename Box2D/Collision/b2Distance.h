@@ -90,6 +90,12 @@ void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache, 
 				const b2DistanceInput* input);
 
+/// GJK statistics, accumulated over the calls to b2Distance made on this thread.
+/// A world steps on the calling thread, so the difference over a step counts that
+/// world alone. The counts wrap around.
+extern thread_local uint32 b2_gjkCalls, b2_gjkIters;
+extern thread_local int32 b2_gjkMaxIters;
+
 
 //////////////////////////////////////////////////////////////////////////
 
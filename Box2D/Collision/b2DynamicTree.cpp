@@ -17,15 +17,20 @@
 */
 
 #include <Box2D/Collision/b2DynamicTree.h>
+#include <Box2D/Common/b2AllocatorInterface.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <memory.h>
+#include <algorithm>
 
-b2DynamicTree::b2DynamicTree()
+b2DynamicTree::b2DynamicTree(b2AllocatorInterface* allocator)
 {
+	m_memory = allocator ? allocator : b2GetDefaultAllocator();
+
 	m_root = b2_nullNode;
 
 	m_nodeCapacity = 16;
 	m_nodeCount = 0;
-	m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+	m_nodes = (b2TreeNode*)m_memory->Allocate(m_nodeCapacity * sizeof(b2TreeNode));
 	memset(m_nodes, 0, m_nodeCapacity * sizeof(b2TreeNode));
 
 	// Build a linked list for the free list.
@@ -46,7 +51,7 @@ b2DynamicTree::b2DynamicTree()
 b2DynamicTree::~b2DynamicTree()
 {
 	// This frees the entire tree in one shot.
-	b2Free(m_nodes);
+	m_memory->Free(m_nodes);
 }
 
 // Allocate a node from the pool. Grow the pool if necessary.
@@ -60,9 +65,9 @@ int32 b2DynamicTree::AllocateNode()
 		// The free list is empty. Rebuild a bigger pool.
 		b2TreeNode* oldNodes = m_nodes;
 		m_nodeCapacity *= 2;
-		m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+		m_nodes = (b2TreeNode*)m_memory->Allocate(m_nodeCapacity * sizeof(b2TreeNode));
 		memcpy(m_nodes, oldNodes, m_nodeCount * sizeof(b2TreeNode));
-		b2Free(oldNodes);
+		m_memory->Free(oldNodes);
 
 		// Build a linked list for the free list. The parent
 		// pointer becomes the "next" pointer.
@@ -127,6 +132,133 @@ void b2DynamicTree::DestroyProxy(int32 proxyId)
 	FreeNode(proxyId);
 }
 
+void b2DynamicTree::CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds)
+{
+	int32 leafCount = m_root == b2_nullNode ? 0 : (m_nodeCount + 1) / 2;
+
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 proxyId = AllocateNode();
+		m_nodes[proxyId].aabb.lowerBound = aabbs[i].lowerBound - r;
+		m_nodes[proxyId].aabb.upperBound = aabbs[i].upperBound + r;
+		m_nodes[proxyId].userData = userData[i];
+		m_nodes[proxyId].height = 0;
+		proxyIds[i] = proxyId;
+	}
+
+	if (count < leafCount)
+	{
+		for (int32 i = 0; i < count; ++i)
+		{
+			InsertLeaf(proxyIds[i]);
+		}
+		return;
+	}
+
+	RebuildTopDown();
+}
+
+void b2DynamicTree::DestroyProxies(const int32* proxyIds, int32 count)
+{
+	int32 leafCount = m_root == b2_nullNode ? 0 : (m_nodeCount + 1) / 2;
+	if (4 * count < leafCount)
+	{
+		for (int32 i = 0; i < count; ++i)
+		{
+			DestroyProxy(proxyIds[i]);
+		}
+		return;
+	}
+
+	// The internal nodes are discarded by the rebuild, so the leaves are freed
+	// without detaching them.
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Assert(0 <= proxyIds[i] && proxyIds[i] < m_nodeCapacity);
+		b2Assert(m_nodes[proxyIds[i]].IsLeaf());
+		FreeNode(proxyIds[i]);
+	}
+
+	RebuildTopDown();
+}
+
+void b2DynamicTree::Clear()
+{
+	for (int32 i = 0; i < m_nodeCapacity - 1; ++i)
+	{
+		m_nodes[i].next = i + 1;
+		m_nodes[i].height = -1;
+	}
+	m_nodes[m_nodeCapacity-1].next = b2_nullNode;
+	m_nodes[m_nodeCapacity-1].height = -1;
+	m_freeList = 0;
+
+	m_root = b2_nullNode;
+	m_nodeCount = 0;
+	m_path = 0;
+	m_insertionCount = 0;
+}
+
+void b2DynamicTree::SaveState(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_root);
+	snapshot->Write(m_nodeCount);
+	snapshot->Write(m_nodeCapacity);
+	snapshot->Write(m_freeList);
+	snapshot->Write(m_path);
+	snapshot->Write(m_insertionCount);
+	snapshot->Write(m_nodes, m_nodeCapacity * sizeof(b2TreeNode));
+}
+
+void b2DynamicTree::RestoreState(b2SnapshotReader* reader)
+{
+	m_root = reader->Read<int32>();
+	m_nodeCount = reader->Read<int32>();
+	int32 capacity = reader->Read<int32>();
+	m_freeList = reader->Read<int32>();
+	m_path = reader->Read<uint32>();
+	m_insertionCount = reader->Read<int32>();
+
+	if (m_nodeCapacity < capacity)
+	{
+		m_memory->Free(m_nodes);
+		m_nodeCapacity = capacity;
+		m_nodes = (b2TreeNode*)m_memory->Allocate(m_nodeCapacity * sizeof(b2TreeNode));
+	}
+
+	reader->Read(m_nodes, capacity * sizeof(b2TreeNode));
+
+	if (m_nodeCapacity == capacity)
+	{
+		return;
+	}
+
+	// The pool has grown since the state was saved. Put the extra nodes at the end
+	// of the free list in the order the smaller pool would have added them.
+	for (int32 i = capacity; i < m_nodeCapacity - 1; ++i)
+	{
+		m_nodes[i].next = i + 1;
+		m_nodes[i].height = -1;
+	}
+	m_nodes[m_nodeCapacity-1].next = b2_nullNode;
+	m_nodes[m_nodeCapacity-1].height = -1;
+
+	if (m_freeList == b2_nullNode)
+	{
+		m_freeList = capacity;
+	}
+	else
+	{
+		int32 tail = m_freeList;
+		while (m_nodes[tail].next != b2_nullNode)
+		{
+			tail = m_nodes[tail].next;
+		}
+		m_nodes[tail].next = capacity;
+	}
+}
+
 bool b2DynamicTree::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
 {
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
@@ -693,7 +825,7 @@ int32 b2DynamicTree::GetMaxBalance() const
 
 void b2DynamicTree::RebuildBottomUp()
 {
-	int32* nodes = (int32*)b2Alloc(m_nodeCount * sizeof(int32));
+	int32* nodes = (int32*)m_memory->Allocate(m_nodeCount * sizeof(int32));
 	int32 count = 0;
 
 	// Build array of leaves. Free the rest.
@@ -762,11 +894,109 @@ void b2DynamicTree::RebuildBottomUp()
 	}
 
 	m_root = nodes[0];
-	b2Free(nodes);
+	m_memory->Free(nodes);
 
 	Validate();
 }
 
+// Orders leaves by the center of their AABB along one axis.
+struct b2CenterLess
+{
+	bool operator()(int32 a, int32 b) const
+	{
+		const b2AABB& aabbA = nodes[a].aabb;
+		const b2AABB& aabbB = nodes[b].aabb;
+		if (axis == 0)
+		{
+			return aabbA.lowerBound.x + aabbA.upperBound.x < aabbB.lowerBound.x + aabbB.upperBound.x;
+		}
+		return aabbA.lowerBound.y + aabbA.upperBound.y < aabbB.lowerBound.y + aabbB.upperBound.y;
+	}
+
+	const b2TreeNode* nodes;
+	int32 axis;
+};
+
+void b2DynamicTree::RebuildTopDown()
+{
+	if (m_nodeCount == 0)
+	{
+		m_root = b2_nullNode;
+		return;
+	}
+
+	int32* leaves = (int32*)m_memory->Allocate(m_nodeCount * sizeof(int32));
+	int32 count = 0;
+
+	// Build array of leaves. Free the rest.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].height < 0)
+		{
+			// free node in pool
+			continue;
+		}
+
+		if (m_nodes[i].IsLeaf())
+		{
+			m_nodes[i].parent = b2_nullNode;
+			leaves[count] = i;
+			++count;
+		}
+		else
+		{
+			FreeNode(i);
+		}
+	}
+
+	m_root = count > 0 ? BuildTopDown(leaves, count) : b2_nullNode;
+	m_memory->Free(leaves);
+}
+
+int32 b2DynamicTree::BuildTopDown(int32* leaves, int32 count)
+{
+	if (count == 1)
+	{
+		return leaves[0];
+	}
+
+	// Split along the longest axis of the leaf centers.
+	b2Vec2 lower = m_nodes[leaves[0]].aabb.GetCenter();
+	b2Vec2 upper = lower;
+	for (int32 i = 1; i < count; ++i)
+	{
+		b2Vec2 c = m_nodes[leaves[i]].aabb.GetCenter();
+		lower = b2Min(lower, c);
+		upper = b2Max(upper, c);
+	}
+
+	b2CenterLess less;
+	less.nodes = m_nodes;
+	less.axis = upper.x - lower.x >= upper.y - lower.y ? 0 : 1;
+
+	int32 half = count / 2;
+	std::nth_element(leaves, leaves + half, leaves + count, less);
+
+	int32 index1 = BuildTopDown(leaves, half);
+	int32 index2 = BuildTopDown(leaves + half, count - half);
+
+	// The pool may grow here, so the node pointers are taken afterwards.
+	int32 parentIndex = AllocateNode();
+	b2TreeNode* parent = m_nodes + parentIndex;
+	b2TreeNode* child1 = m_nodes + index1;
+	b2TreeNode* child2 = m_nodes + index2;
+	parent->child1 = index1;
+	parent->child2 = index2;
+	parent->height = 1 + b2Max(child1->height, child2->height);
+	parent->aabb.Combine(child1->aabb, child2->aabb);
+	parent->parent = b2_nullNode;
+
+	child1->parent = parentIndex;
+	child2->parent = parentIndex;
+
+	return parentIndex;
+}
+
 void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	// Build array of leaves. Free the rest.
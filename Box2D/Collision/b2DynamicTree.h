@@ -22,6 +22,10 @@
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Common/b2GrowableStack.h>
 
+class b2AllocatorInterface;
+class b2Snapshot;
+class b2SnapshotReader;
+
 #define b2_nullNode (-1)
 
 /// A node in the dynamic tree. The client does not interact with this directly.
@@ -62,7 +66,8 @@ class b2DynamicTree
 {
 public:
 	/// Constructing the tree initializes the node pool.
-	b2DynamicTree();
+	/// @param allocator the source of the node pool, or NULL for the default allocator
+	b2DynamicTree(b2AllocatorInterface* allocator = NULL);
 
 	/// Destroy the tree, freeing the node pool.
 	~b2DynamicTree();
@@ -73,6 +78,25 @@ public:
 	/// Destroy a proxy. This asserts if the id is invalid.
 	void DestroyProxy(int32 proxyId);
 
+	/// Create a batch of proxies. A batch at least as large as the tree is built
+	/// top-down together with the existing proxies instead of inserting each leaf.
+	/// @param proxyIds receives the id of each proxy
+	void CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds);
+
+	/// Destroy a batch of proxies. If this removes at least a quarter of the proxies the
+	/// rest are rebuilt top-down instead of removing each leaf.
+	void DestroyProxies(const int32* proxyIds, int32 count);
+
+	/// Destroy all the proxies. The node pool keeps its capacity.
+	void Clear();
+
+	/// Write the nodes and the free list to a snapshot.
+	void SaveState(b2Snapshot* snapshot) const;
+
+	/// Read the nodes and the free list back from a snapshot. The proxy ids are the
+	/// same as when the state was saved.
+	void RestoreState(b2SnapshotReader* reader);
+
 	/// Move a proxy with a swepted AABB. If the proxy has moved outside of its fattened AABB,
 	/// then the proxy is removed from the tree and re-inserted. Otherwise
 	/// the function returns immediately.
@@ -133,12 +157,18 @@ private:
 
 	int32 Balance(int32 index);
 
+	// Rebuild the tree over its leaves by splitting at the median center.
+	void RebuildTopDown();
+	int32 BuildTopDown(int32* leaves, int32 count);
+
 	int32 ComputeHeight() const;
 	int32 ComputeHeight(int32 nodeId) const;
 
 	void ValidateStructure(int32 index) const;
 	void ValidateMetrics(int32 index) const;
 
+	b2AllocatorInterface* m_memory;
+
 	int32 m_root;
 
 	b2TreeNode* m_nodes;
@@ -0,0 +1,130 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Collision/b2StaticTree.h>
+#include <memory.h>
+#include <algorithm>
+
+b2StaticTree::b2StaticTree()
+{
+	m_nodes = NULL;
+	m_nodeCount = 0;
+}
+
+b2StaticTree::~b2StaticTree()
+{
+	b2Free(m_nodes);
+}
+
+// Orders boxes by their center along an axis.
+struct b2BoxCenterLess
+{
+	b2BoxCenterLess(const b2AABB* aabbs, int32 axis) : aabbs(aabbs), axis(axis) {}
+
+	bool operator()(int32 a, int32 b) const
+	{
+		const b2AABB& aabbA = aabbs[a];
+		const b2AABB& aabbB = aabbs[b];
+		if (axis == 0)
+		{
+			return aabbA.lowerBound.x + aabbA.upperBound.x < aabbB.lowerBound.x + aabbB.upperBound.x;
+		}
+		return aabbA.lowerBound.y + aabbA.upperBound.y < aabbB.lowerBound.y + aabbB.upperBound.y;
+	}
+
+	const b2AABB* aabbs;
+	int32 axis;
+};
+
+// Build the subtree for a range of boxes by splitting at the median box center along
+// the longest axis. Returns the index of the subtree root.
+static int32 b2BuildStaticNode(b2StaticTreeNode* nodes, int32* nodeCount, const b2AABB* aabbs, int32* indices, int32 count)
+{
+	int32 nodeId = *nodeCount;
+	++(*nodeCount);
+
+	b2StaticTreeNode* node = nodes + nodeId;
+
+	if (count == 1)
+	{
+		node->aabb = aabbs[indices[0]];
+		node->child1 = -1;
+		node->child2 = -1;
+		node->index = indices[0];
+		return nodeId;
+	}
+
+	b2AABB aabb = aabbs[indices[0]];
+	b2Vec2 lower = aabb.GetCenter();
+	b2Vec2 upper = lower;
+	for (int32 i = 1; i < count; ++i)
+	{
+		aabb.Combine(aabbs[indices[i]]);
+		b2Vec2 center = aabbs[indices[i]].GetCenter();
+		lower = b2Min(lower, center);
+		upper = b2Max(upper, center);
+	}
+
+	int32 axis = upper.x - lower.x > upper.y - lower.y ? 0 : 1;
+	int32 half = count / 2;
+	std::nth_element(indices, indices + half, indices + count, b2BoxCenterLess(aabbs, axis));
+
+	node->aabb = aabb;
+	node->index = -1;
+
+	int32 child1 = b2BuildStaticNode(nodes, nodeCount, aabbs, indices, half);
+	int32 child2 = b2BuildStaticNode(nodes, nodeCount, aabbs, indices + half, count - half);
+
+	nodes[nodeId].child1 = child1;
+	nodes[nodeId].child2 = child2;
+	return nodeId;
+}
+
+void b2StaticTree::Build(const b2AABB* aabbs, int32 count)
+{
+	b2Assert(m_nodes == NULL);
+	b2Assert(count > 0);
+
+	int32* indices = (int32*)b2Alloc(count * sizeof(int32));
+	for (int32 i = 0; i < count; ++i)
+	{
+		indices[i] = i;
+	}
+
+	m_nodes = (b2StaticTreeNode*)b2Alloc((2 * count - 1) * sizeof(b2StaticTreeNode));
+	m_nodeCount = 0;
+	b2BuildStaticNode(m_nodes, &m_nodeCount, aabbs, indices, count);
+	b2Assert(m_nodeCount == 2 * count - 1);
+
+	b2Free(indices);
+}
+
+void b2StaticTree::Copy(const b2StaticTree& tree)
+{
+	b2Assert(m_nodes == NULL);
+
+	if (tree.m_nodes == NULL)
+	{
+		return;
+	}
+
+	m_nodeCount = tree.m_nodeCount;
+	m_nodes = (b2StaticTreeNode*)b2Alloc(m_nodeCount * sizeof(b2StaticTreeNode));
+	memcpy(m_nodes, tree.m_nodes, m_nodeCount * sizeof(b2StaticTreeNode));
+}
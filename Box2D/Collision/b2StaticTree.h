@@ -0,0 +1,207 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_STATIC_TREE_H
+#define B2_STATIC_TREE_H
+
+#include <Box2D/Collision/b2Collision.h>
+#include <Box2D/Common/b2GrowableStack.h>
+
+/// A node in the static tree.
+struct b2StaticTreeNode
+{
+	bool IsLeaf() const
+	{
+		return child1 == -1;
+	}
+
+	/// Bounds of the boxes below this node.
+	b2AABB aabb;
+
+	int32 child1;
+	int32 child2;
+
+	/// The box index of a leaf.
+	int32 index;
+};
+
+/// A bounding volume tree over a fixed set of boxes. Shapes that group many primitives
+/// under one broad-phase proxy use this to find the primitives near a query. Unlike
+/// b2DynamicTree it is built once, top down, and the boxes are not enlarged.
+class b2StaticTree
+{
+public:
+
+	/// Construct an empty tree.
+	b2StaticTree();
+
+	/// Destroy the tree, freeing the nodes.
+	~b2StaticTree();
+
+	/// Build the tree. Leaves report the array index of their box.
+	void Build(const b2AABB* aabbs, int32 count);
+
+	/// Copy a tree into this empty tree.
+	void Copy(const b2StaticTree& tree);
+
+	/// Has the tree been built?
+	bool IsEmpty() const;
+
+	/// Get the bounds of all boxes.
+	const b2AABB& GetAABB() const;
+
+	/// Query the boxes that overlap the supplied AABB. The callback receives box
+	/// indices, see b2DynamicTree::Query.
+	template <typename T>
+	void Query(T* callback, const b2AABB& aabb) const;
+
+	/// Ray-cast against the boxes. The callback receives box indices and returns the
+	/// new max fraction, see b2DynamicTree::RayCast.
+	template <typename T>
+	void RayCast(T* callback, const b2RayCastInput& input) const;
+
+	/// The nodes, the root is the first node.
+	b2StaticTreeNode* m_nodes;
+	int32 m_nodeCount;
+};
+
+inline bool b2StaticTree::IsEmpty() const
+{
+	return m_nodes == NULL;
+}
+
+inline const b2AABB& b2StaticTree::GetAABB() const
+{
+	b2Assert(m_nodes != NULL);
+	return m_nodes[0].aabb;
+}
+
+template <typename T>
+inline void b2StaticTree::Query(T* callback, const b2AABB& aabb) const
+{
+	b2Assert(m_nodes != NULL);
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(0);
+
+	while (stack.GetCount() > 0)
+	{
+		int32 nodeId = stack.Pop();
+		const b2StaticTreeNode* node = m_nodes + nodeId;
+
+		if (b2TestOverlap(node->aabb, aabb))
+		{
+			if (node->IsLeaf())
+			{
+				bool proceed = callback->QueryCallback(node->index);
+				if (proceed == false)
+				{
+					return;
+				}
+			}
+			else
+			{
+				stack.Push(node->child1);
+				stack.Push(node->child2);
+			}
+		}
+	}
+}
+
+template <typename T>
+inline void b2StaticTree::RayCast(T* callback, const b2RayCastInput& input) const
+{
+	b2Assert(m_nodes != NULL);
+
+	b2Vec2 p1 = input.p1;
+	b2Vec2 p2 = input.p2;
+	b2Vec2 r = p2 - p1;
+	b2Assert(r.LengthSquared() > 0.0f);
+	r.Normalize();
+
+	// v is perpendicular to the segment.
+	b2Vec2 v = b2Cross(1.0f, r);
+	b2Vec2 abs_v = b2Abs(v);
+
+	float32 maxFraction = input.maxFraction;
+
+	// Build a bounding box for the segment.
+	b2AABB segmentAABB;
+	{
+		b2Vec2 t = p1 + maxFraction * (p2 - p1);
+		segmentAABB.lowerBound = b2Min(p1, t);
+		segmentAABB.upperBound = b2Max(p1, t);
+	}
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(0);
+
+	while (stack.GetCount() > 0)
+	{
+		int32 nodeId = stack.Pop();
+		const b2StaticTreeNode* node = m_nodes + nodeId;
+
+		if (b2TestOverlap(node->aabb, segmentAABB) == false)
+		{
+			continue;
+		}
+
+		// Separating axis for segment (Gino, p80).
+		// |dot(v, p1 - c)| > dot(|v|, h)
+		b2Vec2 c = node->aabb.GetCenter();
+		b2Vec2 h = node->aabb.GetExtents();
+		float32 separation = b2Abs(b2Dot(v, p1 - c)) - b2Dot(abs_v, h);
+		if (separation > 0.0f)
+		{
+			continue;
+		}
+
+		if (node->IsLeaf())
+		{
+			b2RayCastInput subInput;
+			subInput.p1 = input.p1;
+			subInput.p2 = input.p2;
+			subInput.maxFraction = maxFraction;
+
+			float32 value = callback->RayCastCallback(subInput, node->index);
+
+			if (value == 0.0f)
+			{
+				// The client has terminated the ray cast.
+				return;
+			}
+
+			if (value > 0.0f)
+			{
+				// Update segment bounding box.
+				maxFraction = value;
+				b2Vec2 t = p1 + maxFraction * (p2 - p1);
+				segmentAABB.lowerBound = b2Min(p1, t);
+				segmentAABB.upperBound = b2Max(p1, t);
+			}
+		}
+		else
+		{
+			stack.Push(node->child1);
+			stack.Push(node->child2);
+		}
+	}
+}
+
+#endif
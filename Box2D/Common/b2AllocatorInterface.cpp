@@ -0,0 +1,239 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Common/b2AllocatorInterface.h>
+#include <Box2D/Common/b2Math.h>
+#include <memory.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+// Each block of the counting allocator starts with this header. It is 16 bytes so
+// that the memory after it keeps the alignment of the base allocator.
+struct b2AllocationHeader
+{
+	int32 size;
+	int32 padding[3];
+};
+
+void* b2DefaultAllocator::Allocate(int32 size)
+{
+	return b2Alloc(size);
+}
+
+void b2DefaultAllocator::Free(void* mem)
+{
+	b2Free(mem);
+}
+
+b2AllocatorInterface* b2GetDefaultAllocator()
+{
+	static b2DefaultAllocator s_defaultAllocator;
+	return &s_defaultAllocator;
+}
+
+b2CountingAllocator::b2CountingAllocator(b2AllocatorInterface* base)
+{
+	m_base = base ? base : b2GetDefaultAllocator();
+	m_allocationCount = 0;
+	m_liveCount = 0;
+	m_liveBytes = 0;
+	m_peakBytes = 0;
+}
+
+void* b2CountingAllocator::Allocate(int32 size)
+{
+	b2AllocationHeader* header = (b2AllocationHeader*)m_base->Allocate(size + int32(sizeof(b2AllocationHeader)));
+	header->size = size;
+
+	m_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	m_liveCount.fetch_add(1, std::memory_order_relaxed);
+	int32 liveBytes = m_liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+	int32 peakBytes = m_peakBytes.load(std::memory_order_relaxed);
+	while (liveBytes > peakBytes && m_peakBytes.compare_exchange_weak(peakBytes, liveBytes, std::memory_order_relaxed) == false)
+	{
+	}
+
+	return header + 1;
+}
+
+void b2CountingAllocator::Free(void* mem)
+{
+	if (mem == NULL)
+	{
+		return;
+	}
+
+	b2AllocationHeader* header = (b2AllocationHeader*)mem - 1;
+	m_liveCount.fetch_sub(1, std::memory_order_relaxed);
+	m_liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+	m_base->Free(header);
+}
+
+// The arena is cut into pages of this size. Smaller classes share a page, larger
+// classes take several whole pages.
+const int32 b2_arenaPageShift = 16;
+const int32 b2_arenaPageSize = 1 << b2_arenaPageShift;
+
+// The smallest class, 16 bytes, keeps blocks aligned for any type.
+const int32 b2_arenaMinClass = 4;
+
+#if defined(__linux__)
+const int32 b2_hugePageSize = 2 * 1024 * 1024;
+#else
+const int32 b2_hugePageSize = 64 * 1024;
+#endif
+
+b2HugePageArena::b2HugePageArena(int32 capacity, b2AllocatorInterface* fallback)
+{
+	m_fallback = fallback ? fallback : b2GetDefaultAllocator();
+	m_capacity = (capacity + b2_hugePageSize - 1) & ~(b2_hugePageSize - 1);
+	m_offset = 0;
+	m_hugePages = false;
+	m_pageClasses = NULL;
+	memset(m_freeLists, 0, sizeof(m_freeLists));
+	memset(m_classOffsets, 0, sizeof(m_classOffsets));
+	memset(m_classEnds, 0, sizeof(m_classEnds));
+
+#if defined(_WIN32)
+	// Large pages need the lock pages privilege, so fall back to normal pages.
+	SIZE_T largePageSize = GetLargePageMinimum();
+	m_base = NULL;
+	if (largePageSize > 0 && m_capacity % largePageSize == 0)
+	{
+		m_base = (int8*)VirtualAlloc(NULL, m_capacity, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		m_hugePages = m_base != NULL;
+	}
+
+	if (m_base == NULL)
+	{
+		m_base = (int8*)VirtualAlloc(NULL, m_capacity, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	}
+#elif defined(__linux__)
+	void* base = mmap(NULL, m_capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	m_base = base == MAP_FAILED ? NULL : (int8*)base;
+#if defined(MADV_HUGEPAGE)
+	if (m_base)
+	{
+		m_hugePages = madvise(m_base, m_capacity, MADV_HUGEPAGE) == 0;
+	}
+#endif
+#else
+	m_base = (int8*)m_fallback->Allocate(m_capacity);
+#endif
+
+	if (m_base == NULL)
+	{
+		// Everything goes to the fallback allocator.
+		m_capacity = 0;
+		return;
+	}
+
+	m_pageClasses = (uint8*)m_fallback->Allocate(m_capacity >> b2_arenaPageShift);
+}
+
+b2HugePageArena::~b2HugePageArena()
+{
+	if (m_base == NULL)
+	{
+		return;
+	}
+
+	m_fallback->Free(m_pageClasses);
+
+#if defined(_WIN32)
+	VirtualFree(m_base, 0, MEM_RELEASE);
+#elif defined(__linux__)
+	munmap(m_base, m_capacity);
+#else
+	m_fallback->Free(m_base);
+#endif
+}
+
+void* b2HugePageArena::Allocate(int32 size)
+{
+	int32 sizeClass = b2_arenaMinClass;
+	while ((1 << sizeClass) < size && sizeClass < b2_arenaSizeClasses - 1)
+	{
+		++sizeClass;
+	}
+
+	int32 blockSize = 1 << sizeClass;
+	if (blockSize >= size)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (m_freeLists[sizeClass])
+		{
+			void* block = m_freeLists[sizeClass];
+			m_freeLists[sizeClass] = *(void**)block;
+			return block;
+		}
+
+		if (m_classOffsets[sizeClass] == m_classEnds[sizeClass])
+		{
+			// Take whole pages for the class.
+			int32 pageBytes = b2Max(blockSize, b2_arenaPageSize);
+			if (m_capacity - m_offset >= pageBytes)
+			{
+				int32 firstPage = m_offset >> b2_arenaPageShift;
+				int32 pageCount = pageBytes >> b2_arenaPageShift;
+				memset(m_pageClasses + firstPage, sizeClass, pageCount);
+
+				m_classOffsets[sizeClass] = m_offset;
+				m_classEnds[sizeClass] = m_offset + pageBytes;
+				m_offset += pageBytes;
+			}
+		}
+
+		if (m_classOffsets[sizeClass] < m_classEnds[sizeClass])
+		{
+			void* block = m_base + m_classOffsets[sizeClass];
+			m_classOffsets[sizeClass] += blockSize;
+			return block;
+		}
+	}
+
+	return m_fallback->Allocate(size);
+}
+
+void b2HugePageArena::Free(void* mem)
+{
+	if (mem == NULL)
+	{
+		return;
+	}
+
+	// Blocks outside the arena came from the fallback allocator.
+	int8* block = (int8*)mem;
+	if (block < m_base || block >= m_base + m_capacity)
+	{
+		m_fallback->Free(mem);
+		return;
+	}
+
+	int32 sizeClass = m_pageClasses[(block - m_base) >> b2_arenaPageShift];
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	*(void**)mem = m_freeLists[sizeClass];
+	m_freeLists[sizeClass] = mem;
+}
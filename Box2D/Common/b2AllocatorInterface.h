@@ -0,0 +1,127 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_ALLOCATOR_INTERFACE_H
+#define B2_ALLOCATOR_INTERFACE_H
+
+#include <Box2D/Common/b2Settings.h>
+#include <atomic>
+#include <mutex>
+
+/// The source of the memory of a world. A world passes its allocator to its block
+/// allocator, stack allocator, contact manager, broad-phase and dynamic tree, so
+/// each world may use its own arena, NUMA node or tracking.
+/// Allocate must return memory aligned for any type. Both functions may be called
+/// from several threads at once.
+class b2AllocatorInterface
+{
+public:
+	virtual ~b2AllocatorInterface() {}
+
+	/// Allocate memory.
+	virtual void* Allocate(int32 size) = 0;
+
+	/// Free memory returned by Allocate. Freeing NULL does nothing.
+	virtual void Free(void* mem) = 0;
+};
+
+/// Forwards to b2Alloc and b2Free.
+class b2DefaultAllocator : public b2AllocatorInterface
+{
+public:
+	virtual void* Allocate(int32 size);
+	virtual void Free(void* mem);
+};
+
+/// Get the allocator used when none is given.
+b2AllocatorInterface* b2GetDefaultAllocator();
+
+/// Counts the memory that passes through another allocator.
+class b2CountingAllocator : public b2AllocatorInterface
+{
+public:
+	/// @param base the allocator that provides the memory, or NULL for the default
+	explicit b2CountingAllocator(b2AllocatorInterface* base = NULL);
+
+	virtual void* Allocate(int32 size);
+	virtual void Free(void* mem);
+
+	/// Get the number of allocations so far.
+	int32 GetAllocationCount() const { return m_allocationCount.load(std::memory_order_relaxed); }
+
+	/// Get the number of allocations that have not been freed.
+	int32 GetLiveCount() const { return m_liveCount.load(std::memory_order_relaxed); }
+
+	/// Get the number of bytes allocated and not yet freed.
+	int32 GetLiveBytes() const { return m_liveBytes.load(std::memory_order_relaxed); }
+
+	/// Get the largest number of live bytes seen.
+	int32 GetPeakBytes() const { return m_peakBytes.load(std::memory_order_relaxed); }
+
+private:
+	b2AllocatorInterface* m_base;
+	std::atomic<int32> m_allocationCount;
+	std::atomic<int32> m_liveCount;
+	std::atomic<int32> m_liveBytes;
+	std::atomic<int32> m_peakBytes;
+};
+
+/// The number of size classes of b2HugePageArena. Class i holds blocks of 2^i bytes.
+const int32 b2_arenaSizeClasses = 31;
+
+/// An arena reserved up front, backed by huge pages where the platform allows it.
+/// This cuts TLB misses when a large world walks its contacts and tree nodes.
+/// Blocks are rounded up to a power of two and recycled per size. The arena is cut
+/// into pages that each hold one size class, and the class of each page is kept in
+/// a side table, so blocks carry no header and a power of two fits its class. Once
+/// the arena is full, further allocations go to the fallback allocator.
+class b2HugePageArena : public b2AllocatorInterface
+{
+public:
+	/// @param capacity the number of bytes to reserve, rounded up to whole huge pages
+	/// @param fallback the allocator used once the arena is full, or NULL for the default
+	b2HugePageArena(int32 capacity, b2AllocatorInterface* fallback = NULL);
+	~b2HugePageArena();
+
+	virtual void* Allocate(int32 size);
+	virtual void Free(void* mem);
+
+	/// Did the system back the arena with huge pages?
+	bool UsesHugePages() const { return m_hugePages; }
+
+	/// Get the number of bytes reserved.
+	int32 GetCapacity() const { return m_capacity; }
+
+	/// Get the number of bytes carved from the arena so far.
+	int32 GetUsedBytes() const { return m_offset; }
+
+private:
+	std::mutex m_mutex;
+	b2AllocatorInterface* m_fallback;
+	int8* m_base;
+	int32 m_capacity;
+	int32 m_offset;
+	bool m_hugePages;
+	uint8* m_pageClasses;
+	void* m_freeLists[b2_arenaSizeClasses];
+	int32 m_classOffsets[b2_arenaSizeClasses];
+	int32 m_classEnds[b2_arenaSizeClasses];
+};
+
+#endif
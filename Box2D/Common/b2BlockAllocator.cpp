@@ -17,9 +17,11 @@
 */
 
 #include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2AllocatorInterface.h>
 #include <limits.h>
 #include <memory.h>
 #include <stddef.h>
+#include <algorithm>
 
 int32 b2BlockAllocator::s_blockSizes[b2_blockSizes] = 
 {
@@ -39,7 +41,7 @@ int32 b2BlockAllocator::s_blockSizes[b2_blockSizes] =
 	640,	// 13
 };
 uint8 b2BlockAllocator::s_blockSizeLookup[b2_maxBlockSize + 1];
-bool b2BlockAllocator::s_blockSizeLookupInitialized;
+std::once_flag b2BlockAllocator::s_blockSizeLookupOnce;
 
 struct b2Chunk
 {
@@ -52,46 +54,263 @@ struct b2Block
 	b2Block* next;
 };
 
-b2BlockAllocator::b2BlockAllocator()
+// A full magazine in the depot. The blocks are linked through next and the
+// first block also links the magazines.
+struct b2Magazine
+{
+	b2Block* next;
+	b2Magazine* nextMagazine;
+};
+
+// Each thread takes a cache slot the first time it uses any block allocator and
+// gives it back when it exits. A thread that takes a returned slot inherits the
+// free blocks the last owner left in each allocator, so they are not stranded.
+// Threads that find no free slot use the shared cache and look again later.
+static std::mutex s_blockCacheSlotMutex;
+static int32 s_blockCacheReturnedSlots[b2_maxBlockCaches];
+static int32 s_blockCacheReturnedCount = 0;
+static int32 s_blockCacheSlotCount = 0;
+static std::atomic<int32> s_blockCacheFreeSlotCount(b2_maxBlockCaches);
+static thread_local int32 t_blockCacheIndex = -1;
+
+static void b2ReleaseBlockCacheSlot(int32 index)
+{
+	std::lock_guard<std::mutex> lock(s_blockCacheSlotMutex);
+	s_blockCacheReturnedSlots[s_blockCacheReturnedCount++] = index;
+	s_blockCacheFreeSlotCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Gives the slot of a thread back when the thread exits.
+struct b2BlockCacheSlotGuard
+{
+	b2BlockCacheSlotGuard() : held(false) {}
+
+	~b2BlockCacheSlotGuard()
+	{
+		if (held)
+		{
+			b2ReleaseBlockCacheSlot(t_blockCacheIndex);
+			t_blockCacheIndex = -1;
+		}
+	}
+
+	bool held;
+};
+
+static thread_local b2BlockCacheSlotGuard t_blockCacheSlotGuard;
+
+static int32 b2AcquireBlockCacheSlot()
+{
+	if (s_blockCacheFreeSlotCount.load(std::memory_order_relaxed) == 0)
+	{
+		return -1;
+	}
+
+	std::lock_guard<std::mutex> lock(s_blockCacheSlotMutex);
+
+	int32 index;
+	if (s_blockCacheReturnedCount > 0)
+	{
+		index = s_blockCacheReturnedSlots[--s_blockCacheReturnedCount];
+	}
+	else if (s_blockCacheSlotCount < b2_maxBlockCaches)
+	{
+		index = s_blockCacheSlotCount++;
+	}
+	else
+	{
+		return -1;
+	}
+
+	s_blockCacheFreeSlotCount.fetch_sub(1, std::memory_order_relaxed);
+	t_blockCacheIndex = index;
+	t_blockCacheSlotGuard.held = true;
+	return index;
+}
+
+void b2BlockAllocator::ResetCache(b2BlockCache* cache)
+{
+	for (int32 i = 0; i < b2_blockSizes; ++i)
+	{
+		cache->freeLists[i] = NULL;
+		cache->freeCounts[i] = 0;
+		cache->allocationCounts[i].store(0, std::memory_order_relaxed);
+		cache->freeBlockCounts[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+static inline void b2Increment(std::atomic<uint32>& count)
+{
+	// Only the owning thread writes the counter, so this needs no atomic add.
+	count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void b2BlockAllocator::InitializeBlockSizeLookup()
+{
+	int32 j = 0;
+	for (int32 i = 1; i <= b2_maxBlockSize; ++i)
+	{
+		b2Assert(j < b2_blockSizes);
+		if (i <= s_blockSizes[j])
+		{
+			s_blockSizeLookup[i] = (uint8)j;
+		}
+		else
+		{
+			++j;
+			s_blockSizeLookup[i] = (uint8)j;
+		}
+	}
+}
+
+b2BlockAllocator::b2BlockAllocator(b2AllocatorInterface* allocator)
 {
 	b2Assert(b2_blockSizes < UCHAR_MAX);
 
+	m_memory = allocator ? allocator : b2GetDefaultAllocator();
+
 	m_chunkSpace = b2_chunkArrayIncrement;
 	m_chunkCount = 0;
-	m_chunks = (b2Chunk*)b2Alloc(m_chunkSpace * sizeof(b2Chunk));
+	m_chunks = (b2Chunk*)m_memory->Allocate(m_chunkSpace * sizeof(b2Chunk));
 	
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
-	memset(m_freeLists, 0, sizeof(m_freeLists));
+	memset(m_magazines, 0, sizeof(m_magazines));
+	memset(m_chunkCounts, 0, sizeof(m_chunkCounts));
 
-	if (s_blockSizeLookupInitialized == false)
+	for (int32 i = 0; i < b2_maxBlockCaches; ++i)
 	{
-		int32 j = 0;
-		for (int32 i = 1; i <= b2_maxBlockSize; ++i)
+		ResetCache(m_caches + i);
+	}
+
+	ResetCache(&m_sharedCache);
+
+	std::call_once(s_blockSizeLookupOnce, InitializeBlockSizeLookup);
+}
+
+b2BlockAllocator::~b2BlockAllocator()
+{
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		m_memory->Free(m_chunks[i].blocks);
+	}
+
+	m_memory->Free(m_chunks);
+}
+
+inline b2BlockAllocator::b2BlockCache* b2BlockAllocator::GetCache()
+{
+	int32 index = t_blockCacheIndex;
+	if (index < 0)
+	{
+		index = b2AcquireBlockCacheSlot();
+		if (index < 0)
 		{
-			b2Assert(j < b2_blockSizes);
-			if (i <= s_blockSizes[j])
-			{
-				s_blockSizeLookup[i] = (uint8)j;
-			}
-			else
-			{
-				++j;
-				s_blockSizeLookup[i] = (uint8)j;
-			}
+			return NULL;
 		}
+	}
+
+	return m_caches + index;
+}
+
+inline void* b2BlockAllocator::Pop(b2BlockCache* cache, int32 index)
+{
+	b2Block* block = cache->freeLists[index];
+	cache->freeLists[index] = block->next;
+	--cache->freeCounts[index];
+	b2Increment(cache->allocationCounts[index]);
+	return block;
+}
+
+inline void b2BlockAllocator::Push(b2BlockCache* cache, int32 index, void* p)
+{
+	b2Block* block = (b2Block*)p;
+	block->next = cache->freeLists[index];
+	cache->freeLists[index] = block;
+	++cache->freeCounts[index];
+	b2Increment(cache->freeBlockCounts[index]);
+}
+
+void b2BlockAllocator::Refill(b2BlockCache* cache, int32 index)
+{
+	b2Assert(cache->freeLists[index] == NULL);
+
+	// Take a magazine from the depot.
+	if (m_magazines[index])
+	{
+		b2Magazine* magazine = (b2Magazine*)m_magazines[index];
+		m_magazines[index] = (b2Block*)magazine->nextMagazine;
+		cache->freeLists[index] = (b2Block*)magazine;
+		cache->freeCounts[index] = b2_magazineSize;
+		return;
+	}
+
+	// The depot is empty, so carve a new chunk.
+	if (m_chunkCount == m_chunkSpace)
+	{
+		b2Chunk* oldChunks = m_chunks;
+		m_chunkSpace += b2_chunkArrayIncrement;
+		m_chunks = (b2Chunk*)m_memory->Allocate(m_chunkSpace * sizeof(b2Chunk));
+		memcpy(m_chunks, oldChunks, m_chunkCount * sizeof(b2Chunk));
+		memset(m_chunks + m_chunkCount, 0, b2_chunkArrayIncrement * sizeof(b2Chunk));
+		m_memory->Free(oldChunks);
+	}
+
+	b2Chunk* chunk = m_chunks + m_chunkCount;
+	chunk->blocks = (b2Block*)m_memory->Allocate(b2_chunkSize);
+#if defined(_DEBUG)
+	memset(chunk->blocks, 0xcd, b2_chunkSize);
+#endif
+	int32 blockSize = s_blockSizes[index];
+	chunk->blockSize = blockSize;
+	int32 blockCount = b2_chunkSize / blockSize;
+	b2Assert(blockCount * blockSize <= b2_chunkSize);
+	for (int32 i = 0; i < blockCount - 1; ++i)
+	{
+		b2Block* block = (b2Block*)((int8*)chunk->blocks + blockSize * i);
+		b2Block* next = (b2Block*)((int8*)chunk->blocks + blockSize * (i + 1));
+		block->next = next;
+	}
+	b2Block* last = (b2Block*)((int8*)chunk->blocks + blockSize * (blockCount - 1));
+	last->next = NULL;
+
+	// The cache gets at most one magazine, so Drain never walks more than that.
+	// The other blocks go to the depot in whole magazines, lowest address on top.
+	int32 cacheCount = blockCount - (blockCount - 1) / b2_magazineSize * b2_magazineSize;
+	for (int32 first = blockCount - b2_magazineSize; first >= cacheCount; first -= b2_magazineSize)
+	{
+		b2Block* tail = (b2Block*)((int8*)chunk->blocks + blockSize * (first - 1));
+		tail->next = NULL;
 
-		s_blockSizeLookupInitialized = true;
+		b2Magazine* magazine = (b2Magazine*)((int8*)chunk->blocks + blockSize * first);
+		magazine->nextMagazine = (b2Magazine*)m_magazines[index];
+		m_magazines[index] = (b2Block*)magazine;
 	}
+
+	cache->freeLists[index] = chunk->blocks;
+	cache->freeCounts[index] = cacheCount;
+	++m_chunkCounts[index];
+	++m_chunkCount;
 }
 
-b2BlockAllocator::~b2BlockAllocator()
+void b2BlockAllocator::Drain(b2BlockCache* cache, int32 index)
 {
-	for (int32 i = 0; i < m_chunkCount; ++i)
+	b2Assert(cache->freeCounts[index] > b2_magazineSize);
+
+	// Keep the most recently freed blocks, which are likely to be in the
+	// processor cache, and move the last b2_magazineSize blocks to the depot.
+	int32 keepCount = cache->freeCounts[index] - b2_magazineSize;
+	b2Block* keep = cache->freeLists[index];
+	for (int32 i = 1; i < keepCount; ++i)
 	{
-		b2Free(m_chunks[i].blocks);
+		keep = keep->next;
 	}
 
-	b2Free(m_chunks);
+	b2Magazine* magazine = (b2Magazine*)keep->next;
+	keep->next = NULL;
+	cache->freeCounts[index] = keepCount;
+
+	magazine->nextMagazine = (b2Magazine*)m_magazines[index];
+	m_magazines[index] = (b2Block*)magazine;
 }
 
 void* b2BlockAllocator::Allocate(int32 size)
@@ -103,53 +322,31 @@ void* b2BlockAllocator::Allocate(int32 size)
 
 	if (size > b2_maxBlockSize)
 	{
-		return b2Alloc(size);
+		return m_memory->Allocate(size);
 	}
 
 	int32 index = s_blockSizeLookup[size];
 	b2Assert(0 <= index && index < b2_blockSizes);
 
-	if (m_freeLists[index])
-	{
-		b2Block* block = m_freeLists[index];
-		m_freeLists[index] = block->next;
-		return block;
-	}
-	else
+	b2BlockCache* cache = GetCache();
+	if (cache == NULL)
 	{
-		if (m_chunkCount == m_chunkSpace)
-		{
-			b2Chunk* oldChunks = m_chunks;
-			m_chunkSpace += b2_chunkArrayIncrement;
-			m_chunks = (b2Chunk*)b2Alloc(m_chunkSpace * sizeof(b2Chunk));
-			memcpy(m_chunks, oldChunks, m_chunkCount * sizeof(b2Chunk));
-			memset(m_chunks + m_chunkCount, 0, b2_chunkArrayIncrement * sizeof(b2Chunk));
-			b2Free(oldChunks);
-		}
-
-		b2Chunk* chunk = m_chunks + m_chunkCount;
-		chunk->blocks = (b2Block*)b2Alloc(b2_chunkSize);
-#if defined(_DEBUG)
-		memset(chunk->blocks, 0xcd, b2_chunkSize);
-#endif
-		int32 blockSize = s_blockSizes[index];
-		chunk->blockSize = blockSize;
-		int32 blockCount = b2_chunkSize / blockSize;
-		b2Assert(blockCount * blockSize <= b2_chunkSize);
-		for (int32 i = 0; i < blockCount - 1; ++i)
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_sharedCache.freeLists[index] == NULL)
 		{
-			b2Block* block = (b2Block*)((int8*)chunk->blocks + blockSize * i);
-			b2Block* next = (b2Block*)((int8*)chunk->blocks + blockSize * (i + 1));
-			block->next = next;
+			Refill(&m_sharedCache, index);
 		}
-		b2Block* last = (b2Block*)((int8*)chunk->blocks + blockSize * (blockCount - 1));
-		last->next = NULL;
 
-		m_freeLists[index] = chunk->blocks->next;
-		++m_chunkCount;
+		return Pop(&m_sharedCache, index);
+	}
 
-		return chunk->blocks;
+	if (cache->freeLists[index] == NULL)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Refill(cache, index);
 	}
+
+	return Pop(cache, index);
 }
 
 void b2BlockAllocator::Free(void* p, int32 size)
@@ -163,7 +360,7 @@ void b2BlockAllocator::Free(void* p, int32 size)
 
 	if (size > b2_maxBlockSize)
 	{
-		b2Free(p);
+		m_memory->Free(p);
 		return;
 	}
 
@@ -174,19 +371,22 @@ void b2BlockAllocator::Free(void* p, int32 size)
 	// Verify the memory address and size is valid.
 	int32 blockSize = s_blockSizes[index];
 	bool found = false;
-	for (int32 i = 0; i < m_chunkCount; ++i)
 	{
-		b2Chunk* chunk = m_chunks + i;
-		if (chunk->blockSize != blockSize)
-		{
-			b2Assert(	(int8*)p + blockSize <= (int8*)chunk->blocks ||
-						(int8*)chunk->blocks + b2_chunkSize <= (int8*)p);
-		}
-		else
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (int32 i = 0; i < m_chunkCount; ++i)
 		{
-			if ((int8*)chunk->blocks <= (int8*)p && (int8*)p + blockSize <= (int8*)chunk->blocks + b2_chunkSize)
+			b2Chunk* chunk = m_chunks + i;
+			if (chunk->blockSize != blockSize)
 			{
-				found = true;
+				b2Assert(	(int8*)p + blockSize <= (int8*)chunk->blocks ||
+							(int8*)chunk->blocks + b2_chunkSize <= (int8*)p);
+			}
+			else
+			{
+				if ((int8*)chunk->blocks <= (int8*)p && (int8*)p + blockSize <= (int8*)chunk->blocks + b2_chunkSize)
+				{
+					found = true;
+				}
 			}
 		}
 	}
@@ -196,20 +396,250 @@ void b2BlockAllocator::Free(void* p, int32 size)
 	memset(p, 0xfd, blockSize);
 #endif
 
-	b2Block* block = (b2Block*)p;
-	block->next = m_freeLists[index];
-	m_freeLists[index] = block;
+	b2BlockCache* cache = GetCache();
+	if (cache == NULL)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Push(&m_sharedCache, index, p);
+		if (m_sharedCache.freeCounts[index] > 2 * b2_magazineSize)
+		{
+			Drain(&m_sharedCache, index);
+		}
+
+		return;
+	}
+
+	Push(cache, index, p);
+	if (cache->freeCounts[index] > 2 * b2_magazineSize)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Drain(cache, index);
+	}
 }
 
 void b2BlockAllocator::Clear()
 {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
 	for (int32 i = 0; i < m_chunkCount; ++i)
 	{
-		b2Free(m_chunks[i].blocks);
+		m_memory->Free(m_chunks[i].blocks);
 	}
 
 	m_chunkCount = 0;
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 
-	memset(m_freeLists, 0, sizeof(m_freeLists));
+	memset(m_magazines, 0, sizeof(m_magazines));
+	memset(m_chunkCounts, 0, sizeof(m_chunkCounts));
+
+	for (int32 i = 0; i < b2_maxBlockCaches; ++i)
+	{
+		ResetCache(m_caches + i);
+	}
+
+	ResetCache(&m_sharedCache);
+}
+
+// A chunk sorted by address so that Trim can find the chunk of a free block.
+struct b2ChunkRef
+{
+	int8* blocks;
+	int32 chunkIndex;
+	int32 freeCount;
+};
+
+static inline bool b2ChunkRefLess(const b2ChunkRef& a, const b2ChunkRef& b)
+{
+	return a.blocks < b.blocks;
+}
+
+static b2ChunkRef* b2FindChunk(b2ChunkRef* refs, int32 count, const void* p)
+{
+	b2ChunkRef key;
+	key.blocks = (int8*)p;
+	b2ChunkRef* ref = std::upper_bound(refs, refs + count, key, b2ChunkRefLess) - 1;
+	b2Assert(refs <= ref && (int8*)p < ref->blocks + b2_chunkSize);
+	return ref;
+}
+
+int32 b2BlockAllocator::Trim()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_chunkCount == 0)
+	{
+		return 0;
+	}
+
+	b2ChunkRef* refs = (b2ChunkRef*)m_memory->Allocate(m_chunkCount * sizeof(b2ChunkRef));
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		refs[i].blocks = (int8*)m_chunks[i].blocks;
+		refs[i].chunkIndex = i;
+		refs[i].freeCount = 0;
+	}
+	std::sort(refs, refs + m_chunkCount, b2ChunkRefLess);
+
+	// The free lists of a size class are in the thread caches, the shared cache and
+	// the depot magazines.
+	const int32 listCount = b2_maxBlockCaches + 1;
+	b2BlockCache* caches[listCount];
+	for (int32 i = 0; i < b2_maxBlockCaches; ++i)
+	{
+		caches[i] = m_caches + i;
+	}
+	caches[b2_maxBlockCaches] = &m_sharedCache;
+
+	b2BlockCache* callerCache = GetCache();
+	if (callerCache == NULL)
+	{
+		callerCache = &m_sharedCache;
+	}
+
+	int32 releasedCount = 0;
+	for (int32 index = 0; index < b2_blockSizes; ++index)
+	{
+		int32 blockSize = s_blockSizes[index];
+		int32 blockCount = b2_chunkSize / blockSize;
+
+		// Skip the size class unless its free blocks could fill a chunk.
+		uint32 allocationCount = 0;
+		uint32 freeBlockCount = 0;
+		for (int32 i = 0; i < listCount; ++i)
+		{
+			allocationCount += caches[i]->allocationCounts[index].load(std::memory_order_relaxed);
+			freeBlockCount += caches[i]->freeBlockCounts[index].load(std::memory_order_relaxed);
+		}
+		int32 liveCount = int32(allocationCount - freeBlockCount);
+		if (m_chunkCounts[index] * blockCount - liveCount < blockCount)
+		{
+			continue;
+		}
+
+		// Gather all the free blocks of this size into one list and count them per chunk.
+		b2Block* freeList = NULL;
+		for (int32 i = 0; i < listCount; ++i)
+		{
+			b2Block* block = caches[i]->freeLists[index];
+			while (block)
+			{
+				b2Block* next = block->next;
+				block->next = freeList;
+				freeList = block;
+				block = next;
+			}
+
+			caches[i]->freeLists[index] = NULL;
+			caches[i]->freeCounts[index] = 0;
+		}
+
+		b2Magazine* magazine = (b2Magazine*)m_magazines[index];
+		while (magazine)
+		{
+			b2Magazine* nextMagazine = magazine->nextMagazine;
+			b2Block* block = (b2Block*)magazine;
+			while (block)
+			{
+				b2Block* next = block->next;
+				block->next = freeList;
+				freeList = block;
+				block = next;
+			}
+
+			magazine = nextMagazine;
+		}
+		m_magazines[index] = NULL;
+
+		for (b2Block* block = freeList; block; block = block->next)
+		{
+			++b2FindChunk(refs, m_chunkCount, block)->freeCount;
+		}
+
+		// Drop the blocks of idle chunks and hand the rest back out.
+		b2Block* keepList = NULL;
+		int32 keepCount = 0;
+		b2Block* block = freeList;
+		while (block)
+		{
+			b2Block* next = block->next;
+			if (b2FindChunk(refs, m_chunkCount, block)->freeCount < blockCount)
+			{
+				block->next = keepList;
+				keepList = block;
+				++keepCount;
+			}
+
+			block = next;
+		}
+
+		while (keepCount >= b2_magazineSize)
+		{
+			b2Block* first = keepList;
+			b2Block* last = first;
+			for (int32 i = 1; i < b2_magazineSize; ++i)
+			{
+				last = last->next;
+			}
+
+			keepList = last->next;
+			last->next = NULL;
+			keepCount -= b2_magazineSize;
+
+			b2Magazine* full = (b2Magazine*)first;
+			full->nextMagazine = (b2Magazine*)m_magazines[index];
+			m_magazines[index] = (b2Block*)full;
+		}
+
+		callerCache->freeLists[index] = keepList;
+		callerCache->freeCounts[index] = keepCount;
+	}
+
+	// Release the idle chunks and compact the chunk array.
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		b2Chunk* chunk = m_chunks + refs[i].chunkIndex;
+		if (refs[i].freeCount == b2_chunkSize / chunk->blockSize)
+		{
+			--m_chunkCounts[s_blockSizeLookup[chunk->blockSize]];
+			m_memory->Free(chunk->blocks);
+			chunk->blocks = NULL;
+			++releasedCount;
+		}
+	}
+
+	int32 chunkCount = 0;
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		if (m_chunks[i].blocks)
+		{
+			m_chunks[chunkCount++] = m_chunks[i];
+		}
+	}
+	memset(m_chunks + chunkCount, 0, (m_chunkCount - chunkCount) * sizeof(b2Chunk));
+	m_chunkCount = chunkCount;
+
+	m_memory->Free(refs);
+
+	return releasedCount * b2_chunkSize;
+}
+
+void b2BlockAllocator::GetStats(b2BlockAllocatorStats stats[b2_blockSizes]) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (int32 i = 0; i < b2_blockSizes; ++i)
+	{
+		uint32 allocationCount = m_sharedCache.allocationCounts[i].load(std::memory_order_relaxed);
+		uint32 freeCount = m_sharedCache.freeBlockCounts[i].load(std::memory_order_relaxed);
+		for (int32 j = 0; j < b2_maxBlockCaches; ++j)
+		{
+			allocationCount += m_caches[j].allocationCounts[i].load(std::memory_order_relaxed);
+			freeCount += m_caches[j].freeBlockCounts[i].load(std::memory_order_relaxed);
+		}
+
+		stats[i].blockSize = s_blockSizes[i];
+		stats[i].allocationCount = allocationCount;
+		stats[i].liveCount = int32(allocationCount - freeCount);
+		stats[i].chunkCount = m_chunkCounts[i];
+	}
 }
@@ -20,43 +20,113 @@
 #define B2_BLOCK_ALLOCATOR_H
 
 #include <Box2D/Common/b2Settings.h>
+#include <atomic>
+#include <mutex>
+
+class b2AllocatorInterface;
 
 const int32 b2_chunkSize = 16 * 1024;
 const int32 b2_maxBlockSize = 640;
 const int32 b2_blockSizes = 14;
 const int32 b2_chunkArrayIncrement = 128;
 
+/// The number of blocks moved at once between a thread cache and the shared depot.
+const int32 b2_magazineSize = 32;
+
+/// The number of threads that get their own block cache in each allocator. Further
+/// threads share one cache behind the allocator lock until a thread with a cache exits.
+const int32 b2_maxBlockCaches = 16;
+
 struct b2Block;
 struct b2Chunk;
 
+/// Usage of one block size of a b2BlockAllocator.
+struct b2BlockAllocatorStats
+{
+	int32 blockSize;			///< the size of the blocks in bytes
+	uint32 allocationCount;		///< the number of blocks allocated so far, this wraps around
+	int32 liveCount;			///< the number of blocks currently allocated
+	int32 chunkCount;			///< the number of chunks carved into blocks of this size
+};
+
 /// This is a small object allocator used for allocating small
 /// objects that persist for more than one time step.
 /// See: http://www.codeproject.com/useritems/Small_Block_Allocator.asp
+/// Allocate and Free may be called from several threads at once. Each thread keeps
+/// its own free lists and trades whole magazines of blocks with a shared depot, so
+/// the lock is only taken once every b2_magazineSize blocks.
 class b2BlockAllocator
 {
 public:
-	b2BlockAllocator();
+	/// @param allocator the source of the chunks, or NULL for the default allocator
+	b2BlockAllocator(b2AllocatorInterface* allocator = NULL);
 	~b2BlockAllocator();
 
-	/// Allocate memory. This will use b2Alloc if the size is larger than b2_maxBlockSize.
+	/// Allocate memory. This will use the underlying allocator if the size is larger
+	/// than b2_maxBlockSize.
 	void* Allocate(int32 size);
 
-	/// Free memory. This will use b2Free if the size is larger than b2_maxBlockSize.
+	/// Free memory. This will use the underlying allocator if the size is larger than
+	/// b2_maxBlockSize.
 	void Free(void* p, int32 size);
 
+	/// Release all the chunks. No other thread may use the allocator during this call.
 	void Clear();
 
+	/// Release the chunks whose blocks are all free. Size classes with fewer free
+	/// blocks than fill one chunk are skipped without walking their free lists.
+	/// No other thread may use the allocator during this call.
+	/// @return the number of bytes released.
+	int32 Trim();
+
+	/// Get the usage of each block size. The counts are exact once the threads that
+	/// use the allocator are idle.
+	void GetStats(b2BlockAllocatorStats stats[b2_blockSizes]) const;
+
+	/// Get the allocator that provides the chunks.
+	b2AllocatorInterface* GetMemory() const { return m_memory; }
+
 private:
 
+	// The free lists of one thread. Only the owning thread writes to it. The
+	// counters are atomic so that GetStats may read them from another thread.
+	struct alignas(64) b2BlockCache
+	{
+		b2Block* freeLists[b2_blockSizes];
+		int32 freeCounts[b2_blockSizes];
+		std::atomic<uint32> allocationCounts[b2_blockSizes];
+		std::atomic<uint32> freeBlockCounts[b2_blockSizes];
+	};
+
+	static void ResetCache(b2BlockCache* cache);
+	b2BlockCache* GetCache();
+	void* Pop(b2BlockCache* cache, int32 index);
+	void Push(b2BlockCache* cache, int32 index, void* p);
+
+	// These are called with the lock held.
+	void Refill(b2BlockCache* cache, int32 index);
+	void Drain(b2BlockCache* cache, int32 index);
+
+	static void InitializeBlockSizeLookup();
+
+	b2BlockCache m_caches[b2_maxBlockCaches];
+
+	// Used by threads beyond b2_maxBlockCaches, with the lock held.
+	b2BlockCache m_sharedCache;
+
+	b2AllocatorInterface* m_memory;
+
+	// The depot. This is guarded by the lock.
+	mutable std::mutex m_mutex;
 	b2Chunk* m_chunks;
 	int32 m_chunkCount;
 	int32 m_chunkSpace;
-
-	b2Block* m_freeLists[b2_blockSizes];
+	b2Block* m_magazines[b2_blockSizes];
+	int32 m_chunkCounts[b2_blockSizes];
 
 	static int32 s_blockSizes[b2_blockSizes];
 	static uint8 s_blockSizeLookup[b2_maxBlockSize + 1];
-	static bool s_blockSizeLookupInitialized;
+	static std::once_flag s_blockSizeLookupOnce;
 };
 
 #endif
@@ -53,6 +53,10 @@ typedef double float64;
 /// this too much because b2BlockAllocator has a maximum object size.
 #define b2_maxPolygonVertices	8
 
+/// The number of collision layers in the world layer collision matrix. Each
+/// fixture belongs to exactly one layer. Do not change this value.
+#define b2_maxCollisionLayers	32
+
 /// This is used to fatten AABBs in the dynamic tree. This allows proxies
 /// to move by a small amount without triggering a tree adjustment.
 /// This is in meters.
@@ -76,6 +80,23 @@ typedef double float64;
 /// Making it larger may create artifacts for vertex collision.
 #define b2_polygonRadius		(2.0f * b2_linearSlop)
 
+/// A contact keeps its manifold from the previous step when the relative transform of
+/// the two bodies has moved the contact geometry by less than this distance. This is
+/// much smaller than b2_linearSlop so the reused manifold stays accurate.
+#define b2_manifoldReuseTolerance	(0.1f * b2_linearSlop)
+
+/// With speculative contacts a contact gets manifold points when the shapes are apart
+/// by less than their predicted approach over the step plus this distance.
+#define b2_speculativeDistance	(4.0f * b2_linearSlop)
+
+/// The number of slots in the cache that keeps the impulses of destroyed contacts.
+/// This must be a power of two.
+#define b2_impulseCacheSize		1024
+
+/// The number of time steps a destroyed contact's impulses are kept to warm start a
+/// new contact between the same fixtures.
+#define b2_impulseCacheLifetime	30
+
 /// Maximum number of sub-steps per contact in continuous physics simulation.
 #define b2_maxSubSteps			8
 
@@ -113,6 +134,26 @@ typedef double float64;
 #define b2_baumgarte				0.2f
 #define b2_toiBaugarte				0.75f
 
+/// The soft step solver treats contacts as stiff, heavily damped springs. The stiffness
+/// is also limited by the substep rate.
+#define b2_contactHertz				30.0f
+#define b2_contactDampingRatio		10.0f
+
+/// The maximum speed at which the soft step solver pushes overlapping shapes apart.
+#define b2_contactPushVelocity		3.0f
+
+/// The velocity iterations of an island stop early once a pass changes no velocity by
+/// more than this tolerance times the inverse time step. This is the drift that the
+/// change would cause over the step.
+#define b2_linearResidual			(0.01f * b2_linearSlop)
+#define b2_angularResidual			(0.01f * b2_angularSlop)
+
+/// The minimum number of velocity iterations run before the early exit is considered.
+#define b2_minVelocityIterations	2
+
+/// The minimum number of position iterations run before the early exit is considered.
+#define b2_minPositionIterations	1
+
 
 // Sleep
 
@@ -0,0 +1,88 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Common/b2Snapshot.h>
+#include <Box2D/Common/b2AllocatorInterface.h>
+#include <Box2D/Common/b2Math.h>
+#include <memory.h>
+
+b2Snapshot::b2Snapshot(b2AllocatorInterface* allocator)
+{
+	m_memory = allocator ? allocator : b2GetDefaultAllocator();
+	m_data = NULL;
+	m_size = 0;
+	m_capacity = 0;
+}
+
+b2Snapshot::~b2Snapshot()
+{
+	m_memory->Free(m_data);
+}
+
+void b2Snapshot::Clear()
+{
+	m_size = 0;
+}
+
+void b2Snapshot::Write(const void* data, int32 size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+
+	if (m_size + size > m_capacity)
+	{
+		int8* oldData = m_data;
+		m_capacity = b2Max(2 * m_capacity, m_size + size);
+		m_data = (int8*)m_memory->Allocate(m_capacity);
+		if (m_size > 0)
+		{
+			memcpy(m_data, oldData, m_size);
+		}
+		m_memory->Free(oldData);
+	}
+
+	memcpy(m_data + m_size, data, size);
+	m_size += size;
+}
+
+b2SnapshotReader::b2SnapshotReader(const b2Snapshot* snapshot)
+{
+	m_cursor = snapshot->GetData();
+	m_end = m_cursor + snapshot->GetSize();
+}
+
+void b2SnapshotReader::Read(void* data, int32 size)
+{
+	b2Assert(m_cursor + size <= m_end);
+	if (size > 0)
+	{
+		memcpy(data, m_cursor, size);
+	}
+	m_cursor += size;
+}
+
+const int8* b2SnapshotReader::Skip(int32 size)
+{
+	b2Assert(m_cursor + size <= m_end);
+	const int8* data = m_cursor;
+	m_cursor += size;
+	return data;
+}
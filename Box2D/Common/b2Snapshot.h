@@ -0,0 +1,119 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_SNAPSHOT_H
+#define B2_SNAPSHOT_H
+
+#include <Box2D/Common/b2Settings.h>
+
+class b2AllocatorInterface;
+
+/// A copy of the simulation state of a world in one contiguous buffer. Take one with
+/// b2World::Snapshot and bring the world back to it with b2World::Restore. The buffer
+/// keeps its capacity, so reusing a snapshot does not allocate once it has grown.
+class b2Snapshot
+{
+public:
+	/// @param allocator the source of the buffer, usually the allocator of the world,
+	/// or NULL for the default allocator. It must outlive the snapshot.
+	explicit b2Snapshot(b2AllocatorInterface* allocator = NULL);
+	~b2Snapshot();
+
+	/// Drop the state but keep the buffer.
+	void Clear();
+
+	/// Append bytes to the state.
+	void Write(const void* data, int32 size);
+
+	/// Append a value to the state.
+	template <typename T>
+	void Write(const T& value);
+
+	/// Get the state.
+	const int8* GetData() const;
+
+	/// Get the size of the state in bytes.
+	int32 GetSize() const;
+
+private:
+
+	b2Snapshot(const b2Snapshot&);
+	b2Snapshot& operator=(const b2Snapshot&);
+
+	b2AllocatorInterface* m_memory;
+	int8* m_data;
+	int32 m_size;
+	int32 m_capacity;
+};
+
+/// Reads the state of a snapshot in the order it was written.
+class b2SnapshotReader
+{
+public:
+	explicit b2SnapshotReader(const b2Snapshot* snapshot);
+
+	/// Read the next bytes of the state.
+	void Read(void* data, int32 size);
+
+	/// Read the next value of the state.
+	template <typename T>
+	T Read();
+
+	/// Get the next bytes of the state without copying them.
+	const int8* Skip(int32 size);
+
+	/// Has all the state been read?
+	bool IsDone() const;
+
+private:
+
+	const int8* m_cursor;
+	const int8* m_end;
+};
+
+template <typename T>
+inline void b2Snapshot::Write(const T& value)
+{
+	Write(&value, sizeof(T));
+}
+
+inline const int8* b2Snapshot::GetData() const
+{
+	return m_data;
+}
+
+inline int32 b2Snapshot::GetSize() const
+{
+	return m_size;
+}
+
+template <typename T>
+inline T b2SnapshotReader::Read()
+{
+	T value;
+	Read(&value, sizeof(T));
+	return value;
+}
+
+inline bool b2SnapshotReader::IsDone() const
+{
+	return m_cursor == m_end;
+}
+
+#endif
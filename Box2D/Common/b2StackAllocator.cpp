@@ -17,13 +17,22 @@
 */
 
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2AllocatorInterface.h>
 #include <Box2D/Common/b2Math.h>
+#include <memory.h>
 
-b2StackAllocator::b2StackAllocator()
+b2StackAllocator::b2StackAllocator(b2AllocatorInterface* allocator)
 {
+	m_memory = allocator ? allocator : b2GetDefaultAllocator();
+	m_capacity = b2_stackSize;
+	m_data = (char*)m_memory->Allocate(m_capacity);
 	m_index = 0;
 	m_allocation = 0;
 	m_maxAllocation = 0;
+	m_peakAllocation = 0;
+	m_fallbackCount = 0;
+	m_entryCapacity = b2_maxStackEntries;
+	m_entries = (b2StackEntry*)m_memory->Allocate(m_entryCapacity * sizeof(b2StackEntry));
 	m_entryCount = 0;
 }
 
@@ -31,18 +40,29 @@ b2StackAllocator::~b2StackAllocator()
 {
 	b2Assert(m_index == 0);
 	b2Assert(m_entryCount == 0);
+
+	m_memory->Free(m_entries);
+	m_memory->Free(m_data);
 }
 
 void* b2StackAllocator::Allocate(int32 size)
 {
-	b2Assert(m_entryCount < b2_maxStackEntries);
+	if (m_entryCount == m_entryCapacity)
+	{
+		b2StackEntry* oldEntries = m_entries;
+		m_entryCapacity *= 2;
+		m_entries = (b2StackEntry*)m_memory->Allocate(m_entryCapacity * sizeof(b2StackEntry));
+		memcpy(m_entries, oldEntries, m_entryCount * sizeof(b2StackEntry));
+		m_memory->Free(oldEntries);
+	}
 
 	b2StackEntry* entry = m_entries + m_entryCount;
 	entry->size = size;
-	if (m_index + size > b2_stackSize)
+	if (m_index + size > m_capacity)
 	{
-		entry->data = (char*)b2Alloc(size);
+		entry->data = (char*)m_memory->Allocate(size);
 		entry->usedMalloc = true;
+		++m_fallbackCount;
 	}
 	else
 	{
@@ -53,6 +73,7 @@ void* b2StackAllocator::Allocate(int32 size)
 
 	m_allocation += size;
 	m_maxAllocation = b2Max(m_maxAllocation, m_allocation);
+	m_peakAllocation = b2Max(m_peakAllocation, m_allocation);
 	++m_entryCount;
 
 	return entry->data;
@@ -65,7 +86,7 @@ void b2StackAllocator::Free(void* p)
 	b2Assert(p == entry->data);
 	if (entry->usedMalloc)
 	{
-		b2Free(p);
+		m_memory->Free(p);
 	}
 	else
 	{
@@ -74,6 +95,14 @@ void b2StackAllocator::Free(void* p)
 	m_allocation -= entry->size;
 	--m_entryCount;
 
+	// Grow to the high-water mark once no allocation points into the buffer.
+	if (m_entryCount == 0 && m_maxAllocation > m_capacity)
+	{
+		m_memory->Free(m_data);
+		m_capacity = m_maxAllocation;
+		m_data = (char*)m_memory->Allocate(m_capacity);
+	}
+
 	p = NULL;
 }
 
@@ -81,3 +110,9 @@ int32 b2StackAllocator::GetMaxAllocation() const
 {
 	return m_maxAllocation;
 }
+
+void b2StackAllocator::ResetPeak()
+{
+	m_peakAllocation = m_allocation;
+	m_fallbackCount = 0;
+}
@@ -21,6 +21,8 @@
 
 #include <Box2D/Common/b2Settings.h>
 
+class b2AllocatorInterface;
+
 const int32 b2_stackSize = 100 * 1024;	// 100k
 const int32 b2_maxStackEntries = 32;
 
@@ -34,10 +36,13 @@ struct b2StackEntry
 // This is a stack allocator used for fast per step allocations.
 // You must nest allocate/free pairs. The code will assert
 // if you try to interleave multiple allocate/free pairs.
+// An allocation that does not fit falls back to the underlying allocator. Once the stack is empty
+// again the buffer grows to the largest total allocation seen, so a world of
+// steady size stops allocating after its first step.
 class b2StackAllocator
 {
 public:
-	b2StackAllocator();
+	b2StackAllocator(b2AllocatorInterface* allocator = NULL);
 	~b2StackAllocator();
 
 	void* Allocate(int32 size);
@@ -45,16 +50,35 @@ public:
 
 	int32 GetMaxAllocation() const;
 
+	/// Get the size of the buffer.
+	int32 GetCapacity() const { return m_capacity; }
+
+	/// Get the largest total allocation since the last call to ResetPeak.
+	int32 GetPeakAllocation() const { return m_peakAllocation; }
+
+	/// Get the number of allocations that fell back to the underlying allocator since the last
+	/// call to ResetPeak.
+	int32 GetFallbackCount() const { return m_fallbackCount; }
+
+	/// Start a new measuring period, usually a time step.
+	void ResetPeak();
+
 private:
 
-	char m_data[b2_stackSize];
+	b2AllocatorInterface* m_memory;
+
+	char* m_data;
+	int32 m_capacity;
 	int32 m_index;
 
 	int32 m_allocation;
 	int32 m_maxAllocation;
+	int32 m_peakAllocation;
+	int32 m_fallbackCount;
 
-	b2StackEntry m_entries[b2_maxStackEntries];
+	b2StackEntry* m_entries;
 	int32 m_entryCount;
+	int32 m_entryCapacity;
 };
 
 #endif
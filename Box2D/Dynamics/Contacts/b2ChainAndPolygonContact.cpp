@@ -27,7 +27,7 @@
 b2Contact* b2ChainAndPolygonContact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator)
 {
 	void* mem = allocator->Allocate(sizeof(b2ChainAndPolygonContact));
-	return new (mem) b2ChainAndPolygonContact(fixtureA, indexA, fixtureB, indexB);
+	return new (mem) b2ChainAndPolygonContact(fixtureA, indexA, fixtureB, indexB, allocator->GetMemory());
 }
 
 void b2ChainAndPolygonContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
@@ -36,15 +36,26 @@ void b2ChainAndPolygonContact::Destroy(b2Contact* contact, b2BlockAllocator* all
 	allocator->Free(contact, sizeof(b2ChainAndPolygonContact));
 }
 
-b2ChainAndPolygonContact::b2ChainAndPolygonContact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB)
-: b2Contact(fixtureA, indexA, fixtureB, indexB)
+b2ChainAndPolygonContact::b2ChainAndPolygonContact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2AllocatorInterface* memory)
+: b2ChainContact(fixtureA, indexA, fixtureB, indexB, memory)
 {
-	b2Assert(m_fixtureA->GetType() == b2Shape::e_chain);
 	b2Assert(m_fixtureB->GetType() == b2Shape::e_polygon);
 }
 
+static void b2CollideEdgeAndPolygonShape(b2Manifold* manifold, const b2EdgeShape* edgeA, const b2Transform& xfA,
+										const b2Shape* shapeB, const b2Transform& xfB)
+{
+	b2CollideEdgeAndPolygon(manifold, edgeA, xfA, (const b2PolygonShape*)shapeB, xfB);
+}
+
 void b2ChainAndPolygonContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB)
 {
+	if (m_tree)
+	{
+		EvaluateTree(manifold, xfA, xfB, b2CollideEdgeAndPolygonShape);
+		return;
+	}
+
 	b2ChainShape* chain = (b2ChainShape*)m_fixtureA->GetShape();
 	b2EdgeShape edge;
 	chain->GetChildEdge(&edge, m_indexA);
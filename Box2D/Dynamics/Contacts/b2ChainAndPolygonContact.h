@@ -19,18 +19,18 @@
 #ifndef B2_CHAIN_AND_POLYGON_CONTACT_H
 #define B2_CHAIN_AND_POLYGON_CONTACT_H
 
-#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Dynamics/Contacts/b2ChainContact.h>
 
 class b2BlockAllocator;
 
-class b2ChainAndPolygonContact : public b2Contact
+class b2ChainAndPolygonContact : public b2ChainContact
 {
 public:
 	static b2Contact* Create(	b2Fixture* fixtureA, int32 indexA,
 								b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator);
 	static void Destroy(b2Contact* contact, b2BlockAllocator* allocator);
 
-	b2ChainAndPolygonContact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB);
+	b2ChainAndPolygonContact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2AllocatorInterface* memory);
 	~b2ChainAndPolygonContact() {}
 
 	void Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB);
@@ -0,0 +1,99 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Dynamics/Contacts/b2ChainContact.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Common/b2Snapshot.h>
+
+
+b2ChainContact::b2ChainContact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2AllocatorInterface* memory)
+: b2Contact(fixtureA, indexA, fixtureB, indexB), m_manifoldSet(memory)
+{
+	b2Assert(m_fixtureA->GetType() == b2Shape::e_chain);
+
+	b2ChainShape* chain = (b2ChainShape*)m_fixtureA->GetShape();
+	m_tree = chain->HasTree();
+}
+
+void b2ChainContact::MatchImpulses(const b2Manifold& oldManifold)
+{
+	if (m_tree == false)
+	{
+		b2Contact::MatchImpulses(oldManifold);
+	}
+}
+
+// Collides the edges reported by the chain tree.
+struct b2ChainTreeCallback
+{
+	bool QueryCallback(int32 edge)
+	{
+		chain->GetChildEdge(&edgeShape, edge);
+
+		b2Manifold manifold;
+		collideFcn(&manifold, &edgeShape, *xfA, shapeB, *xfB);
+		if (manifold.pointCount > 0)
+		{
+			manifoldSet->Add(manifold, edge);
+		}
+
+		return true;
+	}
+
+	b2ManifoldSet* manifoldSet;
+	const b2ChainShape* chain;
+	const b2Shape* shapeB;
+	const b2Transform* xfA;
+	const b2Transform* xfB;
+	b2CollideEdgeFcn* collideFcn;
+	b2EdgeShape edgeShape;
+};
+
+void b2ChainContact::EvaluateTree(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB,
+									b2CollideEdgeFcn* collideFcn)
+{
+	m_manifoldSet.Begin(*manifold);
+
+	b2ChainTreeCallback callback;
+	callback.manifoldSet = &m_manifoldSet;
+	callback.chain = (b2ChainShape*)m_fixtureA->GetShape();
+	callback.shapeB = m_fixtureB->GetShape();
+	callback.xfA = &xfA;
+	callback.xfB = &xfB;
+	callback.collideFcn = collideFcn;
+
+	// Find the edges near shape B in the frame of the chain.
+	b2AABB aabb;
+	callback.shapeB->ComputeAABB(&aabb, b2MulT(xfA, xfB), m_indexB);
+	callback.chain->Query(&callback, aabb);
+
+	m_manifoldSet.End(manifold, &m_extraManifolds, &m_extraManifoldCount);
+}
+
+void b2ChainContact::SaveState(b2Snapshot* snapshot) const
+{
+	m_manifoldSet.SaveState(snapshot);
+}
+
+void b2ChainContact::RestoreState(b2SnapshotReader* reader)
+{
+	m_manifoldSet.RestoreState(reader, &m_extraManifolds, &m_extraManifoldCount);
+}
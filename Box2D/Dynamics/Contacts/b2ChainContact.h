@@ -0,0 +1,58 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_CHAIN_CONTACT_H
+#define B2_CHAIN_CONTACT_H
+
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Dynamics/Contacts/b2ManifoldSet.h>
+
+class b2EdgeShape;
+
+/// Collide an edge of a chain with shape B.
+typedef void b2CollideEdgeFcn(b2Manifold* manifold, const b2EdgeShape* edgeA, const b2Transform& xfA,
+								const b2Shape* shapeB, const b2Transform& xfB);
+
+/// Base of the chain contacts. A chain without a tree has a contact per edge. A chain
+/// with a tree has a single contact per fixture with a manifold per touching edge.
+class b2ChainContact : public b2Contact
+{
+public:
+	b2ChainContact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2AllocatorInterface* memory);
+	~b2ChainContact() {}
+
+	/// The manifolds of a chain with a tree are matched per edge in EvaluateTree.
+	void MatchImpulses(const b2Manifold& oldManifold);
+
+protected:
+	// Collide shape B with the edges near it. The first touching edge goes to
+	// manifold and the others to the extra manifolds.
+	void EvaluateTree(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB,
+						b2CollideEdgeFcn* collideFcn);
+
+	void SaveState(b2Snapshot* snapshot) const;
+	void RestoreState(b2SnapshotReader* reader);
+
+	bool m_tree;
+
+	// The manifolds of a chain with a tree, keyed by edge.
+	b2ManifoldSet m_manifoldSet;
+};
+
+#endif
@@ -0,0 +1,264 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Dynamics/Contacts/b2CompoundContact.h>
+#include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Snapshot.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Collision/Shapes/b2CapsuleShape.h>
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2CompoundShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+
+#include <new>
+
+b2Contact* b2CompoundContact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator)
+{
+	void* mem = allocator->Allocate(sizeof(b2CompoundContact));
+	return new (mem) b2CompoundContact(fixtureA, indexA, fixtureB, indexB, allocator->GetMemory());
+}
+
+void b2CompoundContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
+{
+	((b2CompoundContact*)contact)->~b2CompoundContact();
+	allocator->Free(contact, sizeof(b2CompoundContact));
+}
+
+b2CompoundContact::b2CompoundContact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2AllocatorInterface* memory)
+: b2Contact(fixtureA, indexA, fixtureB, indexB), m_manifoldSet(memory)
+{
+	b2Assert(m_fixtureA->GetType() == b2Shape::e_compound ||
+			m_fixtureA->GetType() == b2Shape::e_edge ||
+			m_fixtureA->GetType() == b2Shape::e_chain);
+	b2Assert(m_fixtureB->GetType() == b2Shape::e_compound ||
+			m_fixtureB->GetType() == b2Shape::e_circle ||
+			m_fixtureB->GetType() == b2Shape::e_polygon ||
+			m_fixtureB->GetType() == b2Shape::e_capsule);
+}
+
+void b2CompoundContact::MatchImpulses(const b2Manifold& oldManifold)
+{
+	B2_NOT_USED(oldManifold);
+}
+
+// Get a primitive of a shape. Compounds give a polygon, chains give an edge and
+// other shapes are a single primitive.
+static const b2Shape* b2GetPrimitive(const b2Shape* shape, int32 index, b2EdgeShape* edge)
+{
+	switch (shape->GetType())
+	{
+	case b2Shape::e_compound:
+		return ((const b2CompoundShape*)shape)->GetShape(index);
+
+	case b2Shape::e_chain:
+		((const b2ChainShape*)shape)->GetChildEdge(edge, index);
+		return edge;
+
+	default:
+		return shape;
+	}
+}
+
+// Collide a primitive of shape A with a primitive of shape B. A is a polygon or an
+// edge and B is a circle, a polygon or a capsule.
+static void b2CollidePrimitives(b2Manifold* manifold,
+								const b2Shape* shapeA, const b2Transform& xfA,
+								const b2Shape* shapeB, const b2Transform& xfB)
+{
+	if (shapeA->GetType() == b2Shape::e_edge)
+	{
+		const b2EdgeShape* edgeA = (const b2EdgeShape*)shapeA;
+		if (shapeB->GetType() == b2Shape::e_capsule)
+		{
+			b2CollideEdgeAndCapsule(manifold, edgeA, xfA, (const b2CapsuleShape*)shapeB, xfB);
+			return;
+		}
+
+		b2Assert(shapeB->GetType() == b2Shape::e_polygon);
+		b2CollideEdgeAndPolygon(manifold, edgeA, xfA, (const b2PolygonShape*)shapeB, xfB);
+		return;
+	}
+
+	b2Assert(shapeA->GetType() == b2Shape::e_polygon);
+	const b2PolygonShape* polygonA = (const b2PolygonShape*)shapeA;
+
+	if (shapeB->GetType() == b2Shape::e_circle)
+	{
+		b2CollidePolygonAndCircle(manifold, polygonA, xfA, (const b2CircleShape*)shapeB, xfB);
+		return;
+	}
+
+	if (shapeB->GetType() == b2Shape::e_capsule)
+	{
+		b2CollidePolygonAndCapsule(manifold, polygonA, xfA, (const b2CapsuleShape*)shapeB, xfB);
+		return;
+	}
+
+	const b2PolygonShape* polygonB = (const b2PolygonShape*)shapeB;
+	if (polygonA->IsBox() && polygonB->IsBox())
+	{
+		b2CollideBoxes(manifold, polygonA, xfA, polygonB, xfB);
+	}
+	else
+	{
+		b2CollidePolygons(manifold, polygonA, xfA, polygonB, xfB);
+	}
+}
+
+// Collides the primitives of shape A reported by its tree with a primitive of shape B.
+struct b2CompoundPrimitiveCallback
+{
+	bool QueryCallback(int32 indexA)
+	{
+		b2EdgeShape edge;
+		const b2Shape* primitiveA = b2GetPrimitive(shapeA, indexA, &edge);
+
+		b2Manifold manifold;
+		b2CollidePrimitives(&manifold, primitiveA, *xfA, primitiveB, *xfB);
+		if (manifold.pointCount > 0)
+		{
+			manifoldSet->Add(manifold, indexA * countB + indexB);
+		}
+
+		return true;
+	}
+
+	b2ManifoldSet* manifoldSet;
+	const b2Shape* shapeA;
+	const b2Shape* primitiveB;
+	const b2Transform* xfA;
+	const b2Transform* xfB;
+	int32 indexB;
+	int32 countB;
+};
+
+// Finds the primitives of shape A near each primitive of shape B reported by its tree.
+struct b2CompoundPairCallback
+{
+	bool QueryCallback(int32 indexB)
+	{
+		b2EdgeShape edge;
+		primitive.primitiveB = b2GetPrimitive(shapeB, indexB, &edge);
+		primitive.indexB = indexB;
+
+		// Only shape A has a tree here, so query it in its own frame.
+		b2AABB aabb;
+		primitive.primitiveB->ComputeAABB(&aabb, relativeXf, 0);
+
+		if (treeA)
+		{
+			treeA->Query(&primitive, aabb);
+		}
+		else
+		{
+			primitive.QueryCallback(indexA);
+		}
+
+		return true;
+	}
+
+	b2CompoundPrimitiveCallback primitive;
+	const b2StaticTree* treeA;
+	const b2Shape* shapeB;
+	b2Transform relativeXf;
+	int32 indexA;
+};
+
+void b2CompoundContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB)
+{
+	m_manifoldSet.Begin(*manifold);
+
+	const b2Shape* shapeA = m_fixtureA->GetShape();
+	const b2Shape* shapeB = m_fixtureB->GetShape();
+
+	b2CompoundPairCallback callback;
+	callback.treeA = NULL;
+	callback.shapeB = shapeB;
+	callback.relativeXf = b2MulT(xfA, xfB);
+	callback.indexA = 0;
+	callback.primitive.manifoldSet = &m_manifoldSet;
+	callback.primitive.shapeA = shapeA;
+	callback.primitive.xfA = &xfA;
+	callback.primitive.xfB = &xfB;
+	callback.primitive.countB = 1;
+
+	int32 countA = 1;
+	if (shapeA->GetType() == b2Shape::e_compound)
+	{
+		const b2CompoundShape* compoundA = (const b2CompoundShape*)shapeA;
+		callback.treeA = &compoundA->m_tree;
+		countA = compoundA->GetShapeCount();
+	}
+	else if (shapeA->GetType() == b2Shape::e_chain)
+	{
+		const b2ChainShape* chain = (const b2ChainShape*)shapeA;
+		if (chain->HasTree())
+		{
+			callback.treeA = &chain->m_tree;
+		}
+		else
+		{
+			callback.indexA = m_indexA;
+		}
+		countA = chain->GetEdgeCount();
+	}
+
+	if (shapeB->GetType() == b2Shape::e_compound)
+	{
+		const b2CompoundShape* compoundB = (const b2CompoundShape*)shapeB;
+		callback.primitive.countB = compoundB->GetShapeCount();
+
+		// The key of a pair of primitives must fit in an int32.
+		b2Assert(countA <= 0x7FFFFFFF / callback.primitive.countB);
+
+		// Find the primitives of B near shape A in the frame of B.
+		b2AABB aabb;
+		shapeA->ComputeAABB(&aabb, b2MulT(xfB, xfA), m_indexA);
+
+		// Edge bounds leave out the radius.
+		if (shapeA->GetType() == b2Shape::e_edge || shapeA->GetType() == b2Shape::e_chain)
+		{
+			b2Vec2 r(shapeA->m_radius, shapeA->m_radius);
+			aabb.lowerBound -= r;
+			aabb.upperBound += r;
+		}
+
+		compoundB->Query(&callback, aabb);
+	}
+	else
+	{
+		callback.QueryCallback(0);
+	}
+
+	B2_NOT_USED(countA);
+
+	m_manifoldSet.End(manifold, &m_extraManifolds, &m_extraManifoldCount);
+}
+
+void b2CompoundContact::SaveState(b2Snapshot* snapshot) const
+{
+	m_manifoldSet.SaveState(snapshot);
+}
+
+void b2CompoundContact::RestoreState(b2SnapshotReader* reader)
+{
+	m_manifoldSet.RestoreState(reader, &m_extraManifolds, &m_extraManifoldCount);
+}
@@ -0,0 +1,56 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_COMPOUND_CONTACT_H
+#define B2_COMPOUND_CONTACT_H
+
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Dynamics/Contacts/b2ManifoldSet.h>
+
+class b2BlockAllocator;
+
+/// A contact with a compound shape. Fixture A is the compound, an edge or a chain.
+/// Fixture B is a circle, a polygon, a capsule or a compound. The trees are used to
+/// find the pairs of primitives that are near each other and each touching pair gets
+/// a manifold.
+class b2CompoundContact : public b2Contact
+{
+public:
+	static b2Contact* Create(	b2Fixture* fixtureA, int32 indexA,
+								b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator);
+	static void Destroy(b2Contact* contact, b2BlockAllocator* allocator);
+
+	b2CompoundContact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2AllocatorInterface* memory);
+	~b2CompoundContact() {}
+
+	void Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB);
+
+	/// The manifolds are matched per pair of primitives in Evaluate.
+	void MatchImpulses(const b2Manifold& oldManifold);
+
+protected:
+
+	void SaveState(b2Snapshot* snapshot) const;
+	void RestoreState(b2SnapshotReader* reader);
+
+	// The manifolds keyed by pair of primitives.
+	b2ManifoldSet m_manifoldSet;
+};
+
+#endif
@@ -24,13 +24,22 @@
 #include <Box2D/Dynamics/Contacts/b2EdgeAndPolygonContact.h>
 #include <Box2D/Dynamics/Contacts/b2ChainAndCircleContact.h>
 #include <Box2D/Dynamics/Contacts/b2ChainAndPolygonContact.h>
+#include <Box2D/Dynamics/Contacts/b2CompoundContact.h>
+#include <Box2D/Dynamics/Contacts/b2CapsuleContact.h>
+#include <Box2D/Dynamics/Contacts/b2CapsuleAndCircleContact.h>
+#include <Box2D/Dynamics/Contacts/b2PolygonAndCapsuleContact.h>
+#include <Box2D/Dynamics/Contacts/b2EdgeAndCapsuleContact.h>
+#include <Box2D/Dynamics/Contacts/b2ChainAndCapsuleContact.h>
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
 
 #include <Box2D/Collision/b2Collision.h>
+#include <Box2D/Collision/b2Distance.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
 #include <Box2D/Collision/Shapes/b2Shape.h>
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2ContactManager.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
 
@@ -46,6 +55,17 @@ void b2Contact::InitializeRegisters()
 	AddType(b2EdgeAndPolygonContact::Create, b2EdgeAndPolygonContact::Destroy, b2Shape::e_edge, b2Shape::e_polygon);
 	AddType(b2ChainAndCircleContact::Create, b2ChainAndCircleContact::Destroy, b2Shape::e_chain, b2Shape::e_circle);
 	AddType(b2ChainAndPolygonContact::Create, b2ChainAndPolygonContact::Destroy, b2Shape::e_chain, b2Shape::e_polygon);
+	AddType(b2CompoundContact::Create, b2CompoundContact::Destroy, b2Shape::e_compound, b2Shape::e_circle);
+	AddType(b2CompoundContact::Create, b2CompoundContact::Destroy, b2Shape::e_compound, b2Shape::e_polygon);
+	AddType(b2CompoundContact::Create, b2CompoundContact::Destroy, b2Shape::e_compound, b2Shape::e_compound);
+	AddType(b2CompoundContact::Create, b2CompoundContact::Destroy, b2Shape::e_edge, b2Shape::e_compound);
+	AddType(b2CompoundContact::Create, b2CompoundContact::Destroy, b2Shape::e_chain, b2Shape::e_compound);
+	AddType(b2CompoundContact::Create, b2CompoundContact::Destroy, b2Shape::e_compound, b2Shape::e_capsule);
+	AddType(b2CapsuleContact::Create, b2CapsuleContact::Destroy, b2Shape::e_capsule, b2Shape::e_capsule);
+	AddType(b2CapsuleAndCircleContact::Create, b2CapsuleAndCircleContact::Destroy, b2Shape::e_capsule, b2Shape::e_circle);
+	AddType(b2PolygonAndCapsuleContact::Create, b2PolygonAndCapsuleContact::Destroy, b2Shape::e_polygon, b2Shape::e_capsule);
+	AddType(b2EdgeAndCapsuleContact::Create, b2EdgeAndCapsuleContact::Destroy, b2Shape::e_edge, b2Shape::e_capsule);
+	AddType(b2ChainAndCapsuleContact::Create, b2ChainAndCapsuleContact::Destroy, b2Shape::e_chain, b2Shape::e_capsule);
 }
 
 void b2Contact::AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destoryFcn,
@@ -105,9 +125,7 @@ void b2Contact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
 	b2Fixture* fixtureA = contact->m_fixtureA;
 	b2Fixture* fixtureB = contact->m_fixtureB;
 
-	if (contact->m_manifold.pointCount > 0 &&
-		fixtureA->IsSensor() == false &&
-		fixtureB->IsSensor() == false)
+	if (contact->m_manifold.pointCount > 0)
 	{
 		fixtureA->GetBody()->SetAwake(true);
 		fixtureB->GetBody()->SetAwake(true);
@@ -134,9 +152,11 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 	m_indexB = indexB;
 
 	m_manifold.pointCount = 0;
+	m_extraManifolds = NULL;
+	m_extraManifoldCount = 0;
 
-	m_prev = NULL;
-	m_next = NULL;
+	m_manager = NULL;
+	m_managerIndex = -1;
 
 	m_nodeA.contact = NULL;
 	m_nodeA.prev = NULL;
@@ -156,9 +176,102 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 	m_tangentSpeed = 0.0f;
 }
 
+void b2Contact::Update(b2ContactListener* listener, float32 speculativeTime)
+{
+	b2Contact* contact = this;
+	UpdateBatch(&contact, 1, listener, speculativeTime);
+}
+
+void b2Contact::UpdateBatch(b2Contact** contacts, int32 count, b2ContactListener* listener, float32 speculativeTime)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	b2Shape::Type typeA = contacts[0]->m_fixtureA->GetType();
+	b2Shape::Type typeB = contacts[0]->m_fixtureB->GetType();
+
+	switch (typeA * b2Shape::e_typeCount + typeB)
+	{
+	case b2Shape::e_circle * b2Shape::e_typeCount + b2Shape::e_circle:
+		UpdateBatch<b2CircleContact>(contacts, count, listener, speculativeTime);
+		break;
+
+	case b2Shape::e_polygon * b2Shape::e_typeCount + b2Shape::e_circle:
+		UpdateBatch<b2PolygonAndCircleContact>(contacts, count, listener, speculativeTime);
+		break;
+
+	case b2Shape::e_polygon * b2Shape::e_typeCount + b2Shape::e_polygon:
+		UpdateBatch<b2PolygonContact>(contacts, count, listener, speculativeTime);
+		break;
+
+	case b2Shape::e_edge * b2Shape::e_typeCount + b2Shape::e_circle:
+		UpdateBatch<b2EdgeAndCircleContact>(contacts, count, listener, speculativeTime);
+		break;
+
+	case b2Shape::e_edge * b2Shape::e_typeCount + b2Shape::e_polygon:
+		UpdateBatch<b2EdgeAndPolygonContact>(contacts, count, listener, speculativeTime);
+		break;
+
+	case b2Shape::e_chain * b2Shape::e_typeCount + b2Shape::e_circle:
+		UpdateBatch<b2ChainAndCircleContact>(contacts, count, listener, speculativeTime);
+		break;
+
+	case b2Shape::e_chain * b2Shape::e_typeCount + b2Shape::e_polygon:
+		UpdateBatch<b2ChainAndPolygonContact>(contacts, count, listener, speculativeTime);
+		break;
+
+	case b2Shape::e_compound * b2Shape::e_typeCount + b2Shape::e_circle:
+	case b2Shape::e_compound * b2Shape::e_typeCount + b2Shape::e_polygon:
+	case b2Shape::e_compound * b2Shape::e_typeCount + b2Shape::e_compound:
+	case b2Shape::e_edge * b2Shape::e_typeCount + b2Shape::e_compound:
+	case b2Shape::e_chain * b2Shape::e_typeCount + b2Shape::e_compound:
+	case b2Shape::e_compound * b2Shape::e_typeCount + b2Shape::e_capsule:
+		UpdateBatch<b2CompoundContact>(contacts, count, listener, speculativeTime);
+		break;
+
+	case b2Shape::e_capsule * b2Shape::e_typeCount + b2Shape::e_capsule:
+		UpdateBatch<b2CapsuleContact>(contacts, count, listener, speculativeTime);
+		break;
+
+	case b2Shape::e_capsule * b2Shape::e_typeCount + b2Shape::e_circle:
+		UpdateBatch<b2CapsuleAndCircleContact>(contacts, count, listener, speculativeTime);
+		break;
+
+	case b2Shape::e_polygon * b2Shape::e_typeCount + b2Shape::e_capsule:
+		UpdateBatch<b2PolygonAndCapsuleContact>(contacts, count, listener, speculativeTime);
+		break;
+
+	case b2Shape::e_edge * b2Shape::e_typeCount + b2Shape::e_capsule:
+		UpdateBatch<b2EdgeAndCapsuleContact>(contacts, count, listener, speculativeTime);
+		break;
+
+	case b2Shape::e_chain * b2Shape::e_typeCount + b2Shape::e_capsule:
+		UpdateBatch<b2ChainAndCapsuleContact>(contacts, count, listener, speculativeTime);
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+}
+
+template <typename T>
+void b2Contact::UpdateBatch(b2Contact** contacts, int32 count, b2ContactListener* listener, float32 speculativeTime)
+{
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Assert(contacts[i]->m_fixtureA->GetType() == contacts[0]->m_fixtureA->GetType());
+		b2Assert(contacts[i]->m_fixtureB->GetType() == contacts[0]->m_fixtureB->GetType());
+		contacts[i]->Update<T>(listener, speculativeTime);
+	}
+}
+
 // Update the contact manifold and touching status.
 // Note: do not assume the fixture AABBs are overlapping or are valid.
-void b2Contact::Update(b2ContactListener* listener)
+template <typename T>
+void b2Contact::Update(b2ContactListener* listener, float32 speculativeTime)
 {
 	b2Manifold oldManifold = m_manifold;
 
@@ -168,57 +281,61 @@ void b2Contact::Update(b2ContactListener* listener)
 	bool touching = false;
 	bool wasTouching = (m_flags & e_touchingFlag) == e_touchingFlag;
 
-	bool sensorA = m_fixtureA->IsSensor();
-	bool sensorB = m_fixtureB->IsSensor();
-	bool sensor = sensorA || sensorB;
-
 	b2Body* bodyA = m_fixtureA->GetBody();
 	b2Body* bodyB = m_fixtureB->GetBody();
 	const b2Transform& xfA = bodyA->GetTransform();
 	const b2Transform& xfB = bodyB->GetTransform();
+	b2Transform relativeXf = b2MulT(xfA, xfB);
 
-	// Is this contact a sensor?
-	if (sensor)
-	{
-		const b2Shape* shapeA = m_fixtureA->GetShape();
-		const b2Shape* shapeB = m_fixtureB->GetShape();
-		touching = b2TestOverlap(shapeA, m_indexA, shapeB, m_indexB, xfA, xfB);
+	// A speculative manifold is only reused by speculative updates. The time of
+	// impact solver and sub-steps need the points that actually touch.
+	bool speculativeManifold = (m_flags & e_speculativeFlag) == e_speculativeFlag;
 
-		// Sensors don't generate manifolds.
-		m_manifold.pointCount = 0;
+	if (CanReuseManifold(relativeXf) &&
+		(speculativeTime > 0.0f ? IsSlow(speculativeTime) : speculativeManifold == false))
+	{
+		// The manifold is stored in body local coordinates, so it follows the
+		// bodies. The solver recomputes the world points and separations from
+		// the current transforms. The warm starting impulses are kept as is.
 	}
 	else
 	{
-		Evaluate(&m_manifold, xfA, xfB);
-		touching = m_manifold.pointCount > 0;
+		m_flags &= ~e_speculativeFlag;
 
-		// Match old contact ids to new contact ids and copy the
-		// stored impulses to warm start the solver.
-		for (int32 i = 0; i < m_manifold.pointCount; ++i)
+		b2Vec2 shift;
+		if (speculativeTime > 0.0f && CanSpeculate())
 		{
-			b2ManifoldPoint* mp2 = m_manifold.points + i;
-			mp2->normalImpulse = 0.0f;
-			mp2->tangentImpulse = 0.0f;
-			b2ContactID id2 = mp2->id;
-
-			for (int32 j = 0; j < oldManifold.pointCount; ++j)
+			if (ComputeSpeculativeShift(&shift, xfA, xfB, speculativeTime))
 			{
-				b2ManifoldPoint* mp1 = oldManifold.points + j;
-
-				if (mp1->id.key == id2.key)
-				{
-					mp2->normalImpulse = mp1->normalImpulse;
-					mp2->tangentImpulse = mp1->tangentImpulse;
-					break;
-				}
+				// Collide with body B moved onto body A. The manifold is stored in
+				// body local coordinates, so at the current transforms the points
+				// that are not touching yet are apart and the solver treats them
+				// as speculative.
+				b2Transform xfShiftedB(xfB.p - shift, xfB.q);
+				static_cast<T*>(this)->T::Evaluate(&m_manifold, xfA, xfShiftedB);
+				m_flags |= e_speculativeFlag;
+			}
+			else
+			{
+				m_manifold.pointCount = 0;
 			}
 		}
-
-		if (touching != wasTouching)
+		else
 		{
-			bodyA->SetAwake(true);
-			bodyB->SetAwake(true);
+			static_cast<T*>(this)->T::Evaluate(&m_manifold, xfA, xfB);
 		}
+
+		static_cast<T*>(this)->T::MatchImpulses(oldManifold);
+		m_relativeXf = relativeXf;
+		m_flags |= e_manifoldCacheFlag;
+	}
+
+	touching = m_manifold.pointCount > 0;
+
+	if (touching != wasTouching)
+	{
+		bodyA->SetAwake(true);
+		bodyB->SetAwake(true);
 	}
 
 	if (touching)
@@ -240,8 +357,182 @@ void b2Contact::Update(b2ContactListener* listener)
 		listener->EndContact(this);
 	}
 
-	if (sensor == false && touching && listener)
+	if (touching && listener)
 	{
 		listener->PreSolve(this, &oldManifold);
 	}
 }
+
+void b2Contact::MatchImpulses(const b2Manifold& oldManifold)
+{
+	for (int32 i = 0; i < m_manifold.pointCount; ++i)
+	{
+		b2ManifoldPoint* mp2 = m_manifold.points + i;
+		mp2->normalImpulse = 0.0f;
+		mp2->tangentImpulse = 0.0f;
+		b2ContactID id2 = mp2->id;
+
+		for (int32 j = 0; j < oldManifold.pointCount; ++j)
+		{
+			const b2ManifoldPoint* mp1 = oldManifold.points + j;
+
+			if (mp1->id.key == id2.key)
+			{
+				mp2->normalImpulse = mp1->normalImpulse;
+				mp2->tangentImpulse = mp1->tangentImpulse;
+				break;
+			}
+		}
+	}
+}
+
+b2Contact* b2Contact::GetNext()
+{
+	if (m_manager == NULL || m_managerIndex + 1 >= m_manager->m_contactCount)
+	{
+		return NULL;
+	}
+
+	return m_manager->m_contacts[m_managerIndex + 1].contact;
+}
+
+const b2Contact* b2Contact::GetNext() const
+{
+	if (m_manager == NULL || m_managerIndex + 1 >= m_manager->m_contactCount)
+	{
+		return NULL;
+	}
+
+	return m_manager->m_contacts[m_managerIndex + 1].contact;
+}
+
+bool b2Contact::HasPrimitiveTree() const
+{
+	const b2Shape* shapes[2] = { m_fixtureA->GetShape(), m_fixtureB->GetShape() };
+	for (int32 i = 0; i < 2; ++i)
+	{
+		if (shapes[i]->GetType() == b2Shape::e_compound)
+		{
+			return true;
+		}
+
+		if (shapes[i]->GetType() == b2Shape::e_chain && ((const b2ChainShape*)shapes[i])->HasTree())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool b2Contact::CanSpeculate() const
+{
+	return HasPrimitiveTree() == false;
+}
+
+// Maximum distance of the proxy surface from the body center of mass.
+static float32 b2GetProxyExtent(const b2DistanceProxy& proxy, const b2Vec2& localCenter)
+{
+	float32 extentSquared = 0.0f;
+	for (int32 i = 0; i < proxy.m_count; ++i)
+	{
+		extentSquared = b2Max(extentSquared, b2DistanceSquared(proxy.m_vertices[i], localCenter));
+	}
+
+	return b2Sqrt(extentSquared) + proxy.m_radius;
+}
+
+bool b2Contact::ComputeSpeculativeShift(b2Vec2* shift, const b2Transform& xfA, const b2Transform& xfB, float32 speculativeTime) const
+{
+	b2DistanceInput input;
+	input.proxyA.Set(m_fixtureA->GetShape(), m_indexA);
+	input.proxyB.Set(m_fixtureB->GetShape(), m_indexB);
+	input.transformA = xfA;
+	input.transformB = xfB;
+	input.useRadii = false;
+
+	b2SimplexCache cache;
+	cache.count = 0;
+
+	b2DistanceOutput output;
+	b2Distance(&output, &cache, &input);
+
+	// Overlapping cores are already touching.
+	if (output.distance < 10.0f * b2_epsilon)
+	{
+		shift->SetZero();
+		return true;
+	}
+
+	b2Vec2 normal = (1.0f / output.distance) * (output.pointB - output.pointA);
+	float32 separation = output.distance - input.proxyA.m_radius - input.proxyB.m_radius;
+
+	// Predict the approach of the closest points over the step.
+	const b2Body* bodyA = m_fixtureA->GetBody();
+	const b2Body* bodyB = m_fixtureB->GetBody();
+	b2Vec2 vA = bodyA->LinearVelocity() + b2Cross(bodyA->AngularVelocity(), output.pointA - bodyA->Sweep().c);
+	b2Vec2 vB = bodyB->LinearVelocity() + b2Cross(bodyB->AngularVelocity(), output.pointB - bodyB->Sweep().c);
+	float32 approach = b2Max(-b2Dot(vB - vA, normal), 0.0f);
+
+	if (separation > approach * speculativeTime + b2_speculativeDistance)
+	{
+		return false;
+	}
+
+	// Features other than the closest ones may swing into contact while the
+	// bodies turn. The margin is bounded so the shifted shapes stay on their
+	// side of thin shapes such as edges.
+	float32 extentA = b2GetProxyExtent(input.proxyA, bodyA->Sweep().localCenter);
+	float32 extentB = b2GetProxyExtent(input.proxyB, bodyB->Sweep().localCenter);
+	float32 turn = (b2Abs(bodyA->AngularVelocity()) * extentA + b2Abs(bodyB->AngularVelocity()) * extentB) * speculativeTime;
+	float32 margin = b2Min(turn, b2Min(0.25f * b2Min(extentA, extentB), b2_maxLinearCorrection));
+
+	*shift = (separation + b2_speculativeDistance + margin) * normal;
+	return true;
+}
+
+bool b2Contact::IsSlow(float32 speculativeTime) const
+{
+	// Speculative points depend on the velocities. They are kept while the
+	// bodies can not close a gap noticeably over the step.
+	const b2Body* bodyA = m_fixtureA->GetBody();
+	const b2Body* bodyB = m_fixtureB->GetBody();
+	float32 linear = b2Distance(bodyA->LinearVelocity(), bodyB->LinearVelocity()) * speculativeTime;
+	float32 angular = (b2Abs(bodyA->AngularVelocity()) + b2Abs(bodyB->AngularVelocity())) * speculativeTime;
+	return linear < b2_linearSlop && angular < 0.1f * b2_angularSlop;
+}
+
+bool b2Contact::CanReuseManifold(const b2Transform& relativeXf) const
+{
+	if ((m_flags & e_manifoldCacheFlag) == 0)
+	{
+		return false;
+	}
+
+	// Change in relative rotation. Reject turns beyond 90 degrees where the
+	// sine no longer bounds the angle.
+	const b2Rot& q0 = m_relativeXf.q;
+	const b2Rot& q = relativeXf.q;
+	float32 sinAngle = q0.c * q.s - q0.s * q.c;
+	float32 cosAngle = q0.c * q.c + q0.s * q.s;
+	if (cosAngle <= 0.0f)
+	{
+		return false;
+	}
+
+	// Bound the motion of the manifold points under the change of relative transform.
+	float32 extentSquared = m_relativeXf.p.LengthSquared();
+	int32 manifoldCount = GetManifoldCount();
+	for (int32 i = 0; i < manifoldCount; ++i)
+	{
+		const b2Manifold* manifold = GetManifold(i);
+		extentSquared = b2Max(extentSquared, manifold->localPoint.LengthSquared());
+		for (int32 j = 0; j < manifold->pointCount; ++j)
+		{
+			extentSquared = b2Max(extentSquared, manifold->points[j].localPoint.LengthSquared());
+		}
+	}
+
+	float32 drift = b2Distance(relativeXf.p, m_relativeXf.p) + 2.0f * b2Sqrt(extentSquared) * b2Abs(sinAngle);
+	return drift < b2_manifoldReuseTolerance;
+}
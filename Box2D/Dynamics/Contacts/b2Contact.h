@@ -31,6 +31,9 @@ class b2World;
 class b2BlockAllocator;
 class b2StackAllocator;
 class b2ContactListener;
+class b2ContactManager;
+class b2Snapshot;
+class b2SnapshotReader;
 
 /// Friction mixing law. The idea is to allow either fixture to drive the restitution to zero.
 /// For example, anything slides on ice.
@@ -83,6 +86,14 @@ public:
 	b2Manifold* GetManifold();
 	const b2Manifold* GetManifold() const;
 
+	/// Get the number of manifolds. This is one except for contacts with a chain
+	/// that has a tree, which have a manifold per touching edge.
+	int32 GetManifoldCount() const;
+
+	/// Get a manifold. The first manifold is the one returned by GetManifold.
+	b2Manifold* GetManifold(int32 index);
+	const b2Manifold* GetManifold(int32 index) const;
+
 	/// Get the world manifold.
 	void GetWorldManifold(b2WorldManifold* worldManifold) const;
 
@@ -170,7 +181,16 @@ protected:
 		e_bulletHitFlag		= 0x0010,
 
 		// This contact has a valid TOI in m_toi
-		e_toiFlag			= 0x0020
+		e_toiFlag			= 0x0020,
+
+		// The manifold was computed at the relative transform in m_relativeXf
+		e_manifoldCacheFlag	= 0x0040,
+
+		// This contact is new and may be warm started from the impulse cache
+		e_impulseSeedFlag	= 0x0080,
+
+		// The manifold was computed ahead of time and may hold points that are apart
+		e_speculativeFlag	= 0x0100
 	};
 
 	/// Flag this contact for filtering. Filtering will occur the next time step.
@@ -187,16 +207,55 @@ protected:
 	b2Contact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB);
 	virtual ~b2Contact() {}
 
-	void Update(b2ContactListener* listener);
+	// A positive speculative time adds speculative points for features that may
+	// touch within that time. Use zero to disable speculative points.
+	void Update(b2ContactListener* listener, float32 speculativeTime);
+
+	// Update contacts that share the same pair of shape types. The narrow-phase
+	// kernel is selected once per batch so Evaluate is not dispatched virtually.
+	static void UpdateBatch(b2Contact** contacts, int32 count, b2ContactListener* listener, float32 speculativeTime);
+
+	template <typename T>
+	static void UpdateBatch(b2Contact** contacts, int32 count, b2ContactListener* listener, float32 speculativeTime);
+
+	template <typename T>
+	void Update(b2ContactListener* listener, float32 speculativeTime);
+
+	// Does a shape keep its children in a primitive tree? Such contacts keep
+	// several manifolds in a manifold set.
+	bool HasPrimitiveTree() const;
+
+	// Can this contact use speculative points? Contacts with a primitive tree
+	// have no single distance proxy and rely on time of impact instead.
+	bool CanSpeculate() const;
+
+	// Compute how far to move body B onto body A so that the narrow-phase finds the
+	// features that may touch within the given time. Returns false if the shapes
+	// stay apart.
+	bool ComputeSpeculativeShift(b2Vec2* shift, const b2Transform& xfA, const b2Transform& xfB, float32 speculativeTime) const;
+
+	// Are the bodies moving too slowly for the speculative points to change?
+	bool IsSlow(float32 speculativeTime) const;
+
+	// Can the manifold computed at m_relativeXf be reused at this relative transform?
+	bool CanReuseManifold(const b2Transform& relativeXf) const;
+
+	// Match old contact ids to new contact ids and copy the stored impulses to
+	// warm start the solver.
+	void MatchImpulses(const b2Manifold& oldManifold);
+
+	// Save and restore the state a contact type keeps beyond the base contact.
+	virtual void SaveState(b2Snapshot* snapshot) const { B2_NOT_USED(snapshot); }
+	virtual void RestoreState(b2SnapshotReader* reader) { B2_NOT_USED(reader); }
 
 	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 	static bool s_initialized;
 
 	uint32 m_flags;
 
-	// World pool and list pointers.
-	b2Contact* m_prev;
-	b2Contact* m_next;
+	// The owner and the position in its dense contact array.
+	b2ContactManager* m_manager;
+	int32 m_managerIndex;
 
 	// Nodes for connecting bodies.
 	b2ContactEdge m_nodeA;
@@ -210,6 +269,13 @@ protected:
 
 	b2Manifold m_manifold;
 
+	// Manifolds after the first one. Owned by the contact type that uses them.
+	b2Manifold* m_extraManifolds;
+	int32 m_extraManifoldCount;
+
+	// Relative transform of body B in body A when m_manifold was computed.
+	b2Transform m_relativeXf;
+
 	int32 m_toiCount;
 	float32 m_toi;
 
@@ -229,6 +295,23 @@ inline const b2Manifold* b2Contact::GetManifold() const
 	return &m_manifold;
 }
 
+inline int32 b2Contact::GetManifoldCount() const
+{
+	return 1 + m_extraManifoldCount;
+}
+
+inline b2Manifold* b2Contact::GetManifold(int32 index)
+{
+	b2Assert(0 <= index && index <= m_extraManifoldCount);
+	return index == 0 ? &m_manifold : m_extraManifolds + (index - 1);
+}
+
+inline const b2Manifold* b2Contact::GetManifold(int32 index) const
+{
+	b2Assert(0 <= index && index <= m_extraManifoldCount);
+	return index == 0 ? &m_manifold : m_extraManifolds + (index - 1);
+}
+
 inline void b2Contact::GetWorldManifold(b2WorldManifold* worldManifold) const
 {
 	const b2Body* bodyA = m_fixtureA->GetBody();
@@ -261,16 +344,6 @@ inline bool b2Contact::IsTouching() const
 	return (m_flags & e_touchingFlag) == e_touchingFlag;
 }
 
-inline b2Contact* b2Contact::GetNext()
-{
-	return m_next;
-}
-
-inline const b2Contact* b2Contact::GetNext() const
-{
-	return m_next;
-}
-
 inline b2Fixture* b2Contact::GetFixtureA()
 {
 	return m_fixtureA;
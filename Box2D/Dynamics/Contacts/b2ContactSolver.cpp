@@ -45,15 +45,23 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 {
 	m_step = def->step;
 	m_allocator = def->allocator;
-	m_count = def->count;
+	m_contactCount = def->count;
+	m_contacts = def->contacts;
+
+	m_count = 0;
+	for (int32 i = 0; i < m_contactCount; ++i)
+	{
+		m_count += m_contacts[i]->GetManifoldCount();
+	}
+
 	m_positionConstraints = (b2ContactPositionConstraint*)m_allocator->Allocate(m_count * sizeof(b2ContactPositionConstraint));
 	m_velocityConstraints = (b2ContactVelocityConstraint*)m_allocator->Allocate(m_count * sizeof(b2ContactVelocityConstraint));
 	m_positions = def->positions;
 	m_velocities = def->velocities;
-	m_contacts = def->contacts;
 
 	// Initialize position independent portions of the constraints.
-	for (int32 i = 0; i < m_count; ++i)
+	int32 constraintIndex = 0;
+	for (int32 i = 0; i < m_contactCount; ++i)
 	{
 		b2Contact* contact = m_contacts[i];
 
@@ -65,65 +73,75 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 		float32 radiusB = shapeB->m_radius;
 		b2Body* bodyA = fixtureA->GetBody();
 		b2Body* bodyB = fixtureB->GetBody();
-		b2Manifold* manifold = contact->GetManifold();
 
-		int32 pointCount = manifold->pointCount;
-		b2Assert(pointCount > 0);
-
-		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
-		vc->friction = contact->m_friction;
-		vc->restitution = contact->m_restitution;
-		vc->tangentSpeed = contact->m_tangentSpeed;
-		vc->indexA = bodyA->m_islandIndex;
-		vc->indexB = bodyB->m_islandIndex;
-		vc->invMassA = bodyA->m_invMass;
-		vc->invMassB = bodyB->m_invMass;
-		vc->invIA = bodyA->m_invI;
-		vc->invIB = bodyB->m_invI;
-		vc->contactIndex = i;
-		vc->pointCount = pointCount;
-		vc->K.SetZero();
-		vc->normalMass.SetZero();
-
-		b2ContactPositionConstraint* pc = m_positionConstraints + i;
-		pc->indexA = bodyA->m_islandIndex;
-		pc->indexB = bodyB->m_islandIndex;
-		pc->invMassA = bodyA->m_invMass;
-		pc->invMassB = bodyB->m_invMass;
-		pc->localCenterA = bodyA->m_sweep.localCenter;
-		pc->localCenterB = bodyB->m_sweep.localCenter;
-		pc->invIA = bodyA->m_invI;
-		pc->invIB = bodyB->m_invI;
-		pc->localNormal = manifold->localNormal;
-		pc->localPoint = manifold->localPoint;
-		pc->pointCount = pointCount;
-		pc->radiusA = radiusA;
-		pc->radiusB = radiusB;
-		pc->type = manifold->type;
-
-		for (int32 j = 0; j < pointCount; ++j)
+		int32 manifoldCount = contact->GetManifoldCount();
+		for (int32 k = 0; k < manifoldCount; ++k)
 		{
-			b2ManifoldPoint* cp = manifold->points + j;
-			b2VelocityConstraintPoint* vcp = vc->points + j;
-	
-			if (m_step.warmStarting)
-			{
-				vcp->normalImpulse = m_step.dtRatio * cp->normalImpulse;
-				vcp->tangentImpulse = m_step.dtRatio * cp->tangentImpulse;
-			}
-			else
+			b2Manifold* manifold = contact->GetManifold(k);
+
+			int32 pointCount = manifold->pointCount;
+			b2Assert(pointCount > 0);
+
+			b2ContactVelocityConstraint* vc = m_velocityConstraints + constraintIndex;
+			vc->friction = contact->m_friction;
+			vc->restitution = contact->m_restitution;
+			vc->tangentSpeed = contact->m_tangentSpeed;
+			vc->indexA = bodyA->m_islandIndex;
+			vc->indexB = bodyB->m_islandIndex;
+			vc->invMassA = bodyA->m_invMass;
+			vc->invMassB = bodyB->m_invMass;
+			vc->invIA = bodyA->m_invI;
+			vc->invIB = bodyB->m_invI;
+			vc->contactIndex = i;
+			vc->manifoldIndex = k;
+			vc->pointCount = pointCount;
+			vc->K.SetZero();
+			vc->normalMass.SetZero();
+
+			b2ContactPositionConstraint* pc = m_positionConstraints + constraintIndex;
+			pc->indexA = bodyA->m_islandIndex;
+			pc->indexB = bodyB->m_islandIndex;
+			pc->invMassA = bodyA->m_invMass;
+			pc->invMassB = bodyB->m_invMass;
+			pc->localCenterA = bodyA->Sweep().localCenter;
+			pc->localCenterB = bodyB->Sweep().localCenter;
+			pc->invIA = bodyA->m_invI;
+			pc->invIB = bodyB->m_invI;
+			pc->localNormal = manifold->localNormal;
+			pc->localPoint = manifold->localPoint;
+			pc->pointCount = pointCount;
+			pc->radiusA = radiusA;
+			pc->radiusB = radiusB;
+			pc->type = manifold->type;
+
+			for (int32 j = 0; j < pointCount; ++j)
 			{
-				vcp->normalImpulse = 0.0f;
-				vcp->tangentImpulse = 0.0f;
-			}
+				b2ManifoldPoint* cp = manifold->points + j;
+				b2VelocityConstraintPoint* vcp = vc->points + j;
+		
+				if (m_step.warmStarting)
+				{
+					vcp->normalImpulse = m_step.dtRatio * cp->normalImpulse;
+					vcp->tangentImpulse = m_step.dtRatio * cp->tangentImpulse;
+				}
+				else
+				{
+					vcp->normalImpulse = 0.0f;
+					vcp->tangentImpulse = 0.0f;
+				}
 
-			vcp->rA.SetZero();
-			vcp->rB.SetZero();
-			vcp->normalMass = 0.0f;
-			vcp->tangentMass = 0.0f;
-			vcp->velocityBias = 0.0f;
+				vcp->rA.SetZero();
+				vcp->rB.SetZero();
+				vcp->normalMass = 0.0f;
+				vcp->tangentMass = 0.0f;
+				vcp->velocityBias = 0.0f;
+				vcp->relativeVelocity = 0.0f;
+				vcp->maxNormalImpulse = 0.0f;
+
+				pc->localPoints[j] = cp->localPoint;
+			}
 
-			pc->localPoints[j] = cp->localPoint;
+			++constraintIndex;
 		}
 	}
 }
@@ -144,7 +162,7 @@ void b2ContactSolver::InitializeVelocityConstraints()
 
 		float32 radiusA = pc->radiusA;
 		float32 radiusB = pc->radiusB;
-		b2Manifold* manifold = m_contacts[vc->contactIndex]->GetManifold();
+		b2Manifold* manifold = m_contacts[vc->contactIndex]->GetManifold(vc->manifoldIndex);
 
 		int32 indexA = vc->indexA;
 		int32 indexB = vc->indexB;
@@ -206,7 +224,17 @@ void b2ContactSolver::InitializeVelocityConstraints()
 			// Setup a velocity bias for restitution.
 			vcp->velocityBias = 0.0f;
 			float32 vRel = b2Dot(vc->normal, vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA));
-			if (vRel < -b2_velocityThreshold)
+			vcp->relativeVelocity = vRel;
+			vcp->maxNormalImpulse = 0.0f;
+			if (m_step.speculative && worldManifold.separations[j] > 0.0f)
+			{
+				// Speculative point: allow the approach that closes the gap
+				// within the step. Restitution and friction apply once the
+				// shapes touch.
+				vcp->velocityBias = -m_step.inv_dt * worldManifold.separations[j];
+				vcp->tangentMass = 0.0f;
+			}
+			else if (vRel < -b2_velocityThreshold)
 			{
 				vcp->velocityBias = -vc->restitution * vRel;
 			}
@@ -286,8 +314,11 @@ void b2ContactSolver::WarmStart()
 	}
 }
 
-void b2ContactSolver::SolveVelocityConstraints()
+void b2ContactSolver::SolveVelocityConstraints(float32* linearResidual, float32* angularResidual)
 {
+	float32 maxLinear = 0.0f;
+	float32 maxAngular = 0.0f;
+
 	for (int32 i = 0; i < m_count; ++i)
 	{
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
@@ -332,12 +363,16 @@ void b2ContactSolver::SolveVelocityConstraints()
 
 			// Apply contact impulse
 			b2Vec2 P = lambda * tangent;
+			float32 dwA = iA * b2Cross(vcp->rA, P);
+			float32 dwB = iB * b2Cross(vcp->rB, P);
+			maxLinear = b2Max(maxLinear, b2Abs(lambda) * (mA + mB));
+			maxAngular = b2Max(maxAngular, b2Max(b2Abs(dwA), b2Abs(dwB)));
 
 			vA -= mA * P;
-			wA -= iA * b2Cross(vcp->rA, P);
+			wA -= dwA;
 
 			vB += mB * P;
-			wB += iB * b2Cross(vcp->rB, P);
+			wB += dwB;
 		}
 
 		// Solve normal constraints
@@ -359,11 +394,16 @@ void b2ContactSolver::SolveVelocityConstraints()
 
 			// Apply contact impulse
 			b2Vec2 P = lambda * normal;
+			float32 dwA = iA * b2Cross(vcp->rA, P);
+			float32 dwB = iB * b2Cross(vcp->rB, P);
+			maxLinear = b2Max(maxLinear, b2Abs(lambda) * (mA + mB));
+			maxAngular = b2Max(maxAngular, b2Max(b2Abs(dwA), b2Abs(dwB)));
+
 			vA -= mA * P;
-			wA -= iA * b2Cross(vcp->rA, P);
+			wA -= dwA;
 
 			vB += mB * P;
-			wB += iB * b2Cross(vcp->rB, P);
+			wB += dwB;
 		}
 		else
 		{
@@ -587,6 +627,16 @@ void b2ContactSolver::SolveVelocityConstraints()
 				// No solution, give up. This is hit sometimes, but it doesn't seem to matter.
 				break;
 			}
+
+			float32 impulse1 = cp1->normalImpulse - a.x;
+			float32 impulse2 = cp2->normalImpulse - a.y;
+			maxLinear = b2Max(maxLinear, b2Max(b2Abs(impulse1), b2Abs(impulse2)) * (mA + mB));
+
+			b2Vec2 P1 = impulse1 * normal;
+			b2Vec2 P2 = impulse2 * normal;
+			float32 dwA = iA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
+			float32 dwB = iB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
+			maxAngular = b2Max(maxAngular, b2Max(b2Abs(dwA), b2Abs(dwB)));
 		}
 
 		m_velocities[indexA].v = vA;
@@ -594,6 +644,9 @@ void b2ContactSolver::SolveVelocityConstraints()
 		m_velocities[indexB].v = vB;
 		m_velocities[indexB].w = wB;
 	}
+
+	*linearResidual = b2Max(*linearResidual, maxLinear);
+	*angularResidual = b2Max(*angularResidual, maxAngular);
 }
 
 void b2ContactSolver::StoreImpulses()
@@ -601,7 +654,7 @@ void b2ContactSolver::StoreImpulses()
 	for (int32 i = 0; i < m_count; ++i)
 	{
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
-		b2Manifold* manifold = m_contacts[vc->contactIndex]->GetManifold();
+		b2Manifold* manifold = m_contacts[vc->contactIndex]->GetManifold(vc->manifoldIndex);
 
 		for (int32 j = 0; j < vc->pointCount; ++j)
 		{
@@ -831,3 +884,285 @@ bool b2ContactSolver::SolveTOIPositionConstraints(int32 toiIndexA, int32 toiInde
 	// push the separation above -b2_linearSlop.
 	return minSeparation >= -1.5f * b2_linearSlop;
 }
+
+// Sequential position solver for shock propagation. The contacts are sorted bottom-up
+// and the lower body of each contact is treated as immovable, so a single pass carries
+// the correction of each level up to the next.
+bool b2ContactSolver::SolveShockPositionConstraints(const int32* levels)
+{
+	float32 minSeparation = 0.0f;
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2ContactPositionConstraint* pc = m_positionConstraints + i;
+
+		int32 indexA = pc->indexA;
+		int32 indexB = pc->indexB;
+		b2Vec2 localCenterA = pc->localCenterA;
+		float32 mA = pc->invMassA;
+		float32 iA = pc->invIA;
+		b2Vec2 localCenterB = pc->localCenterB;
+		float32 mB = pc->invMassB;
+		float32 iB = pc->invIB;
+		int32 pointCount = pc->pointCount;
+
+		if (levels[indexA] < levels[indexB])
+		{
+			mA = 0.0f;
+			iA = 0.0f;
+		}
+		else if (levels[indexB] < levels[indexA])
+		{
+			mB = 0.0f;
+			iB = 0.0f;
+		}
+
+		b2Vec2 cA = m_positions[indexA].c;
+		float32 aA = m_positions[indexA].a;
+
+		b2Vec2 cB = m_positions[indexB].c;
+		float32 aB = m_positions[indexB].a;
+
+		// Solve normal constraints
+		for (int32 j = 0; j < pointCount; ++j)
+		{
+			b2Transform xfA, xfB;
+			xfA.q.Set(aA);
+			xfB.q.Set(aB);
+			xfA.p = cA - b2Mul(xfA.q, localCenterA);
+			xfB.p = cB - b2Mul(xfB.q, localCenterB);
+
+			b2PositionSolverManifold psm;
+			psm.Initialize(pc, xfA, xfB, j);
+			b2Vec2 normal = psm.normal;
+
+			b2Vec2 point = psm.point;
+			float32 separation = psm.separation;
+
+			b2Vec2 rA = point - cA;
+			b2Vec2 rB = point - cB;
+
+			// Track max constraint error.
+			minSeparation = b2Min(minSeparation, separation);
+
+			// Prevent large corrections and allow slop.
+			float32 C = b2Clamp(b2_baumgarte * (separation + b2_linearSlop), -b2_maxLinearCorrection, 0.0f);
+
+			// Compute the effective mass.
+			float32 rnA = b2Cross(rA, normal);
+			float32 rnB = b2Cross(rB, normal);
+			float32 K = mA + mB + iA * rnA * rnA + iB * rnB * rnB;
+
+			// Compute normal impulse
+			float32 impulse = K > 0.0f ? - C / K : 0.0f;
+
+			b2Vec2 P = impulse * normal;
+
+			cA -= mA * P;
+			aA -= iA * b2Cross(rA, P);
+
+			cB += mB * P;
+			aB += iB * b2Cross(rB, P);
+		}
+
+		m_positions[indexA].c = cA;
+		m_positions[indexA].a = aA;
+
+		m_positions[indexB].c = cB;
+		m_positions[indexB].a = aB;
+	}
+
+	return minSeparation >= -3.0f * b2_linearSlop;
+}
+
+void b2ContactSolver::PrepareSoftConstraints(float32 h)
+{
+	// A stiff, heavily damped spring. The stiffness is limited by the substep
+	// rate so the spring stays stable.
+	float32 contactHertz = b2Min(b2_contactHertz, 0.25f / h);
+	float32 omega = 2.0f * b2_pi * contactHertz;
+	float32 a1 = 2.0f * b2_contactDampingRatio + h * omega;
+	float32 a2 = h * omega * a1;
+	float32 a3 = 1.0f / (1.0f + a2);
+
+	m_softInvH = 1.0f / h;
+	m_softBiasRate = omega / a1;
+	m_softMassScale = a2 * a3;
+	m_softImpulseScale = a3;
+
+	// The substeps track the separation linearly from the positions at the start
+	// of the step. This avoids rebuilding the transforms in every solve.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		b2ContactPositionConstraint* pc = m_positionConstraints + i;
+
+		vc->positionA0 = m_positions[vc->indexA];
+		vc->positionB0 = m_positions[vc->indexB];
+
+		b2Transform xfA, xfB;
+		xfA.q.Set(vc->positionA0.a);
+		xfB.q.Set(vc->positionB0.a);
+		xfA.p = vc->positionA0.c - b2Mul(xfA.q, pc->localCenterA);
+		xfB.p = vc->positionB0.c - b2Mul(xfB.q, pc->localCenterB);
+
+		for (int32 j = 0; j < vc->pointCount; ++j)
+		{
+			b2PositionSolverManifold psm;
+			psm.Initialize(pc, xfA, xfB, j);
+			vc->points[j].baseSeparation = psm.separation;
+		}
+	}
+}
+
+void b2ContactSolver::SolveSoftVelocityConstraints(bool useBias)
+{
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+
+		int32 indexA = vc->indexA;
+		int32 indexB = vc->indexB;
+		float32 mA = vc->invMassA;
+		float32 iA = vc->invIA;
+		float32 mB = vc->invMassB;
+		float32 iB = vc->invIB;
+		int32 pointCount = vc->pointCount;
+
+		b2Vec2 vA = m_velocities[indexA].v;
+		float32 wA = m_velocities[indexA].w;
+		b2Vec2 vB = m_velocities[indexB].v;
+		float32 wB = m_velocities[indexB].w;
+
+		b2Vec2 dcA = m_positions[indexA].c - vc->positionA0.c;
+		float32 daA = m_positions[indexA].a - vc->positionA0.a;
+		b2Vec2 dcB = m_positions[indexB].c - vc->positionB0.c;
+		float32 daB = m_positions[indexB].a - vc->positionB0.a;
+
+		b2Vec2 normal = vc->normal;
+		b2Vec2 tangent = b2Cross(normal, 1.0f);
+		float32 friction = vc->friction;
+
+		// Solve normal constraints one point at a time against the current separation.
+		for (int32 j = 0; j < pointCount; ++j)
+		{
+			b2VelocityConstraintPoint* vcp = vc->points + j;
+
+			b2Vec2 d = dcB + b2Cross(daB, vcp->rB) - dcA - b2Cross(daA, vcp->rA);
+			float32 separation = b2Dot(d, normal) + vcp->baseSeparation;
+
+			float32 bias = 0.0f;
+			float32 massScale = 1.0f;
+			float32 impulseScale = 0.0f;
+			if (separation > 0.0f)
+			{
+				// Speculative: allow the approach that closes the gap.
+				bias = separation * m_softInvH;
+			}
+			else if (useBias)
+			{
+				bias = b2Max(m_softBiasRate * b2Min(separation + b2_linearSlop, 0.0f), -b2_contactPushVelocity);
+				massScale = m_softMassScale;
+				impulseScale = m_softImpulseScale;
+			}
+
+			b2Vec2 dv = vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA);
+			float32 vn = b2Dot(dv, normal);
+
+			float32 lambda = -vcp->normalMass * massScale * (vn + bias) - impulseScale * vcp->normalImpulse;
+			float32 newImpulse = b2Max(vcp->normalImpulse + lambda, 0.0f);
+			lambda = newImpulse - vcp->normalImpulse;
+			vcp->normalImpulse = newImpulse;
+			vcp->maxNormalImpulse = b2Max(vcp->maxNormalImpulse, lambda);
+
+			b2Vec2 P = lambda * normal;
+			vA -= mA * P;
+			wA -= iA * b2Cross(vcp->rA, P);
+			vB += mB * P;
+			wB += iB * b2Cross(vcp->rB, P);
+		}
+
+		// Friction uses the normal impulses of this pass.
+		for (int32 j = 0; j < pointCount; ++j)
+		{
+			b2VelocityConstraintPoint* vcp = vc->points + j;
+
+			b2Vec2 dv = vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA);
+			float32 vt = b2Dot(dv, tangent) - vc->tangentSpeed;
+			float32 lambda = vcp->tangentMass * (-vt);
+
+			float32 maxFriction = friction * vcp->normalImpulse;
+			float32 newImpulse = b2Clamp(vcp->tangentImpulse + lambda, -maxFriction, maxFriction);
+			lambda = newImpulse - vcp->tangentImpulse;
+			vcp->tangentImpulse = newImpulse;
+
+			b2Vec2 P = lambda * tangent;
+			vA -= mA * P;
+			wA -= iA * b2Cross(vcp->rA, P);
+			vB += mB * P;
+			wB += iB * b2Cross(vcp->rB, P);
+		}
+
+		m_velocities[indexA].v = vA;
+		m_velocities[indexA].w = wA;
+		m_velocities[indexB].v = vB;
+		m_velocities[indexB].w = wB;
+	}
+}
+
+void b2ContactSolver::ApplyRestitution()
+{
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		if (vc->restitution == 0.0f)
+		{
+			continue;
+		}
+
+		int32 indexA = vc->indexA;
+		int32 indexB = vc->indexB;
+		float32 mA = vc->invMassA;
+		float32 iA = vc->invIA;
+		float32 mB = vc->invMassB;
+		float32 iB = vc->invIB;
+		int32 pointCount = vc->pointCount;
+
+		b2Vec2 vA = m_velocities[indexA].v;
+		float32 wA = m_velocities[indexA].w;
+		b2Vec2 vB = m_velocities[indexB].v;
+		float32 wB = m_velocities[indexB].w;
+
+		b2Vec2 normal = vc->normal;
+
+		for (int32 j = 0; j < pointCount; ++j)
+		{
+			b2VelocityConstraintPoint* vcp = vc->points + j;
+
+			// Only bounce points that approached fast and were pushed apart.
+			if (vcp->relativeVelocity > -b2_velocityThreshold || vcp->maxNormalImpulse == 0.0f)
+			{
+				continue;
+			}
+
+			b2Vec2 dv = vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA);
+			float32 vn = b2Dot(dv, normal);
+
+			float32 lambda = -vcp->normalMass * (vn + vc->restitution * vcp->relativeVelocity);
+			float32 newImpulse = b2Max(vcp->normalImpulse + lambda, 0.0f);
+			lambda = newImpulse - vcp->normalImpulse;
+			vcp->normalImpulse = newImpulse;
+
+			b2Vec2 P = lambda * normal;
+			vA -= mA * P;
+			wA -= iA * b2Cross(vcp->rA, P);
+			vB += mB * P;
+			wB += iB * b2Cross(vcp->rB, P);
+		}
+
+		m_velocities[indexA].v = vA;
+		m_velocities[indexA].w = wA;
+		m_velocities[indexB].v = vB;
+		m_velocities[indexB].w = wB;
+	}
+}
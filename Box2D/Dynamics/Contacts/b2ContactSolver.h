@@ -37,6 +37,9 @@ struct b2VelocityConstraintPoint
 	float32 normalMass;
 	float32 tangentMass;
 	float32 velocityBias;
+	float32 relativeVelocity;
+	float32 maxNormalImpulse;
+	float32 baseSeparation;
 };
 
 struct b2ContactVelocityConstraint
@@ -54,6 +57,8 @@ struct b2ContactVelocityConstraint
 	float32 tangentSpeed;
 	int32 pointCount;
 	int32 contactIndex;
+	int32 manifoldIndex;
+	b2Position positionA0, positionB0;
 };
 
 struct b2ContactSolverDef
@@ -75,12 +80,26 @@ public:
 	void InitializeVelocityConstraints();
 
 	void WarmStart();
-	void SolveVelocityConstraints();
+
+	// The residuals grow to the largest linear and angular velocity change caused
+	// by an impulse in the pass.
+	void SolveVelocityConstraints(float32* linearResidual, float32* angularResidual);
 	void StoreImpulses();
 
 	bool SolvePositionConstraints();
 	bool SolveTOIPositionConstraints(int32 toiIndexA, int32 toiIndexB);
 
+	// Shock propagation. The levels give each body's distance from a static support.
+	// The lower body of a contact between two levels is treated as immovable.
+	bool SolveShockPositionConstraints(const int32* levels);
+
+	// Soft step solver. The contacts are soft springs tuned for the substep length h.
+	// With bias the springs push overlap out, without bias the velocities are relaxed
+	// to remove the energy the springs added.
+	void PrepareSoftConstraints(float32 h);
+	void SolveSoftVelocityConstraints(bool useBias);
+	void ApplyRestitution();
+
 	b2TimeStep m_step;
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
@@ -88,7 +107,16 @@ public:
 	b2ContactPositionConstraint* m_positionConstraints;
 	b2ContactVelocityConstraint* m_velocityConstraints;
 	b2Contact** m_contacts;
+	int m_contactCount;
+
+	// The number of constraints. Each contact manifold is a constraint.
 	int m_count;
+
+	// Soft step substep parameters.
+	float32 m_softInvH;
+	float32 m_softBiasRate;
+	float32 m_softMassScale;
+	float32 m_softImpulseScale;
 };
 
 #endif
@@ -0,0 +1,187 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Dynamics/Contacts/b2ImpulseCache.h>
+#include <Box2D/Common/b2AllocatorInterface.h>
+#include <Box2D/Common/b2Snapshot.h>
+#include <memory.h>
+
+b2ImpulseCache::b2ImpulseCache(b2AllocatorInterface* allocator)
+{
+	m_memory = allocator ? allocator : b2GetDefaultAllocator();
+	m_entries = NULL;
+	m_stamp = 1;
+	m_storeStamp = 0;
+}
+
+b2ImpulseCache::~b2ImpulseCache()
+{
+	m_memory->Free(m_entries);
+}
+
+void b2ImpulseCache::Clear()
+{
+	if (m_entries != NULL)
+	{
+		memset(m_entries, 0, b2_impulseCacheSize * sizeof(b2ImpulseEntry));
+	}
+	m_storeStamp = 0;
+}
+
+void b2ImpulseCache::SaveState(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_stamp);
+	snapshot->Write(m_storeStamp);
+
+	// The table is only allocated once an entry is stored.
+	bool hasEntries = m_entries != NULL;
+	snapshot->Write(hasEntries);
+	if (hasEntries)
+	{
+		snapshot->Write(m_entries, b2_impulseCacheSize * sizeof(b2ImpulseEntry));
+	}
+}
+
+void b2ImpulseCache::RestoreState(b2SnapshotReader* reader)
+{
+	m_stamp = reader->Read<uint32>();
+	m_storeStamp = reader->Read<uint32>();
+
+	bool hasEntries = reader->Read<bool>();
+	if (hasEntries)
+	{
+		if (m_entries == NULL)
+		{
+			m_entries = (b2ImpulseEntry*)m_memory->Allocate(b2_impulseCacheSize * sizeof(b2ImpulseEntry));
+		}
+		reader->Read(m_entries, b2_impulseCacheSize * sizeof(b2ImpulseEntry));
+	}
+	else if (m_entries != NULL)
+	{
+		memset(m_entries, 0, b2_impulseCacheSize * sizeof(b2ImpulseEntry));
+	}
+}
+
+// Put the pair in a fixed order so that a contact created with its fixtures
+// swapped finds the same entry. The contact feature is swapped along with it.
+static inline void b2OrderPair(uint32& fixtureA, int32& indexA,
+							   uint32& fixtureB, int32& indexB, b2ContactID& id)
+{
+	if (fixtureB < fixtureA)
+	{
+		b2Swap(fixtureA, fixtureB);
+		b2Swap(indexA, indexB);
+		b2Swap(id.cf.indexA, id.cf.indexB);
+		b2Swap(id.cf.typeA, id.cf.typeB);
+	}
+}
+
+static inline uint32 b2HashPair(uint32 fixtureA, int32 indexA,
+								uint32 fixtureB, int32 indexB, uint32 key)
+{
+	uint32 hash = fixtureA;
+	hash = hash * 0x9E3779B1u ^ fixtureB;
+	hash = hash * 0x9E3779B1u ^ uint32(indexA);
+	hash = hash * 0x9E3779B1u ^ uint32(indexB);
+	hash = hash * 0x9E3779B1u ^ key;
+	hash ^= hash >> 15;
+	return hash & (b2_impulseCacheSize - 1);
+}
+
+b2ImpulseCache::b2ImpulseEntry* b2ImpulseCache::Find(uint32 fixtureA, int32 indexA,
+													 uint32 fixtureB, int32 indexB, b2ContactID id) const
+{
+	if (m_entries == NULL)
+	{
+		return NULL;
+	}
+
+	b2OrderPair(fixtureA, indexA, fixtureB, indexB, id);
+	b2ImpulseEntry* entry = m_entries + b2HashPair(fixtureA, indexA, fixtureB, indexB, id.key);
+
+	if (entry->stamp == 0 || m_stamp - entry->stamp > b2_impulseCacheLifetime)
+	{
+		return NULL;
+	}
+
+	if (entry->fixtureA != fixtureA || entry->fixtureB != fixtureB ||
+		entry->indexA != indexA || entry->indexB != indexB || entry->key != id.key)
+	{
+		return NULL;
+	}
+
+	return entry;
+}
+
+void b2ImpulseCache::Store(uint32 fixtureA, int32 indexA,
+						   uint32 fixtureB, int32 indexB, const b2Manifold& manifold)
+{
+	for (int32 i = 0; i < manifold.pointCount; ++i)
+	{
+		const b2ManifoldPoint& mp = manifold.points[i];
+		if (mp.normalImpulse == 0.0f && mp.tangentImpulse == 0.0f)
+		{
+			continue;
+		}
+
+		if (m_entries == NULL)
+		{
+			m_entries = (b2ImpulseEntry*)m_memory->Allocate(b2_impulseCacheSize * sizeof(b2ImpulseEntry));
+			memset(m_entries, 0, b2_impulseCacheSize * sizeof(b2ImpulseEntry));
+		}
+
+		uint32 fA = fixtureA;
+		uint32 fB = fixtureB;
+		int32 iA = indexA;
+		int32 iB = indexB;
+		b2ContactID id = mp.id;
+		b2OrderPair(fA, iA, fB, iB, id);
+
+		b2ImpulseEntry* entry = m_entries + b2HashPair(fA, iA, fB, iB, id.key);
+		entry->fixtureA = fA;
+		entry->fixtureB = fB;
+		entry->indexA = iA;
+		entry->indexB = iB;
+		entry->key = id.key;
+		entry->stamp = m_stamp;
+		entry->normalImpulse = mp.normalImpulse;
+		entry->tangentImpulse = mp.tangentImpulse;
+
+		m_storeStamp = m_stamp;
+	}
+}
+
+bool b2ImpulseCache::Seed(uint32 fixtureA, int32 indexA,
+						  uint32 fixtureB, int32 indexB, b2Manifold* manifold) const
+{
+	bool seeded = false;
+	for (int32 i = 0; i < manifold->pointCount; ++i)
+	{
+		b2ManifoldPoint* mp = manifold->points + i;
+		const b2ImpulseEntry* entry = Find(fixtureA, indexA, fixtureB, indexB, mp->id);
+		if (entry)
+		{
+			mp->normalImpulse = entry->normalImpulse;
+			mp->tangentImpulse = entry->tangentImpulse;
+			seeded = true;
+		}
+	}
+
+	return seeded;
+}
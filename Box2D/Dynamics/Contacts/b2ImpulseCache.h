@@ -0,0 +1,98 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_IMPULSE_CACHE_H
+#define B2_IMPULSE_CACHE_H
+
+#include <Box2D/Collision/b2Collision.h>
+
+class b2AllocatorInterface;
+class b2Snapshot;
+class b2SnapshotReader;
+
+/// Keeps the impulses of recently destroyed contacts. A contact between the same
+/// fixture children that is created again within b2_impulseCacheLifetime steps is
+/// warm started from the impulses of its manifold points that match by id.
+/// Fixtures are named by their id rather than their address, so a fixture created
+/// where a destroyed one used to live does not pick up its impulses.
+/// The cache is a fixed size table. An entry replaces any older entry in its slot.
+class b2ImpulseCache
+{
+public:
+	b2ImpulseCache(b2AllocatorInterface* allocator = NULL);
+	~b2ImpulseCache();
+
+	/// Age the entries by one time step.
+	void Step();
+
+	/// Store the impulses of a manifold that is about to be destroyed.
+	void Store(uint32 fixtureA, int32 indexA,
+			   uint32 fixtureB, int32 indexB, const b2Manifold& manifold);
+
+	/// Copy the stored impulses into the points of a new manifold.
+	/// @return true if any point was seeded.
+	bool Seed(uint32 fixtureA, int32 indexA,
+			  uint32 fixtureB, int32 indexB, b2Manifold* manifold) const;
+
+	/// Is any entry young enough to seed a contact?
+	bool IsLive() const;
+
+	/// Drop all the entries.
+	void Clear();
+
+	/// Write the entries to a snapshot.
+	void SaveState(b2Snapshot* snapshot) const;
+
+	/// Read the entries back from a snapshot.
+	void RestoreState(b2SnapshotReader* reader);
+
+private:
+
+	struct b2ImpulseEntry
+	{
+		uint32 fixtureA;
+		uint32 fixtureB;
+		int32 indexA;
+		int32 indexB;
+		uint32 key;
+		uint32 stamp;
+		float32 normalImpulse;
+		float32 tangentImpulse;
+	};
+
+	b2ImpulseEntry* Find(uint32 fixtureA, int32 indexA,
+						 uint32 fixtureB, int32 indexB, b2ContactID id) const;
+
+	b2AllocatorInterface* m_memory;
+	b2ImpulseEntry* m_entries;
+	uint32 m_stamp;
+	uint32 m_storeStamp;
+};
+
+inline void b2ImpulseCache::Step()
+{
+	++m_stamp;
+}
+
+inline bool b2ImpulseCache::IsLive() const
+{
+	return m_storeStamp != 0 && m_stamp - m_storeStamp <= b2_impulseCacheLifetime;
+}
+
+#endif
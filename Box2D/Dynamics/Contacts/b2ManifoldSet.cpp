@@ -0,0 +1,175 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Dynamics/Contacts/b2ManifoldSet.h>
+#include <Box2D/Common/b2AllocatorInterface.h>
+#include <Box2D/Common/b2Snapshot.h>
+#include <memory.h>
+
+b2ManifoldSet::b2ManifoldSet(b2AllocatorInterface* allocator)
+{
+	m_memory = allocator;
+
+	m_manifolds = NULL;
+	m_keys = NULL;
+	m_count = 0;
+	m_capacity = 0;
+
+	m_oldManifolds = NULL;
+	m_oldKeys = NULL;
+	m_oldCount = 0;
+	m_oldCapacity = 0;
+}
+
+b2ManifoldSet::~b2ManifoldSet()
+{
+	m_memory->Free(m_manifolds);
+	m_memory->Free(m_keys);
+	m_memory->Free(m_oldManifolds);
+	m_memory->Free(m_oldKeys);
+}
+
+void b2ManifoldSet::Begin(const b2Manifold& first)
+{
+	// Bring back the impulses of the first manifold.
+	if (m_count > 0)
+	{
+		m_manifolds[0] = first;
+	}
+
+	// Keep the current manifolds to warm start the new ones.
+	b2Swap(m_manifolds, m_oldManifolds);
+	b2Swap(m_keys, m_oldKeys);
+	b2Swap(m_capacity, m_oldCapacity);
+	m_oldCount = m_count;
+	m_count = 0;
+}
+
+void b2ManifoldSet::Add(const b2Manifold& manifold, int32 key)
+{
+	if (m_count == m_capacity)
+	{
+		b2Manifold* oldManifolds = m_manifolds;
+		int32* oldKeys = m_keys;
+		m_capacity = m_capacity == 0 ? 4 : 2 * m_capacity;
+		m_manifolds = (b2Manifold*)m_memory->Allocate(m_capacity * sizeof(b2Manifold));
+		m_keys = (int32*)m_memory->Allocate(m_capacity * sizeof(int32));
+		memcpy(m_manifolds, oldManifolds, m_count * sizeof(b2Manifold));
+		memcpy(m_keys, oldKeys, m_count * sizeof(int32));
+		m_memory->Free(oldManifolds);
+		m_memory->Free(oldKeys);
+	}
+
+	m_manifolds[m_count] = manifold;
+	m_keys[m_count] = key;
+	++m_count;
+}
+
+void b2ManifoldSet::End(b2Manifold* first, b2Manifold** extra, int32* extraCount)
+{
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2Manifold* m2 = m_manifolds + i;
+		for (int32 k = 0; k < m2->pointCount; ++k)
+		{
+			m2->points[k].normalImpulse = 0.0f;
+			m2->points[k].tangentImpulse = 0.0f;
+		}
+
+		const b2Manifold* m1 = NULL;
+		for (int32 j = 0; j < m_oldCount; ++j)
+		{
+			if (m_oldKeys[j] == m_keys[i])
+			{
+				m1 = m_oldManifolds + j;
+				break;
+			}
+		}
+
+		if (m1 == NULL)
+		{
+			continue;
+		}
+
+		for (int32 k = 0; k < m2->pointCount; ++k)
+		{
+			b2ManifoldPoint* mp2 = m2->points + k;
+			for (int32 j = 0; j < m1->pointCount; ++j)
+			{
+				const b2ManifoldPoint* mp1 = m1->points + j;
+				if (mp1->id.key == mp2->id.key)
+				{
+					mp2->normalImpulse = mp1->normalImpulse;
+					mp2->tangentImpulse = mp1->tangentImpulse;
+					break;
+				}
+			}
+		}
+	}
+
+	if (m_count > 0)
+	{
+		*first = m_manifolds[0];
+		*extra = m_manifolds + 1;
+		*extraCount = m_count - 1;
+	}
+	else
+	{
+		first->pointCount = 0;
+		*extra = NULL;
+		*extraCount = 0;
+	}
+}
+
+void b2ManifoldSet::SaveState(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_count);
+	snapshot->Write(m_keys, m_count * sizeof(int32));
+	snapshot->Write(m_manifolds, m_count * sizeof(b2Manifold));
+}
+
+void b2ManifoldSet::RestoreState(b2SnapshotReader* reader, b2Manifold** extra, int32* extraCount)
+{
+	m_count = reader->Read<int32>();
+	if (m_capacity < m_count)
+	{
+		m_memory->Free(m_manifolds);
+		m_memory->Free(m_keys);
+		m_capacity = m_count;
+		m_manifolds = (b2Manifold*)m_memory->Allocate(m_capacity * sizeof(b2Manifold));
+		m_keys = (int32*)m_memory->Allocate(m_capacity * sizeof(int32));
+	}
+
+	reader->Read(m_keys, m_count * sizeof(int32));
+	reader->Read(m_manifolds, m_count * sizeof(b2Manifold));
+
+	// The old manifolds are only read after the next Begin swaps them in.
+	m_oldCount = 0;
+
+	if (m_count > 0)
+	{
+		*extra = m_manifolds + 1;
+		*extraCount = m_count - 1;
+	}
+	else
+	{
+		*extra = NULL;
+		*extraCount = 0;
+	}
+}
@@ -0,0 +1,72 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_MANIFOLD_SET_H
+#define B2_MANIFOLD_SET_H
+
+#include <Box2D/Collision/b2Collision.h>
+
+class b2AllocatorInterface;
+class b2Snapshot;
+class b2SnapshotReader;
+
+/// The manifolds of a contact that touches in several places, such as a chain with a tree
+/// or a compound shape. Each manifold has a key that names the primitives that produced
+/// it. The manifolds of the previous update are kept to warm start the new ones.
+class b2ManifoldSet
+{
+public:
+	/// @param allocator the world's allocator
+	explicit b2ManifoldSet(b2AllocatorInterface* allocator);
+	~b2ManifoldSet();
+
+	/// Start an update. The first manifold is stored in the contact and solved in
+	/// place, so it is passed back here.
+	void Begin(const b2Manifold& first);
+
+	/// Add a touching manifold.
+	void Add(const b2Manifold& manifold, int32 key);
+
+	/// Match old contact ids to new contact ids of the same key and copy the stored
+	/// impulses. Then write out the first manifold and the extra manifolds.
+	void End(b2Manifold* first, b2Manifold** extra, int32* extraCount);
+
+	/// Write the manifolds of the last update to a snapshot.
+	void SaveState(b2Snapshot* snapshot) const;
+
+	/// Read the manifolds of the last update back from a snapshot and point the
+	/// contact's extra manifolds at them.
+	void RestoreState(b2SnapshotReader* reader, b2Manifold** extra, int32* extraCount);
+
+private:
+
+	b2AllocatorInterface* m_memory;
+
+	b2Manifold* m_manifolds;
+	int32* m_keys;
+	int32 m_count;
+	int32 m_capacity;
+
+	b2Manifold* m_oldManifolds;
+	int32* m_oldKeys;
+	int32 m_oldCount;
+	int32 m_oldCapacity;
+};
+
+#endif
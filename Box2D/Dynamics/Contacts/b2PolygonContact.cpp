@@ -21,6 +21,7 @@
 #include <Box2D/Collision/b2TimeOfImpact.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 
 #include <new>
@@ -42,11 +43,24 @@ b2PolygonContact::b2PolygonContact(b2Fixture* fixtureA, b2Fixture* fixtureB)
 {
 	b2Assert(m_fixtureA->GetType() == b2Shape::e_polygon);
 	b2Assert(m_fixtureB->GetType() == b2Shape::e_polygon);
+
+	const b2PolygonShape* polygonA = (b2PolygonShape*)m_fixtureA->GetShape();
+	const b2PolygonShape* polygonB = (b2PolygonShape*)m_fixtureB->GetShape();
+	m_boxes = polygonA->IsBox() && polygonB->IsBox();
 }
 
 void b2PolygonContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB)
 {
-	b2CollidePolygons(	manifold,
+	if (m_boxes)
+	{
+		b2CollideBoxes(	manifold,
 						(b2PolygonShape*)m_fixtureA->GetShape(), xfA,
 						(b2PolygonShape*)m_fixtureB->GetShape(), xfB);
+	}
+	else
+	{
+		b2CollidePolygons(	manifold,
+							(b2PolygonShape*)m_fixtureA->GetShape(), xfA,
+							(b2PolygonShape*)m_fixtureB->GetShape(), xfB);
+	}
 }
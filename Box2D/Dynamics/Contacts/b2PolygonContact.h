@@ -34,6 +34,10 @@ public:
 	~b2PolygonContact() {}
 
 	void Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB);
+
+private:
+	// Both polygons are boxes, chosen at creation.
+	bool m_boxes;
 };
 
 #endif
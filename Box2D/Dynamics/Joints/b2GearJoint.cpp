@@ -62,9 +62,9 @@ b2GearJoint::b2GearJoint(const b2GearJointDef* def)
 
 	// Get geometry of joint1
 	b2Transform xfA = m_bodyA->m_xf;
-	float32 aA = m_bodyA->m_sweep.a;
+	float32 aA = m_bodyA->Sweep().a;
 	b2Transform xfC = m_bodyC->m_xf;
-	float32 aC = m_bodyC->m_sweep.a;
+	float32 aC = m_bodyC->Sweep().a;
 
 	if (m_typeA == e_revoluteJoint)
 	{
@@ -94,9 +94,9 @@ b2GearJoint::b2GearJoint(const b2GearJointDef* def)
 
 	// Get geometry of joint2
 	b2Transform xfB = m_bodyB->m_xf;
-	float32 aB = m_bodyB->m_sweep.a;
+	float32 aB = m_bodyB->Sweep().a;
 	b2Transform xfD = m_bodyD->m_xf;
-	float32 aD = m_bodyD->m_sweep.a;
+	float32 aD = m_bodyD->Sweep().a;
 
 	if (m_typeB == e_revoluteJoint)
 	{
@@ -134,10 +134,10 @@ void b2GearJoint::InitVelocityConstraints(const b2SolverData& data)
 	m_indexB = m_bodyB->m_islandIndex;
 	m_indexC = m_bodyC->m_islandIndex;
 	m_indexD = m_bodyD->m_islandIndex;
-	m_lcA = m_bodyA->m_sweep.localCenter;
-	m_lcB = m_bodyB->m_sweep.localCenter;
-	m_lcC = m_bodyC->m_sweep.localCenter;
-	m_lcD = m_bodyD->m_sweep.localCenter;
+	m_lcA = m_bodyA->Sweep().localCenter;
+	m_lcB = m_bodyB->Sweep().localCenter;
+	m_lcC = m_bodyC->Sweep().localCenter;
+	m_lcD = m_bodyD->Sweep().localCenter;
 	m_mA = m_bodyA->m_invMass;
 	m_mB = m_bodyB->m_invMass;
 	m_mC = m_bodyC->m_invMass;
@@ -268,6 +268,38 @@ void b2GearJoint::SolveVelocityConstraints(const b2SolverData& data)
 	data.velocities[m_indexD].w = wD;
 }
 
+void b2GearJoint::SolveVelocityRun(b2Joint** joints, int32 count, const b2SolverData& data,
+								   float32* linearResidual, float32* angularResidual)
+{
+	b2Velocity* velocities = data.velocities;
+	float32 linear = *linearResidual;
+	float32 angular = *angularResidual;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2GearJoint* joint = static_cast<b2GearJoint*>(joints[i]);
+		const int32 indices[4] = {joint->m_indexA, joint->m_indexB, joint->m_indexC, joint->m_indexD};
+
+		b2Velocity v[4];
+		for (int32 j = 0; j < 4; ++j)
+		{
+			v[j] = velocities[indices[j]];
+		}
+
+		joint->SolveVelocityConstraints(data);
+
+		for (int32 j = 0; j < 4; ++j)
+		{
+			const b2Velocity& v2 = velocities[indices[j]];
+			linear = b2Max(linear, b2Distance(v[j].v, v2.v));
+			angular = b2Max(angular, b2Abs(v2.w - v[j].w));
+		}
+	}
+
+	*linearResidual = linear;
+	*angularResidual = angular;
+}
+
 bool b2GearJoint::SolvePositionConstraints(const b2SolverData& data)
 {
 	b2Vec2 cA = data.positions[m_indexA].c;
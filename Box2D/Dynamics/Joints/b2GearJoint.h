@@ -84,6 +84,10 @@ protected:
 	void SolveVelocityConstraints(const b2SolverData& data);
 	bool SolvePositionConstraints(const b2SolverData& data);
 
+	// Run kernel, see b2Joint::SolveVelocityRun. The residuals cover all four bodies.
+	static void SolveVelocityRun(b2Joint** joints, int32 count, const b2SolverData& data,
+								 float32* linearResidual, float32* angularResidual);
+
 	b2Joint* m_joint1;
 	b2Joint* m_joint2;
 
@@ -128,55 +128,49 @@ b2Joint* b2Joint::Create(const b2JointDef* def, b2BlockAllocator* allocator)
 void b2Joint::Destroy(b2Joint* joint, b2BlockAllocator* allocator)
 {
 	joint->~b2Joint();
-	switch (joint->m_type)
+	allocator->Free(joint, GetSize(joint->m_type));
+}
+
+int32 b2Joint::GetSize(b2JointType type)
+{
+	switch (type)
 	{
 	case e_distanceJoint:
-		allocator->Free(joint, sizeof(b2DistanceJoint));
-		break;
+		return sizeof(b2DistanceJoint);
 
 	case e_mouseJoint:
-		allocator->Free(joint, sizeof(b2MouseJoint));
-		break;
+		return sizeof(b2MouseJoint);
 
 	case e_prismaticJoint:
-		allocator->Free(joint, sizeof(b2PrismaticJoint));
-		break;
+		return sizeof(b2PrismaticJoint);
 
 	case e_revoluteJoint:
-		allocator->Free(joint, sizeof(b2RevoluteJoint));
-		break;
+		return sizeof(b2RevoluteJoint);
 
 	case e_pulleyJoint:
-		allocator->Free(joint, sizeof(b2PulleyJoint));
-		break;
+		return sizeof(b2PulleyJoint);
 
 	case e_gearJoint:
-		allocator->Free(joint, sizeof(b2GearJoint));
-		break;
+		return sizeof(b2GearJoint);
 
 	case e_wheelJoint:
-		allocator->Free(joint, sizeof(b2WheelJoint));
-		break;
-    
+		return sizeof(b2WheelJoint);
+
 	case e_weldJoint:
-		allocator->Free(joint, sizeof(b2WeldJoint));
-		break;
+		return sizeof(b2WeldJoint);
 
 	case e_frictionJoint:
-		allocator->Free(joint, sizeof(b2FrictionJoint));
-		break;
+		return sizeof(b2FrictionJoint);
 
 	case e_ropeJoint:
-		allocator->Free(joint, sizeof(b2RopeJoint));
-		break;
+		return sizeof(b2RopeJoint);
 
 	case e_motorJoint:
-		allocator->Free(joint, sizeof(b2MotorJoint));
-		break;
+		return sizeof(b2MotorJoint);
 
 	default:
 		b2Assert(false);
-		break;
+		return 0;
 	}
 }
 
@@ -205,6 +199,158 @@ b2Joint::b2Joint(const b2JointDef* def)
 	m_edgeB.next = NULL;
 }
 
+void b2Joint::InitVelocityRun(b2Joint** joints, int32 count, const b2SolverData& data)
+{
+	switch (joints[0]->m_type)
+	{
+	case e_revoluteJoint:
+		InitVelocityKernel<b2RevoluteJoint>(joints, count, data);
+		break;
+
+	case e_distanceJoint:
+		InitVelocityKernel<b2DistanceJoint>(joints, count, data);
+		break;
+
+	case e_prismaticJoint:
+		InitVelocityKernel<b2PrismaticJoint>(joints, count, data);
+		break;
+
+	case e_pulleyJoint:
+		InitVelocityKernel<b2PulleyJoint>(joints, count, data);
+		break;
+
+	case e_mouseJoint:
+		InitVelocityKernel<b2MouseJoint>(joints, count, data);
+		break;
+
+	case e_gearJoint:
+		InitVelocityKernel<b2GearJoint>(joints, count, data);
+		break;
+
+	case e_wheelJoint:
+		InitVelocityKernel<b2WheelJoint>(joints, count, data);
+		break;
+
+	case e_weldJoint:
+		InitVelocityKernel<b2WeldJoint>(joints, count, data);
+		break;
+
+	case e_frictionJoint:
+		InitVelocityKernel<b2FrictionJoint>(joints, count, data);
+		break;
+
+	case e_ropeJoint:
+		InitVelocityKernel<b2RopeJoint>(joints, count, data);
+		break;
+
+	case e_motorJoint:
+		InitVelocityKernel<b2MotorJoint>(joints, count, data);
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+}
+
+void b2Joint::SolveVelocityRun(b2Joint** joints, int32 count, const b2SolverData& data,
+							   float32* linearResidual, float32* angularResidual)
+{
+	switch (joints[0]->m_type)
+	{
+	case e_revoluteJoint:
+		SolveVelocityKernel<b2RevoluteJoint>(joints, count, data, linearResidual, angularResidual);
+		break;
+
+	case e_distanceJoint:
+		SolveVelocityKernel<b2DistanceJoint>(joints, count, data, linearResidual, angularResidual);
+		break;
+
+	case e_prismaticJoint:
+		SolveVelocityKernel<b2PrismaticJoint>(joints, count, data, linearResidual, angularResidual);
+		break;
+
+	case e_pulleyJoint:
+		SolveVelocityKernel<b2PulleyJoint>(joints, count, data, linearResidual, angularResidual);
+		break;
+
+	case e_mouseJoint:
+		b2MouseJoint::SolveVelocityRun(joints, count, data, linearResidual, angularResidual);
+		break;
+
+	case e_gearJoint:
+		b2GearJoint::SolveVelocityRun(joints, count, data, linearResidual, angularResidual);
+		break;
+
+	case e_wheelJoint:
+		SolveVelocityKernel<b2WheelJoint>(joints, count, data, linearResidual, angularResidual);
+		break;
+
+	case e_weldJoint:
+		SolveVelocityKernel<b2WeldJoint>(joints, count, data, linearResidual, angularResidual);
+		break;
+
+	case e_frictionJoint:
+		SolveVelocityKernel<b2FrictionJoint>(joints, count, data, linearResidual, angularResidual);
+		break;
+
+	case e_ropeJoint:
+		SolveVelocityKernel<b2RopeJoint>(joints, count, data, linearResidual, angularResidual);
+		break;
+
+	case e_motorJoint:
+		SolveVelocityKernel<b2MotorJoint>(joints, count, data, linearResidual, angularResidual);
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+}
+
+bool b2Joint::SolvePositionRun(b2Joint** joints, int32 count, const b2SolverData& data)
+{
+	switch (joints[0]->m_type)
+	{
+	case e_revoluteJoint:
+		return SolvePositionKernel<b2RevoluteJoint>(joints, count, data);
+
+	case e_distanceJoint:
+		return SolvePositionKernel<b2DistanceJoint>(joints, count, data);
+
+	case e_prismaticJoint:
+		return SolvePositionKernel<b2PrismaticJoint>(joints, count, data);
+
+	case e_pulleyJoint:
+		return SolvePositionKernel<b2PulleyJoint>(joints, count, data);
+
+	case e_mouseJoint:
+		return SolvePositionKernel<b2MouseJoint>(joints, count, data);
+
+	case e_gearJoint:
+		return SolvePositionKernel<b2GearJoint>(joints, count, data);
+
+	case e_wheelJoint:
+		return SolvePositionKernel<b2WheelJoint>(joints, count, data);
+
+	case e_weldJoint:
+		return SolvePositionKernel<b2WeldJoint>(joints, count, data);
+
+	case e_frictionJoint:
+		return SolvePositionKernel<b2FrictionJoint>(joints, count, data);
+
+	case e_ropeJoint:
+		return SolvePositionKernel<b2RopeJoint>(joints, count, data);
+
+	case e_motorJoint:
+		return SolvePositionKernel<b2MotorJoint>(joints, count, data);
+
+	default:
+		b2Assert(false);
+		return true;
+	}
+}
+
 bool b2Joint::IsActive() const
 {
 	return m_bodyA->IsActive() && m_bodyB->IsActive();
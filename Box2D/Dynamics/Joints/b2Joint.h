@@ -20,10 +20,10 @@
 #define B2_JOINT_H
 
 #include <Box2D/Common/b2Math.h>
+#include <Box2D/Dynamics/b2TimeStep.h>
 
 class b2Body;
 class b2Joint;
-struct b2SolverData;
 class b2BlockAllocator;
 
 enum b2JointType
@@ -158,6 +158,9 @@ protected:
 	static b2Joint* Create(const b2JointDef* def, b2BlockAllocator* allocator);
 	static void Destroy(b2Joint* joint, b2BlockAllocator* allocator);
 
+	// The size of the object of a joint type.
+	static int32 GetSize(b2JointType type);
+
 	b2Joint(const b2JointDef* def);
 	virtual ~b2Joint() {}
 
@@ -167,6 +170,26 @@ protected:
 	// This returns true if the position errors are within tolerance.
 	virtual bool SolvePositionConstraints(const b2SolverData& data) = 0;
 
+	// The island keeps its joints sorted by type and hands each run of one type
+	// to these. They call the type's solver functions without virtual dispatch.
+	// This is not measurably faster than the virtual calls, the joint state is
+	// not batched and there are no SIMD kernels. The velocity residuals grow to
+	// the largest velocity change in the run.
+	static void InitVelocityRun(b2Joint** joints, int32 count, const b2SolverData& data);
+	static void SolveVelocityRun(b2Joint** joints, int32 count, const b2SolverData& data,
+								 float32* linearResidual, float32* angularResidual);
+	static bool SolvePositionRun(b2Joint** joints, int32 count, const b2SolverData& data);
+
+	// Run kernels for joint type T. The velocity kernel measures bodies A and B,
+	// joints that use other bodies have their own SolveVelocityRun.
+	template <typename T>
+	static void InitVelocityKernel(b2Joint** joints, int32 count, const b2SolverData& data);
+	template <typename T>
+	static void SolveVelocityKernel(b2Joint** joints, int32 count, const b2SolverData& data,
+									float32* linearResidual, float32* angularResidual);
+	template <typename T>
+	static bool SolvePositionKernel(b2Joint** joints, int32 count, const b2SolverData& data);
+
 	b2JointType m_type;
 	b2Joint* m_prev;
 	b2Joint* m_next;
@@ -180,6 +203,9 @@ protected:
 	bool m_islandFlag;
 	bool m_collideConnected;
 
+	// Unique within the world and never reused. Snapshots check it.
+	uint32 m_id;
+
 	void* m_userData;
 };
 
@@ -223,4 +249,53 @@ inline bool b2Joint::GetCollideConnected() const
 	return m_collideConnected;
 }
 
+template <typename T>
+inline void b2Joint::InitVelocityKernel(b2Joint** joints, int32 count, const b2SolverData& data)
+{
+	for (int32 i = 0; i < count; ++i)
+	{
+		T* joint = static_cast<T*>(joints[i]);
+		joint->T::InitVelocityConstraints(data);
+	}
+}
+
+template <typename T>
+inline void b2Joint::SolveVelocityKernel(b2Joint** joints, int32 count, const b2SolverData& data,
+										 float32* linearResidual, float32* angularResidual)
+{
+	b2Velocity* velocities = data.velocities;
+	float32 linear = *linearResidual;
+	float32 angular = *angularResidual;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		T* joint = static_cast<T*>(joints[i]);
+		b2Velocity vA = velocities[joint->m_indexA];
+		b2Velocity vB = velocities[joint->m_indexB];
+
+		joint->T::SolveVelocityConstraints(data);
+
+		const b2Velocity& vA2 = velocities[joint->m_indexA];
+		const b2Velocity& vB2 = velocities[joint->m_indexB];
+		linear = b2Max(linear, b2Max(b2Distance(vA.v, vA2.v), b2Distance(vB.v, vB2.v)));
+		angular = b2Max(angular, b2Max(b2Abs(vA2.w - vA.w), b2Abs(vB2.w - vB.w)));
+	}
+
+	*linearResidual = linear;
+	*angularResidual = angular;
+}
+
+template <typename T>
+inline bool b2Joint::SolvePositionKernel(b2Joint** joints, int32 count, const b2SolverData& data)
+{
+	bool okay = true;
+	for (int32 i = 0; i < count; ++i)
+	{
+		T* joint = static_cast<T*>(joints[i]);
+		bool jointOkay = joint->T::SolvePositionConstraints(data);
+		okay = okay && jointOkay;
+	}
+	return okay;
+}
+
 #endif
@@ -96,7 +96,7 @@ float32 b2MouseJoint::GetDampingRatio() const
 void b2MouseJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
+	m_localCenterB = m_bodyB->Sweep().localCenter;
 	m_invMassB = m_bodyB->m_invMass;
 	m_invIB = m_bodyB->m_invI;
 
@@ -190,6 +190,29 @@ void b2MouseJoint::SolveVelocityConstraints(const b2SolverData& data)
 	data.velocities[m_indexB].w = wB;
 }
 
+void b2MouseJoint::SolveVelocityRun(b2Joint** joints, int32 count, const b2SolverData& data,
+									float32* linearResidual, float32* angularResidual)
+{
+	b2Velocity* velocities = data.velocities;
+	float32 linear = *linearResidual;
+	float32 angular = *angularResidual;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2MouseJoint* joint = static_cast<b2MouseJoint*>(joints[i]);
+		b2Velocity vB = velocities[joint->m_indexB];
+
+		joint->b2MouseJoint::SolveVelocityConstraints(data);
+
+		const b2Velocity& vB2 = velocities[joint->m_indexB];
+		linear = b2Max(linear, b2Distance(vB.v, vB2.v));
+		angular = b2Max(angular, b2Abs(vB2.w - vB.w));
+	}
+
+	*linearResidual = linear;
+	*angularResidual = angular;
+}
+
 bool b2MouseJoint::SolvePositionConstraints(const b2SolverData& data)
 {
 	B2_NOT_USED(data);
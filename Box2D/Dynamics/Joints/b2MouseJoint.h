@@ -104,6 +104,11 @@ protected:
 	void SolveVelocityConstraints(const b2SolverData& data);
 	bool SolvePositionConstraints(const b2SolverData& data);
 
+	// Run kernel, see b2Joint::SolveVelocityRun. Only body B is in the island, so
+	// m_indexA is never set.
+	static void SolveVelocityRun(b2Joint** joints, int32 count, const b2SolverData& data,
+								 float32* linearResidual, float32* angularResidual);
+
 	b2Vec2 m_localAnchorB;
 	b2Vec2 m_targetA;
 	float32 m_frequencyHz;
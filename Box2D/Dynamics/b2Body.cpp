@@ -18,6 +18,7 @@
 
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2SensorOverlap.h>
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/Joints/b2Joint.h>
@@ -55,31 +56,35 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	}
 
 	m_world = world;
+	m_storage = &world->m_bodyStorage;
+	m_slot = m_storage->Create(this);
 
 	m_xf.p = bd->position;
 	m_xf.q.Set(bd->angle);
 
-	m_sweep.localCenter.SetZero();
-	m_sweep.c0 = m_xf.p;
-	m_sweep.c = m_xf.p;
-	m_sweep.a0 = bd->angle;
-	m_sweep.a = bd->angle;
-	m_sweep.alpha0 = 0.0f;
+	b2Sweep& sweep = Sweep();
+	sweep.localCenter.SetZero();
+	sweep.c0 = m_xf.p;
+	sweep.c = m_xf.p;
+	sweep.a0 = bd->angle;
+	sweep.a = bd->angle;
+	sweep.alpha0 = 0.0f;
 
 	m_jointList = NULL;
 	m_contactList = NULL;
+	m_sensorList = NULL;
 	m_prev = NULL;
 	m_next = NULL;
 
-	m_linearVelocity = bd->linearVelocity;
-	m_angularVelocity = bd->angularVelocity;
+	LinearVelocity() = bd->linearVelocity;
+	AngularVelocity() = bd->angularVelocity;
 
 	m_linearDamping = bd->linearDamping;
 	m_angularDamping = bd->angularDamping;
 	m_gravityScale = bd->gravityScale;
 
-	m_force.SetZero();
-	m_torque = 0.0f;
+	Force().SetZero();
+	Torque() = 0.0f;
 
 	m_sleepTime = 0.0f;
 
@@ -108,6 +113,7 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 b2Body::~b2Body()
 {
 	// shapes and joints are destroyed in b2World::Destroy
+	m_storage->Destroy(m_slot);
 }
 
 void b2Body::SetType(b2BodyType type)
@@ -129,17 +135,17 @@ void b2Body::SetType(b2BodyType type)
 
 	if (m_type == b2_staticBody)
 	{
-		m_linearVelocity.SetZero();
-		m_angularVelocity = 0.0f;
-		m_sweep.a0 = m_sweep.a;
-		m_sweep.c0 = m_sweep.c;
+		LinearVelocity().SetZero();
+		AngularVelocity() = 0.0f;
+		Sweep().a0 = Sweep().a;
+		Sweep().c0 = Sweep().c;
 		SynchronizeFixtures();
 	}
 
 	SetAwake(true);
 
-	m_force.SetZero();
-	m_torque = 0.0f;
+	Force().SetZero();
+	Torque() = 0.0f;
 
 	// Delete the attached contacts.
 	b2ContactEdge* ce = m_contactList;
@@ -147,10 +153,20 @@ void b2Body::SetType(b2BodyType type)
 	{
 		b2ContactEdge* ce0 = ce;
 		ce = ce->next;
-		m_world->m_contactManager.Destroy(ce0->contact);
+		m_world->m_contactManager.Retire(ce0->contact);
 	}
 	m_contactList = NULL;
 
+	// Delete the attached sensor overlaps.
+	b2SensorEdge* se = m_sensorList;
+	while (se)
+	{
+		b2SensorEdge* se0 = se;
+		se = se->next;
+		m_world->m_contactManager.DestroySensor(se0->overlap);
+	}
+	m_sensorList = NULL;
+
 	// Touch the proxies so that new contacts will be created (when appropriate)
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
@@ -177,7 +193,8 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 	b2Fixture* fixture = new (memory) b2Fixture;
 	fixture->Create(allocator, this, def);
 
-	if (m_flags & e_activeFlag)
+	// During an edit the proxies are created by EndEdit.
+	if ((m_flags & e_activeFlag) && (m_flags & e_editFlag) == 0)
 	{
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 		fixture->CreateProxies(broadPhase, m_xf);
@@ -192,7 +209,14 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 	// Adjust mass properties if needed.
 	if (fixture->m_density > 0.0f)
 	{
-		ResetMassData();
+		if (m_flags & e_editFlag)
+		{
+			m_flags |= e_massDirtyFlag;
+		}
+		else
+		{
+			ResetMassData();
+		}
 	}
 
 	// Let the world know we have a new fixture. This will cause new contacts
@@ -258,6 +282,19 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 		}
 	}
 
+	// Destroy any sensor overlaps associated with the fixture.
+	b2SensorEdge* sensorEdge = m_sensorList;
+	while (sensorEdge)
+	{
+		b2SensorOverlap* overlap = sensorEdge->overlap;
+		sensorEdge = sensorEdge->next;
+
+		if (fixture == overlap->GetFixtureA() || fixture == overlap->GetFixtureB())
+		{
+			m_world->m_contactManager.DestroySensor(overlap);
+		}
+	}
+
 	b2BlockAllocator* allocator = &m_world->m_blockAllocator;
 
 	if (m_flags & e_activeFlag)
@@ -275,7 +312,52 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 	--m_fixtureCount;
 
 	// Reset the mass data.
-	ResetMassData();
+	if (m_flags & e_editFlag)
+	{
+		m_flags |= e_massDirtyFlag;
+	}
+	else
+	{
+		ResetMassData();
+	}
+}
+
+void b2Body::BeginEdit()
+{
+	b2Assert(m_world->IsLocked() == false);
+	b2Assert((m_flags & e_editFlag) == 0);
+	m_flags |= e_editFlag;
+}
+
+void b2Body::EndEdit()
+{
+	b2Assert(m_world->IsLocked() == false);
+	b2Assert(m_flags & e_editFlag);
+	m_flags &= ~e_editFlag;
+
+	// Gather the fixtures created during the edit.
+	b2StackAllocator* stackAllocator = &m_world->m_stackAllocator;
+	b2Fixture** fixtures = (b2Fixture**)stackAllocator->Allocate(m_fixtureCount * sizeof(b2Fixture*));
+	int32 count = 0;
+	if (m_flags & e_activeFlag)
+	{
+		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
+		{
+			if (f->m_proxyCount == 0)
+			{
+				fixtures[count++] = f;
+			}
+		}
+	}
+
+	m_world->CreateProxies(fixtures, count);
+	stackAllocator->Free(fixtures);
+
+	if (m_flags & e_massDirtyFlag)
+	{
+		m_flags &= ~e_massDirtyFlag;
+		ResetMassData();
+	}
 }
 
 void b2Body::ResetMassData()
@@ -285,14 +367,14 @@ void b2Body::ResetMassData()
 	m_invMass = 0.0f;
 	m_I = 0.0f;
 	m_invI = 0.0f;
-	m_sweep.localCenter.SetZero();
+	Sweep().localCenter.SetZero();
 
 	// Static and kinematic bodies have zero mass.
 	if (m_type == b2_staticBody || m_type == b2_kinematicBody)
 	{
-		m_sweep.c0 = m_xf.p;
-		m_sweep.c = m_xf.p;
-		m_sweep.a0 = m_sweep.a;
+		Sweep().c0 = m_xf.p;
+		Sweep().c = m_xf.p;
+		Sweep().a0 = Sweep().a;
 		return;
 	}
 
@@ -342,12 +424,12 @@ void b2Body::ResetMassData()
 	}
 
 	// Move center of mass.
-	b2Vec2 oldCenter = m_sweep.c;
-	m_sweep.localCenter = localCenter;
-	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
+	b2Vec2 oldCenter = Sweep().c;
+	Sweep().localCenter = localCenter;
+	Sweep().c0 = Sweep().c = b2Mul(m_xf, Sweep().localCenter);
 
 	// Update center of mass velocity.
-	m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+	LinearVelocity() += b2Cross(AngularVelocity(), Sweep().c - oldCenter);
 }
 
 void b2Body::SetMassData(const b2MassData* massData)
@@ -383,12 +465,12 @@ void b2Body::SetMassData(const b2MassData* massData)
 	}
 
 	// Move center of mass.
-	b2Vec2 oldCenter = m_sweep.c;
-	m_sweep.localCenter =  massData->center;
-	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
+	b2Vec2 oldCenter = Sweep().c;
+	Sweep().localCenter =  massData->center;
+	Sweep().c0 = Sweep().c = b2Mul(m_xf, Sweep().localCenter);
 
 	// Update center of mass velocity.
-	m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+	LinearVelocity() += b2Cross(AngularVelocity(), Sweep().c - oldCenter);
 }
 
 bool b2Body::ShouldCollide(const b2Body* other) const
@@ -425,29 +507,37 @@ void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 	m_xf.q.Set(angle);
 	m_xf.p = position;
 
-	m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
-	m_sweep.a = angle;
+	Sweep().c = b2Mul(m_xf, Sweep().localCenter);
+	Sweep().a = angle;
 
-	m_sweep.c0 = m_sweep.c;
-	m_sweep.a0 = angle;
+	Sweep().c0 = Sweep().c;
+	Sweep().a0 = angle;
 
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
-		f->Synchronize(broadPhase, m_xf, m_xf);
+		f->Synchronize(broadPhase, m_xf, m_xf, b2Vec2_zero);
 	}
 }
 
 void b2Body::SynchronizeFixtures()
 {
 	b2Transform xf1;
-	xf1.q.Set(m_sweep.a0);
-	xf1.p = m_sweep.c0 - b2Mul(xf1.q, m_sweep.localCenter);
+	xf1.q.Set(Sweep().a0);
+	xf1.p = Sweep().c0 - b2Mul(xf1.q, Sweep().localCenter);
+
+	// Speculative contacts must exist before the shapes can touch, so the
+	// proxies also cover the motion of the next step.
+	b2Vec2 prediction = b2Vec2_zero;
+	if (m_world->m_speculativeContacts)
+	{
+		prediction = Sweep().c - Sweep().c0;
+	}
 
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
-		f->Synchronize(broadPhase, xf1, m_xf);
+		f->Synchronize(broadPhase, xf1, m_xf, prediction);
 	}
 }
 
@@ -490,9 +580,19 @@ void b2Body::SetActive(bool flag)
 		{
 			b2ContactEdge* ce0 = ce;
 			ce = ce->next;
-			m_world->m_contactManager.Destroy(ce0->contact);
+			m_world->m_contactManager.Retire(ce0->contact);
 		}
 		m_contactList = NULL;
+
+		// Destroy the attached sensor overlaps.
+		b2SensorEdge* se = m_sensorList;
+		while (se)
+		{
+			b2SensorEdge* se0 = se;
+			se = se->next;
+			m_world->m_contactManager.DestroySensor(se0->overlap);
+		}
+		m_sensorList = NULL;
 	}
 }
 
@@ -513,7 +613,7 @@ void b2Body::SetFixedRotation(bool flag)
 		m_flags &= ~e_fixedRotationFlag;
 	}
 
-	m_angularVelocity = 0.0f;
+	AngularVelocity() = 0.0f;
 
 	ResetMassData();
 }
@@ -526,9 +626,9 @@ void b2Body::Dump()
 	b2Log("  b2BodyDef bd;\n");
 	b2Log("  bd.type = b2BodyType(%d);\n", m_type);
 	b2Log("  bd.position.Set(%.15lef, %.15lef);\n", m_xf.p.x, m_xf.p.y);
-	b2Log("  bd.angle = %.15lef;\n", m_sweep.a);
-	b2Log("  bd.linearVelocity.Set(%.15lef, %.15lef);\n", m_linearVelocity.x, m_linearVelocity.y);
-	b2Log("  bd.angularVelocity = %.15lef;\n", m_angularVelocity);
+	b2Log("  bd.angle = %.15lef;\n", Sweep().a);
+	b2Log("  bd.linearVelocity.Set(%.15lef, %.15lef);\n", LinearVelocity().x, LinearVelocity().y);
+	b2Log("  bd.angularVelocity = %.15lef;\n", AngularVelocity());
 	b2Log("  bd.linearDamping = %.15lef;\n", m_linearDamping);
 	b2Log("  bd.angularDamping = %.15lef;\n", m_angularDamping);
 	b2Log("  bd.allowSleep = bool(%d);\n", m_flags & e_autoSleepFlag);
@@ -21,6 +21,7 @@
 
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Collision/Shapes/b2Shape.h>
+#include <Box2D/Dynamics/b2BodyStorage.h>
 #include <memory>
 
 class b2Fixture;
@@ -31,6 +32,7 @@ class b2World;
 struct b2FixtureDef;
 struct b2JointEdge;
 struct b2ContactEdge;
+struct b2SensorEdge;
 
 /// The body type.
 /// static: zero mass, zero velocity, may be manually moved
@@ -172,11 +174,12 @@ public:
 	/// @return the current world rotation angle in radians.
 	float32 GetAngle() const;
 
-	/// Get the world position of the center of mass.
-	const b2Vec2& GetWorldCenter() const;
+	/// Get the world position of the center of mass. This is returned by value because
+	/// the state lives in the world's body storage, which moves when it grows.
+	b2Vec2 GetWorldCenter() const;
 
 	/// Get the local position of the center of mass.
-	const b2Vec2& GetLocalCenter() const;
+	b2Vec2 GetLocalCenter() const;
 
 	/// Set the linear velocity of the center of mass.
 	/// @param v the new linear velocity of the center of mass.
@@ -184,7 +187,7 @@ public:
 
 	/// Get the linear velocity of the center of mass.
 	/// @return the linear velocity of the center of mass.
-	const b2Vec2& GetLinearVelocity() const;
+	b2Vec2 GetLinearVelocity() const;
 
 	/// Set the angular velocity.
 	/// @param omega the new angular velocity in radians/second.
@@ -251,6 +254,20 @@ public:
 	/// the mass and you later want to reset the mass.
 	void ResetMassData();
 
+	/// Start a batch edit. Until EndEdit, CreateFixture and DestroyFixture do not
+	/// update the mass and new fixtures get no broad-phase proxies, so building a body
+	/// from many fixtures costs the mass computation once instead of once per fixture.
+	/// Do not step the world during an edit. Edits do not nest.
+	/// @see b2BodyEditScope
+	void BeginEdit();
+
+	/// End a batch edit. This creates the deferred proxies in one batch and resets
+	/// the mass if any fixture changed it.
+	void EndEdit();
+
+	/// Is this body in a batch edit?
+	bool IsEditing() const;
+
 	/// Get the world coordinates of a point given the local coordinates.
 	/// @param localPoint a point on the body measured relative the the body's origin.
 	/// @return the same point expressed in world coordinates.
@@ -366,6 +383,10 @@ public:
 	b2ContactEdge* GetContactList();
 	const b2ContactEdge* GetContactList() const;
 
+	/// Get the list of all sensor overlaps attached to this body.
+	b2SensorEdge* GetSensorList();
+	const b2SensorEdge* GetSensorList() const;
+
 	/// Get the next body in the world's body list.
 	b2Body* GetNext();
 	const b2Body* GetNext() const;
@@ -380,6 +401,10 @@ public:
 	b2World* GetWorld();
 	const b2World* GetWorld() const;
 
+	/// Get a handle to this body. b2World::GetBody resolves it to NULL once the
+	/// body is destroyed.
+	b2BodyHandle GetHandle() const;
+
 	/// Dump this body to a log file
 	void Dump();
 
@@ -390,6 +415,7 @@ private:
 	friend class b2ContactManager;
 	friend class b2ContactSolver;
 	friend class b2Contact;
+	friend class b2BodyStorage;
 	
 	friend class b2DistanceJoint;
 	friend class b2FrictionJoint;
@@ -412,7 +438,9 @@ private:
 		e_bulletFlag		= 0x0008,
 		e_fixedRotationFlag	= 0x0010,
 		e_activeFlag		= 0x0020,
-		e_toiFlag			= 0x0040
+		e_toiFlag			= 0x0040,
+		e_editFlag			= 0x0080,
+		e_massDirtyFlag		= 0x0100
 	};
 
 	b2Body(const b2BodyDef* bd, b2World* world);
@@ -427,6 +455,16 @@ private:
 
 	void Advance(float32 t);
 
+	// The state in the world's body storage.
+	b2Sweep& Sweep();				// the swept motion for CCD
+	const b2Sweep& Sweep() const;
+	b2Vec2& LinearVelocity();
+	const b2Vec2& LinearVelocity() const;
+	float32& AngularVelocity();
+	float32 AngularVelocity() const;
+	b2Vec2& Force();
+	float32& Torque();
+
 	b2BodyType m_type;
 
 	uint16 m_flags;
@@ -434,13 +472,10 @@ private:
 	int32 m_islandIndex;
 
 	b2Transform m_xf;		// the body origin transform
-	b2Sweep m_sweep;		// the swept motion for CCD
-
-	b2Vec2 m_linearVelocity;
-	float32 m_angularVelocity;
 
-	b2Vec2 m_force;
-	float32 m_torque;
+	b2BodyStorage* m_storage;
+	int32 m_stateIndex;
+	int32 m_slot;
 
 	b2World* m_world;
 	b2Body* m_prev;
@@ -451,6 +486,7 @@ private:
 
 	b2JointEdge* m_jointList;
 	b2ContactEdge* m_contactList;
+	b2SensorEdge* m_sensorList;
 
 	float32 m_mass, m_invMass;
 
@@ -483,17 +519,17 @@ inline const b2Vec2& b2Body::GetPosition() const
 
 inline float32 b2Body::GetAngle() const
 {
-	return m_sweep.a;
+	return Sweep().a;
 }
 
-inline const b2Vec2& b2Body::GetWorldCenter() const
+inline b2Vec2 b2Body::GetWorldCenter() const
 {
-	return m_sweep.c;
+	return Sweep().c;
 }
 
-inline const b2Vec2& b2Body::GetLocalCenter() const
+inline b2Vec2 b2Body::GetLocalCenter() const
 {
-	return m_sweep.localCenter;
+	return Sweep().localCenter;
 }
 
 inline void b2Body::SetLinearVelocity(const b2Vec2& v)
@@ -508,12 +544,12 @@ inline void b2Body::SetLinearVelocity(const b2Vec2& v)
 		SetAwake(true);
 	}
 
-	m_linearVelocity = v;
+	LinearVelocity() = v;
 }
 
-inline const b2Vec2& b2Body::GetLinearVelocity() const
+inline b2Vec2 b2Body::GetLinearVelocity() const
 {
-	return m_linearVelocity;
+	return LinearVelocity();
 }
 
 inline void b2Body::SetAngularVelocity(float32 w)
@@ -528,12 +564,12 @@ inline void b2Body::SetAngularVelocity(float32 w)
 		SetAwake(true);
 	}
 
-	m_angularVelocity = w;
+	AngularVelocity() = w;
 }
 
 inline float32 b2Body::GetAngularVelocity() const
 {
-	return m_angularVelocity;
+	return AngularVelocity();
 }
 
 inline float32 b2Body::GetMass() const
@@ -543,14 +579,14 @@ inline float32 b2Body::GetMass() const
 
 inline float32 b2Body::GetInertia() const
 {
-	return m_I + m_mass * b2Dot(m_sweep.localCenter, m_sweep.localCenter);
+	return m_I + m_mass * b2Dot(Sweep().localCenter, Sweep().localCenter);
 }
 
 inline void b2Body::GetMassData(b2MassData* data) const
 {
 	data->mass = m_mass;
-	data->I = m_I + m_mass * b2Dot(m_sweep.localCenter, m_sweep.localCenter);
-	data->center = m_sweep.localCenter;
+	data->I = m_I + m_mass * b2Dot(Sweep().localCenter, Sweep().localCenter);
+	data->center = Sweep().localCenter;
 }
 
 inline b2Vec2 b2Body::GetWorldPoint(const b2Vec2& localPoint) const
@@ -575,7 +611,7 @@ inline b2Vec2 b2Body::GetLocalVector(const b2Vec2& worldVector) const
 
 inline b2Vec2 b2Body::GetLinearVelocityFromWorldPoint(const b2Vec2& worldPoint) const
 {
-	return m_linearVelocity + b2Cross(m_angularVelocity, worldPoint - m_sweep.c);
+	return LinearVelocity() + b2Cross(AngularVelocity(), worldPoint - Sweep().c);
 }
 
 inline b2Vec2 b2Body::GetLinearVelocityFromLocalPoint(const b2Vec2& localPoint) const
@@ -644,10 +680,10 @@ inline void b2Body::SetAwake(bool flag)
 	{
 		m_flags &= ~e_awakeFlag;
 		m_sleepTime = 0.0f;
-		m_linearVelocity.SetZero();
-		m_angularVelocity = 0.0f;
-		m_force.SetZero();
-		m_torque = 0.0f;
+		LinearVelocity().SetZero();
+		AngularVelocity() = 0.0f;
+		Force().SetZero();
+		Torque() = 0.0f;
 	}
 }
 
@@ -704,6 +740,11 @@ inline const b2JointEdge* b2Body::GetJointList() const
 	return m_jointList;
 }
 
+inline bool b2Body::IsEditing() const
+{
+	return (m_flags & e_editFlag) == e_editFlag;
+}
+
 inline b2ContactEdge* b2Body::GetContactList()
 {
 	return m_contactList;
@@ -714,6 +755,16 @@ inline const b2ContactEdge* b2Body::GetContactList() const
 	return m_contactList;
 }
 
+inline b2SensorEdge* b2Body::GetSensorList()
+{
+	return m_sensorList;
+}
+
+inline const b2SensorEdge* b2Body::GetSensorList() const
+{
+	return m_sensorList;
+}
+
 inline b2Body* b2Body::GetNext()
 {
 	return m_next;
@@ -729,6 +780,51 @@ inline void b2Body::SetUserData(void* data)
 	m_userData = data;
 }
 
+inline b2BodyHandle b2Body::GetHandle() const
+{
+	return m_storage->GetHandle(m_slot);
+}
+
+inline b2Sweep& b2Body::Sweep()
+{
+	return m_storage->m_sweeps[m_stateIndex];
+}
+
+inline const b2Sweep& b2Body::Sweep() const
+{
+	return m_storage->m_sweeps[m_stateIndex];
+}
+
+inline b2Vec2& b2Body::LinearVelocity()
+{
+	return m_storage->m_linearVelocities[m_stateIndex];
+}
+
+inline const b2Vec2& b2Body::LinearVelocity() const
+{
+	return m_storage->m_linearVelocities[m_stateIndex];
+}
+
+inline float32& b2Body::AngularVelocity()
+{
+	return m_storage->m_angularVelocities[m_stateIndex];
+}
+
+inline float32 b2Body::AngularVelocity() const
+{
+	return m_storage->m_angularVelocities[m_stateIndex];
+}
+
+inline b2Vec2& b2Body::Force()
+{
+	return m_storage->m_forces[m_stateIndex];
+}
+
+inline float32& b2Body::Torque()
+{
+	return m_storage->m_torques[m_stateIndex];
+}
+
 inline void* b2Body::GetUserData() const
 {
 	return m_userData;
@@ -749,8 +845,8 @@ inline void b2Body::ApplyForce(const b2Vec2& force, const b2Vec2& point, bool wa
 	// Don't accumulate a force if the body is sleeping.
 	if (m_flags & e_awakeFlag)
 	{
-		m_force += force;
-		m_torque += b2Cross(point - m_sweep.c, force);
+		Force() += force;
+		Torque() += b2Cross(point - Sweep().c, force);
 	}
 }
 
@@ -769,7 +865,7 @@ inline void b2Body::ApplyForceToCenter(const b2Vec2& force, bool wake)
 	// Don't accumulate a force if the body is sleeping
 	if (m_flags & e_awakeFlag)
 	{
-		m_force += force;
+		Force() += force;
 	}
 }
 
@@ -788,7 +884,7 @@ inline void b2Body::ApplyTorque(float32 torque, bool wake)
 	// Don't accumulate a force if the body is sleeping
 	if (m_flags & e_awakeFlag)
 	{
-		m_torque += torque;
+		Torque() += torque;
 	}
 }
 
@@ -807,8 +903,8 @@ inline void b2Body::ApplyLinearImpulse(const b2Vec2& impulse, const b2Vec2& poin
 	// Don't accumulate velocity if the body is sleeping
 	if (m_flags & e_awakeFlag)
 	{
-		m_linearVelocity += m_invMass * impulse;
-		m_angularVelocity += m_invI * b2Cross(point - m_sweep.c, impulse);
+		LinearVelocity() += m_invMass * impulse;
+		AngularVelocity() += m_invI * b2Cross(point - Sweep().c, impulse);
 	}
 }
 
@@ -827,24 +923,26 @@ inline void b2Body::ApplyAngularImpulse(float32 impulse, bool wake)
 	// Don't accumulate velocity if the body is sleeping
 	if (m_flags & e_awakeFlag)
 	{
-		m_angularVelocity += m_invI * impulse;
+		AngularVelocity() += m_invI * impulse;
 	}
 }
 
 inline void b2Body::SynchronizeTransform()
 {
-	m_xf.q.Set(m_sweep.a);
-	m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+	const b2Sweep& sweep = Sweep();
+	m_xf.q.Set(sweep.a);
+	m_xf.p = sweep.c - b2Mul(m_xf.q, sweep.localCenter);
 }
 
 inline void b2Body::Advance(float32 alpha)
 {
 	// Advance to the new safe time. This doesn't sync the broad-phase.
-	m_sweep.Advance(alpha);
-	m_sweep.c = m_sweep.c0;
-	m_sweep.a = m_sweep.a0;
-	m_xf.q.Set(m_sweep.a);
-	m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+	b2Sweep& sweep = Sweep();
+	sweep.Advance(alpha);
+	sweep.c = sweep.c0;
+	sweep.a = sweep.a0;
+	m_xf.q.Set(sweep.a);
+	m_xf.p = sweep.c - b2Mul(m_xf.q, sweep.localCenter);
 }
 
 inline b2World* b2Body::GetWorld()
@@ -857,4 +955,25 @@ inline const b2World* b2Body::GetWorld() const
 	return m_world;
 }
 
+/// Keeps a body in a batch edit for the lifetime of the scope.
+class b2BodyEditScope
+{
+public:
+	explicit b2BodyEditScope(b2Body* body) : m_body(body)
+	{
+		m_body->BeginEdit();
+	}
+
+	~b2BodyEditScope()
+	{
+		m_body->EndEdit();
+	}
+
+private:
+	b2BodyEditScope(const b2BodyEditScope&);
+	b2BodyEditScope& operator=(const b2BodyEditScope&);
+
+	b2Body* m_body;
+};
+
 #endif
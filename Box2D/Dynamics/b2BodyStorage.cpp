@@ -0,0 +1,215 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Dynamics/b2BodyStorage.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Common/b2AllocatorInterface.h>
+#include <memory.h>
+
+const int32 b2_nullSlot = -1;
+
+b2BodyStorage::b2BodyStorage(b2AllocatorInterface* allocator)
+{
+	m_memory = allocator ? allocator : b2GetDefaultAllocator();
+
+	m_sweeps = NULL;
+	m_linearVelocities = NULL;
+	m_angularVelocities = NULL;
+	m_forces = NULL;
+	m_torques = NULL;
+	m_bodies = NULL;
+	m_stateSlots = NULL;
+	m_count = 0;
+	m_capacity = 0;
+
+	m_slots = NULL;
+	m_slotCount = 0;
+	m_slotCapacity = 0;
+	m_freeSlot = b2_nullSlot;
+}
+
+b2BodyStorage::~b2BodyStorage()
+{
+	m_memory->Free(m_sweeps);
+	m_memory->Free(m_linearVelocities);
+	m_memory->Free(m_angularVelocities);
+	m_memory->Free(m_forces);
+	m_memory->Free(m_torques);
+	m_memory->Free(m_bodies);
+	m_memory->Free(m_stateSlots);
+	m_memory->Free(m_slots);
+}
+
+template <typename T>
+static T* b2GrowArray(b2AllocatorInterface* memory, T* array, int32 count, int32 capacity)
+{
+	T* newArray = (T*)memory->Allocate(capacity * sizeof(T));
+	if (count > 0)
+	{
+		memcpy(newArray, array, count * sizeof(T));
+	}
+	memory->Free(array);
+	return newArray;
+}
+
+void b2BodyStorage::Grow(int32 capacity)
+{
+	m_sweeps = b2GrowArray(m_memory, m_sweeps, m_count, capacity);
+	m_linearVelocities = b2GrowArray(m_memory, m_linearVelocities, m_count, capacity);
+	m_angularVelocities = b2GrowArray(m_memory, m_angularVelocities, m_count, capacity);
+	m_forces = b2GrowArray(m_memory, m_forces, m_count, capacity);
+	m_torques = b2GrowArray(m_memory, m_torques, m_count, capacity);
+	m_bodies = b2GrowArray(m_memory, m_bodies, m_count, capacity);
+	m_stateSlots = b2GrowArray(m_memory, m_stateSlots, m_count, capacity);
+	m_capacity = capacity;
+}
+
+int32 b2BodyStorage::Create(b2Body* body)
+{
+	if (m_freeSlot == b2_nullSlot)
+	{
+		if (m_slotCount == m_slotCapacity)
+		{
+			m_slotCapacity = m_slotCapacity > 0 ? 2 * m_slotCapacity : 16;
+			m_slots = b2GrowArray(m_memory, m_slots, m_slotCount, m_slotCapacity);
+		}
+
+		m_slots[m_slotCount].generation = 0;
+		m_slots[m_slotCount].next = b2_nullSlot;
+		m_freeSlot = m_slotCount;
+		++m_slotCount;
+	}
+
+	if (m_count == m_capacity)
+	{
+		Grow(m_capacity > 0 ? 2 * m_capacity : 16);
+	}
+
+	int32 slot = m_freeSlot;
+	m_freeSlot = m_slots[slot].next;
+	m_slots[slot].stateIndex = m_count;
+
+	m_bodies[m_count] = body;
+	m_stateSlots[m_count] = slot;
+	body->m_stateIndex = m_count;
+	++m_count;
+
+	return slot;
+}
+
+void b2BodyStorage::Destroy(int32 slot)
+{
+	b2Assert(0 <= slot && slot < m_slotCount);
+
+	int32 index = m_slots[slot].stateIndex;
+	int32 last = m_count - 1;
+	if (index != last)
+	{
+		m_sweeps[index] = m_sweeps[last];
+		m_linearVelocities[index] = m_linearVelocities[last];
+		m_angularVelocities[index] = m_angularVelocities[last];
+		m_forces[index] = m_forces[last];
+		m_torques[index] = m_torques[last];
+		m_bodies[index] = m_bodies[last];
+		m_stateSlots[index] = m_stateSlots[last];
+		m_slots[m_stateSlots[index]].stateIndex = index;
+		m_bodies[index]->m_stateIndex = index;
+	}
+	--m_count;
+
+	// Bump the generation so that old handles no longer resolve.
+	++m_slots[slot].generation;
+	m_slots[slot].stateIndex = b2_nullSlot;
+	m_slots[slot].next = m_freeSlot;
+	m_freeSlot = slot;
+}
+
+void b2BodyStorage::Reserve(int32 count)
+{
+	if (m_count + count > m_capacity)
+	{
+		Grow(m_count + count);
+	}
+
+	// The free slots are used first.
+	int32 freeCount = 0;
+	for (int32 slot = m_freeSlot; slot != b2_nullSlot; slot = m_slots[slot].next)
+	{
+		++freeCount;
+	}
+
+	int32 slotCapacity = m_slotCount + count - freeCount;
+	if (slotCapacity > m_slotCapacity)
+	{
+		m_slots = b2GrowArray(m_memory, m_slots, m_slotCount, slotCapacity);
+		m_slotCapacity = slotCapacity;
+	}
+}
+
+void b2BodyStorage::Clear()
+{
+	// Free every slot, bumping the generation of those in use.
+	m_freeSlot = b2_nullSlot;
+	for (int32 slot = m_slotCount - 1; slot >= 0; --slot)
+	{
+		if (m_slots[slot].stateIndex != b2_nullSlot)
+		{
+			++m_slots[slot].generation;
+			m_slots[slot].stateIndex = b2_nullSlot;
+		}
+		m_slots[slot].next = m_freeSlot;
+		m_freeSlot = slot;
+	}
+
+	m_count = 0;
+}
+
+b2BodyHandle b2BodyStorage::GetHandle(int32 slot) const
+{
+	b2Assert(0 <= slot && slot < m_slotCount);
+	b2BodyHandle handle;
+	handle.index = slot;
+	handle.generation = m_slots[slot].generation;
+	return handle;
+}
+
+b2Body* b2BodyStorage::GetBody(b2BodyHandle handle) const
+{
+	if (handle.index < 0 || handle.index >= m_slotCount)
+	{
+		return NULL;
+	}
+
+	const b2BodySlot& slot = m_slots[handle.index];
+	if (slot.generation != handle.generation || slot.stateIndex == b2_nullSlot)
+	{
+		return NULL;
+	}
+
+	return m_bodies[slot.stateIndex];
+}
+
+void b2BodyStorage::ClearForces()
+{
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_forces[i].SetZero();
+	}
+	memset(m_torques, 0, m_count * sizeof(float32));
+}
@@ -0,0 +1,99 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_BODY_STORAGE_H
+#define B2_BODY_STORAGE_H
+
+#include <Box2D/Common/b2Math.h>
+
+class b2Body;
+class b2AllocatorInterface;
+
+/// A stable reference to a body. A handle to a destroyed body resolves to NULL,
+/// even after its slot has been reused by a new body.
+struct b2BodyHandle
+{
+	int32 index;
+	uint32 generation;
+};
+
+/// The state of all the bodies of a world that the solver reads and writes every
+/// step. Each field is kept in its own dense array, so a loop over the bodies walks
+/// contiguous memory. A body keeps its handle for life, but its position in the
+/// arrays changes when another body is destroyed.
+class b2BodyStorage
+{
+public:
+	b2BodyStorage(b2AllocatorInterface* allocator = NULL);
+	~b2BodyStorage();
+
+	/// Add a body. This sets the body's state index and returns its slot. The body
+	/// initializes its state.
+	int32 Create(b2Body* body);
+
+	/// Remove the state of a body. The last state moves into the hole.
+	void Destroy(int32 slot);
+
+	/// Make room for count more bodies.
+	void Reserve(int32 count);
+
+	/// Remove all the states. Every handle stops resolving.
+	void Clear();
+
+	/// Get the handle of a slot in use.
+	b2BodyHandle GetHandle(int32 slot) const;
+
+	/// Get the body of a handle, or NULL if the body was destroyed.
+	b2Body* GetBody(b2BodyHandle handle) const;
+
+	/// Zero the forces and torques of all the bodies.
+	void ClearForces();
+
+	// The states. There are m_count of each.
+	b2Sweep* m_sweeps;
+	b2Vec2* m_linearVelocities;
+	float32* m_angularVelocities;
+	b2Vec2* m_forces;
+	float32* m_torques;
+	b2Body** m_bodies;
+	int32* m_stateSlots;
+	int32 m_count;
+	int32 m_capacity;
+
+private:
+
+	// A slot maps a handle to a state index. Free slots are linked through next.
+	struct b2BodySlot
+	{
+		int32 stateIndex;
+		int32 next;
+		uint32 generation;
+	};
+
+	void Grow(int32 capacity);
+
+	b2AllocatorInterface* m_memory;
+
+	b2BodySlot* m_slots;
+	int32 m_slotCount;
+	int32 m_slotCapacity;
+	int32 m_freeSlot;
+};
+
+#endif
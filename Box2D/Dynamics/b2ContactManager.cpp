@@ -17,21 +17,64 @@
 */
 
 #include <Box2D/Dynamics/b2ContactManager.h>
+#include <Box2D/Common/b2AllocatorInterface.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2SensorOverlap.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <memory.h>
+#include <new>
 
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
 
-b2ContactManager::b2ContactManager()
+b2ContactManager::b2ContactManager(b2AllocatorInterface* allocator)
+	: m_broadPhase(allocator), m_impulseCache(allocator)
 {
-	m_contactList = NULL;
+	m_memory = allocator ? allocator : b2GetDefaultAllocator();
 	m_contactCount = 0;
+	m_contactCapacity = 16;
+	m_contacts = (b2ContactRef*)m_memory->Allocate(m_contactCapacity * sizeof(b2ContactRef));
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
 	m_allocator = NULL;
+
+	m_collideCapacity = 16;
+	m_collideBuffer = (b2Contact**)m_memory->Allocate(2 * m_collideCapacity * sizeof(b2Contact*));
+	m_sortedBuffer = m_collideBuffer + m_collideCapacity;
+
+	m_sensorList = NULL;
+	m_sensorCount = 0;
+
+	m_sensorCapacity = 16;
+	m_sensorBuffer = (b2SensorOverlap**)m_memory->Allocate(m_sensorCapacity * sizeof(b2SensorOverlap*));
+
+	for (int32 i = 0; i < b2_maxCollisionLayers; ++i)
+	{
+		m_layerMatrix[i] = 0xFFFFFFFF;
+	}
+}
+
+b2ContactManager::~b2ContactManager()
+{
+	m_memory->Free(m_contacts);
+	m_memory->Free(m_collideBuffer);
+	m_memory->Free(m_sensorBuffer);
+}
+
+bool b2ContactManager::ShouldCollideLayers(const b2Fixture* fixtureA, const b2Fixture* fixtureB) const
+{
+	const b2Filter& filterA = fixtureA->m_filter;
+	const b2Filter& filterB = fixtureB->m_filter;
+
+	// Group filtering overrides the layer matrix.
+	if (filterA.groupIndex == filterB.groupIndex && filterA.groupIndex != 0)
+	{
+		return filterA.groupIndex > 0;
+	}
+
+	return (m_layerMatrix[filterA.layer] & (1u << filterB.layer)) != 0;
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -46,20 +89,14 @@ void b2ContactManager::Destroy(b2Contact* c)
 		m_contactListener->EndContact(c);
 	}
 
-	// Remove from the world.
-	if (c->m_prev)
-	{
-		c->m_prev->m_next = c->m_next;
-	}
-
-	if (c->m_next)
-	{
-		c->m_next->m_prev = c->m_prev;
-	}
-
-	if (c == m_contactList)
+	// Remove from the world by moving the last contact into this slot.
+	int32 index = c->m_managerIndex;
+	b2Assert(0 <= index && index < m_contactCount && m_contacts[index].contact == c);
+	--m_contactCount;
+	if (index < m_contactCount)
 	{
-		m_contactList = c->m_next;
+		m_contacts[index] = m_contacts[m_contactCount];
+		m_contacts[index].contact->m_managerIndex = index;
 	}
 
 	// Remove from body 1
@@ -96,43 +133,121 @@ void b2ContactManager::Destroy(b2Contact* c)
 
 	// Call the factory.
 	b2Contact::Destroy(c, m_allocator);
-	--m_contactCount;
+}
+
+void b2ContactManager::Clear()
+{
+	// Some contacts keep manifolds outside the block allocator.
+	for (int32 i = 0; i < m_contactCount; ++i)
+	{
+		b2Contact::Destroy(m_contacts[i].contact, m_allocator);
+	}
+	m_contactCount = 0;
+
+	b2SensorOverlap* s = m_sensorList;
+	while (s)
+	{
+		b2SensorOverlap* sNext = s->m_next;
+		s->~b2SensorOverlap();
+		m_allocator->Free(s, sizeof(b2SensorOverlap));
+		s = sNext;
+	}
+	m_sensorList = NULL;
+	m_sensorCount = 0;
+
+	m_broadPhase.Clear();
+	m_impulseCache.Clear();
+}
+
+void b2ContactManager::Retire(b2Contact* c)
+{
+	if (c->HasPrimitiveTree() == false)
+	{
+		m_impulseCache.Store(c->m_fixtureA->m_id, c->m_indexA, c->m_fixtureB->m_id, c->m_indexB, c->m_manifold);
+	}
+
+	Destroy(c);
+}
+
+void b2ContactManager::Link(b2Contact* c)
+{
+	if (m_contactCount == m_contactCapacity)
+	{
+		b2ContactRef* oldContacts = m_contacts;
+		m_contactCapacity *= 2;
+		m_contacts = (b2ContactRef*)m_memory->Allocate(m_contactCapacity * sizeof(b2ContactRef));
+		memcpy(m_contacts, oldContacts, m_contactCount * sizeof(b2ContactRef));
+		m_memory->Free(oldContacts);
+	}
+
+	b2Fixture* fixtureA = c->m_fixtureA;
+	b2Fixture* fixtureB = c->m_fixtureB;
+
+	b2ContactRef* ref = m_contacts + m_contactCount;
+	ref->contact = c;
+	ref->bodyA = fixtureA->m_body;
+	ref->bodyB = fixtureB->m_body;
+	ref->proxyIdA = fixtureA->m_proxies[c->m_indexA].proxyId;
+	ref->proxyIdB = fixtureB->m_proxies[c->m_indexB].proxyId;
+	ref->typePair = fixtureA->GetType() * b2Shape::e_typeCount + fixtureB->GetType();
+	c->m_manager = this;
+	c->m_managerIndex = m_contactCount;
+	++m_contactCount;
 }
 
 // This is the top level collision call for the time step. Here
 // all the narrow phase collision is processed for the world
 // contact list.
-void b2ContactManager::Collide()
+void b2ContactManager::Collide(float32 speculativeTime)
 {
-	// Update awake contacts.
-	b2Contact* c = m_contactList;
-	while (c)
-	{
-		b2Fixture* fixtureA = c->GetFixtureA();
-		b2Fixture* fixtureB = c->GetFixtureB();
-		int32 indexA = c->GetChildIndexA();
-		int32 indexB = c->GetChildIndexB();
-		b2Body* bodyA = fixtureA->GetBody();
-		b2Body* bodyB = fixtureB->GetBody();
-		 
+	const int32 typePairCount = b2Shape::e_typeCount * b2Shape::e_typeCount;
+	int32 typePairCounts[typePairCount] = {0};
+	int32 collideCount = 0;
+	int32 seedCount = 0;
+
+	m_impulseCache.Step();
+
+	// Filter and gather awake contacts. A destroyed contact is replaced by the
+	// last one, so the index only advances past contacts that persist.
+	int32 index = 0;
+	while (index < m_contactCount)
+	{
+		const b2ContactRef* ref = m_contacts + index;
+		b2Contact* c = ref->contact;
+		b2Body* bodyA = ref->bodyA;
+		b2Body* bodyB = ref->bodyB;
+
 		// Is this contact flagged for filtering?
 		if (c->m_flags & b2Contact::e_filterFlag)
 		{
+			b2Fixture* fixtureA = c->GetFixtureA();
+			b2Fixture* fixtureB = c->GetFixtureB();
+
+			// Are these layers allowed to collide?
+			if (ShouldCollideLayers(fixtureA, fixtureB) == false)
+			{
+				Retire(c);
+				continue;
+			}
+
+			// Did a fixture become a sensor?
+			if (fixtureA->IsSensor() || fixtureB->IsSensor())
+			{
+				Retire(c);
+				continue;
+			}
+
 			// Should these bodies collide?
 			if (bodyB->ShouldCollide(bodyA) == false)
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
+				Retire(c);
 				continue;
 			}
 
 			// Check user filtering.
 			if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
+				Retire(c);
 				continue;
 			}
 
@@ -146,26 +261,92 @@ void b2ContactManager::Collide()
 		// At least one body must be awake and it must be dynamic or kinematic.
 		if (activeA == false && activeB == false)
 		{
-			c = c->GetNext();
+			++index;
 			continue;
 		}
 
-		int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
-		int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
-		bool overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+		bool overlap = m_broadPhase.TestOverlap(ref->proxyIdA, ref->proxyIdB);
 
 		// Here we destroy contacts that cease to overlap in the broad-phase.
 		if (overlap == false)
 		{
-			b2Contact* cNuke = c;
-			c = cNuke->GetNext();
-			Destroy(cNuke);
+			Retire(c);
 			continue;
 		}
 
 		// The contact persists.
-		c->Update(m_contactListener);
-		c = c->GetNext();
+		if (collideCount == m_collideCapacity)
+		{
+			b2Contact** oldBuffer = m_collideBuffer;
+			m_collideCapacity *= 2;
+			m_collideBuffer = (b2Contact**)m_memory->Allocate(2 * m_collideCapacity * sizeof(b2Contact*));
+			m_sortedBuffer = m_collideBuffer + m_collideCapacity;
+			memcpy(m_collideBuffer, oldBuffer, collideCount * sizeof(b2Contact*));
+			m_memory->Free(oldBuffer);
+		}
+
+		m_collideBuffer[collideCount++] = c;
+		if (c->m_flags & b2Contact::e_impulseSeedFlag)
+		{
+			++seedCount;
+		}
+		++typePairCounts[ref->typePair];
+		++index;
+	}
+
+	// Bucket the contacts by shape-pair type so that each narrow-phase kernel
+	// runs over a contiguous batch.
+	int32 typePairOffsets[typePairCount];
+	int32 offset = 0;
+	for (int32 i = 0; i < typePairCount; ++i)
+	{
+		typePairOffsets[i] = offset;
+		offset += typePairCounts[i];
+	}
+
+	for (int32 i = 0; i < collideCount; ++i)
+	{
+		b2Contact* contact = m_collideBuffer[i];
+		int32 typePair = m_contacts[contact->m_managerIndex].typePair;
+		m_sortedBuffer[typePairOffsets[typePair]++] = contact;
+	}
+
+	// Update the persisting contacts.
+	offset = 0;
+	for (int32 i = 0; i < typePairCount; ++i)
+	{
+		b2Contact::UpdateBatch(m_sortedBuffer + offset, typePairCounts[i], m_contactListener, speculativeTime);
+		offset += typePairCounts[i];
+	}
+
+	if (seedCount == 0)
+	{
+		return;
+	}
+
+	// Warm start new contacts from the impulses of retired contacts between the
+	// same fixtures. A new contact is seeded once it first has manifold points.
+	bool live = m_impulseCache.IsLive();
+	for (int32 i = 0; i < collideCount; ++i)
+	{
+		b2Contact* contact = m_collideBuffer[i];
+		if ((contact->m_flags & b2Contact::e_impulseSeedFlag) == 0)
+		{
+			continue;
+		}
+
+		if (live == false)
+		{
+			contact->m_flags &= ~b2Contact::e_impulseSeedFlag;
+			continue;
+		}
+
+		if (contact->m_manifold.pointCount > 0)
+		{
+			m_impulseCache.Seed(contact->m_fixtureA->m_id, contact->m_indexA,
+								contact->m_fixtureB->m_id, contact->m_indexB, &contact->m_manifold);
+			contact->m_flags &= ~b2Contact::e_impulseSeedFlag;
+		}
 	}
 }
 
@@ -194,6 +375,19 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 		return;
 	}
 
+	// Are these layers allowed to collide?
+	if (ShouldCollideLayers(fixtureA, fixtureB) == false)
+	{
+		return;
+	}
+
+	// Sensors only track overlap and never create contacts.
+	if (fixtureA->IsSensor() || fixtureB->IsSensor())
+	{
+		AddSensorPair(fixtureA, indexA, fixtureB, indexB);
+		return;
+	}
+
 	// TODO_ERIN use a hash table to remove a potential bottleneck when both
 	// bodies have a lot of contacts.
 	// Does a contact already exist?
@@ -242,22 +436,20 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 		return;
 	}
 
+	// A pair that touched recently may still have impulses in the cache.
+	if (m_impulseCache.IsLive() && c->HasPrimitiveTree() == false)
+	{
+		c->m_flags |= b2Contact::e_impulseSeedFlag;
+	}
+
 	// Contact creation may swap fixtures.
 	fixtureA = c->GetFixtureA();
 	fixtureB = c->GetFixtureB();
-	indexA = c->GetChildIndexA();
-	indexB = c->GetChildIndexB();
 	bodyA = fixtureA->GetBody();
 	bodyB = fixtureB->GetBody();
 
 	// Insert into the world.
-	c->m_prev = NULL;
-	c->m_next = m_contactList;
-	if (m_contactList != NULL)
-	{
-		m_contactList->m_prev = c;
-	}
-	m_contactList = c;
+	Link(c);
 
 	// Connect to island graph.
 
@@ -286,11 +478,281 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	bodyB->m_contactList = &c->m_nodeB;
 
 	// Wake up the bodies
-	if (fixtureA->IsSensor() == false && fixtureB->IsSensor() == false)
+	bodyA->SetAwake(true);
+	bodyB->SetAwake(true);
+}
+
+void b2ContactManager::AddSensorPair(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB)
+{
+	b2Body* bodyA = fixtureA->GetBody();
+	b2Body* bodyB = fixtureB->GetBody();
+
+	// Does a sensor overlap already exist?
+	b2SensorEdge* edge = bodyB->m_sensorList;
+	while (edge)
+	{
+		if (edge->other == bodyA)
+		{
+			b2SensorOverlap* s = edge->overlap;
+			b2Fixture* fA = s->m_fixtureA;
+			b2Fixture* fB = s->m_fixtureB;
+			int32 iA = s->m_indexA;
+			int32 iB = s->m_indexB;
+
+			if (fA == fixtureA && fB == fixtureB && iA == indexA && iB == indexB)
+			{
+				// A sensor overlap already exists.
+				return;
+			}
+
+			if (fA == fixtureB && fB == fixtureA && iA == indexB && iB == indexA)
+			{
+				// A sensor overlap already exists.
+				return;
+			}
+		}
+
+		edge = edge->next;
+	}
+
+	// Does a joint override collision? Is at least one body dynamic?
+	if (bodyB->ShouldCollide(bodyA) == false)
+	{
+		return;
+	}
+
+	// Check user filtering.
+	if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
 	{
-		bodyA->SetAwake(true);
-		bodyB->SetAwake(true);
+		return;
 	}
 
-	++m_contactCount;
+	void* mem = m_allocator->Allocate(sizeof(b2SensorOverlap));
+	b2SensorOverlap* s = new (mem) b2SensorOverlap;
+
+	s->m_flags = 0;
+	s->m_fixtureA = fixtureA;
+	s->m_fixtureB = fixtureB;
+	s->m_indexA = indexA;
+	s->m_indexB = indexB;
+	s->m_simplexCache.count = 0;
+
+	// Insert into the world.
+	s->m_prev = NULL;
+	s->m_next = m_sensorList;
+	if (m_sensorList != NULL)
+	{
+		m_sensorList->m_prev = s;
+	}
+	m_sensorList = s;
+
+	// Connect to body A
+	s->m_nodeA.overlap = s;
+	s->m_nodeA.other = bodyB;
+
+	s->m_nodeA.prev = NULL;
+	s->m_nodeA.next = bodyA->m_sensorList;
+	if (bodyA->m_sensorList != NULL)
+	{
+		bodyA->m_sensorList->prev = &s->m_nodeA;
+	}
+	bodyA->m_sensorList = &s->m_nodeA;
+
+	// Connect to body B
+	s->m_nodeB.overlap = s;
+	s->m_nodeB.other = bodyA;
+
+	s->m_nodeB.prev = NULL;
+	s->m_nodeB.next = bodyB->m_sensorList;
+	if (bodyB->m_sensorList != NULL)
+	{
+		bodyB->m_sensorList->prev = &s->m_nodeB;
+	}
+	bodyB->m_sensorList = &s->m_nodeB;
+
+	++m_sensorCount;
+}
+
+void b2ContactManager::DestroySensor(b2SensorOverlap* s)
+{
+	b2Body* bodyA = s->m_fixtureA->GetBody();
+	b2Body* bodyB = s->m_fixtureB->GetBody();
+
+	if (m_contactListener && s->IsTouching())
+	{
+		m_contactListener->EndSensorOverlap(s);
+	}
+
+	// Remove from the world.
+	if (s->m_prev)
+	{
+		s->m_prev->m_next = s->m_next;
+	}
+
+	if (s->m_next)
+	{
+		s->m_next->m_prev = s->m_prev;
+	}
+
+	if (s == m_sensorList)
+	{
+		m_sensorList = s->m_next;
+	}
+
+	// Remove from body 1
+	if (s->m_nodeA.prev)
+	{
+		s->m_nodeA.prev->next = s->m_nodeA.next;
+	}
+
+	if (s->m_nodeA.next)
+	{
+		s->m_nodeA.next->prev = s->m_nodeA.prev;
+	}
+
+	if (&s->m_nodeA == bodyA->m_sensorList)
+	{
+		bodyA->m_sensorList = s->m_nodeA.next;
+	}
+
+	// Remove from body 2
+	if (s->m_nodeB.prev)
+	{
+		s->m_nodeB.prev->next = s->m_nodeB.next;
+	}
+
+	if (s->m_nodeB.next)
+	{
+		s->m_nodeB.next->prev = s->m_nodeB.prev;
+	}
+
+	if (&s->m_nodeB == bodyB->m_sensorList)
+	{
+		bodyB->m_sensorList = s->m_nodeB.next;
+	}
+
+	s->~b2SensorOverlap();
+	m_allocator->Free(s, sizeof(b2SensorOverlap));
+	--m_sensorCount;
+}
+
+void b2ContactManager::UpdateSensors()
+{
+	// Filter and gather awake sensor overlaps.
+	int32 count = 0;
+	b2SensorOverlap* s = m_sensorList;
+	while (s)
+	{
+		b2Fixture* fixtureA = s->m_fixtureA;
+		b2Fixture* fixtureB = s->m_fixtureB;
+		b2Body* bodyA = fixtureA->GetBody();
+		b2Body* bodyB = fixtureB->GetBody();
+
+		// Is this sensor overlap flagged for filtering?
+		if (s->m_flags & b2SensorOverlap::e_filterFlag)
+		{
+			// Did both fixtures stop being sensors? Also check the layers, the
+			// bodies, and the user filter.
+			if ((fixtureA->IsSensor() == false && fixtureB->IsSensor() == false) ||
+				ShouldCollideLayers(fixtureA, fixtureB) == false ||
+				bodyB->ShouldCollide(bodyA) == false ||
+				(m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false))
+			{
+				b2SensorOverlap* sNuke = s;
+				s = sNuke->GetNext();
+				DestroySensor(sNuke);
+				continue;
+			}
+
+			// Clear the filtering flag.
+			s->m_flags &= ~b2SensorOverlap::e_filterFlag;
+		}
+
+		bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+		bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+
+		// At least one body must be awake and it must be dynamic or kinematic.
+		if (activeA == false && activeB == false)
+		{
+			s = s->GetNext();
+			continue;
+		}
+
+		int32 proxyIdA = fixtureA->m_proxies[s->m_indexA].proxyId;
+		int32 proxyIdB = fixtureB->m_proxies[s->m_indexB].proxyId;
+		bool overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+
+		// Here we destroy sensor overlaps that cease to overlap in the broad-phase.
+		if (overlap == false)
+		{
+			b2SensorOverlap* sNuke = s;
+			s = sNuke->GetNext();
+			DestroySensor(sNuke);
+			continue;
+		}
+
+		if (count == m_sensorCapacity)
+		{
+			b2SensorOverlap** oldBuffer = m_sensorBuffer;
+			m_sensorCapacity *= 2;
+			m_sensorBuffer = (b2SensorOverlap**)m_memory->Allocate(m_sensorCapacity * sizeof(b2SensorOverlap*));
+			memcpy(m_sensorBuffer, oldBuffer, count * sizeof(b2SensorOverlap*));
+			m_memory->Free(oldBuffer);
+		}
+
+		m_sensorBuffer[count++] = s;
+		s = s->GetNext();
+	}
+
+	ComputeSensorOverlaps(0, count);
+
+	// Report the overlaps that began and ended.
+	for (int32 i = 0; i < count; ++i)
+	{
+		s = m_sensorBuffer[i];
+
+		bool touching = (s->m_flags & b2SensorOverlap::e_overlapFlag) == b2SensorOverlap::e_overlapFlag;
+		bool wasTouching = s->IsTouching();
+
+		if (touching)
+		{
+			s->m_flags |= b2SensorOverlap::e_touchingFlag;
+		}
+		else
+		{
+			s->m_flags &= ~b2SensorOverlap::e_touchingFlag;
+		}
+
+		if (wasTouching == false && touching == true && m_contactListener)
+		{
+			m_contactListener->BeginSensorOverlap(s);
+		}
+
+		if (wasTouching == true && touching == false && m_contactListener)
+		{
+			m_contactListener->EndSensorOverlap(s);
+		}
+	}
+}
+
+void b2ContactManager::ComputeSensorOverlaps(int32 begin, int32 end)
+{
+	for (int32 i = begin; i < end; ++i)
+	{
+		b2SensorOverlap* s = m_sensorBuffer[i];
+		const b2Shape* shapeA = s->m_fixtureA->GetShape();
+		const b2Shape* shapeB = s->m_fixtureB->GetShape();
+		const b2Transform& xfA = s->m_fixtureA->GetBody()->GetTransform();
+		const b2Transform& xfB = s->m_fixtureB->GetBody()->GetTransform();
+
+		bool touching = b2TestOverlap(shapeA, s->m_indexA, shapeB, s->m_indexB, xfA, xfB, &s->m_simplexCache);
+		if (touching)
+		{
+			s->m_flags |= b2SensorOverlap::e_overlapFlag;
+		}
+		else
+		{
+			s->m_flags &= ~b2SensorOverlap::e_overlapFlag;
+		}
+	}
 }
@@ -20,17 +20,35 @@
 #define B2_CONTACT_MANAGER_H
 
 #include <Box2D/Collision/b2BroadPhase.h>
+#include <Box2D/Dynamics/Contacts/b2ImpulseCache.h>
 
 class b2Contact;
+class b2SensorOverlap;
+class b2Fixture;
 class b2ContactFilter;
 class b2ContactListener;
 class b2BlockAllocator;
+class b2AllocatorInterface;
+class b2Body;
+
+/// The hot half of a contact: the data the narrow-phase gather touches for every
+/// contact each step. The contact object holds the cold half.
+struct b2ContactRef
+{
+	b2Contact* contact;
+	b2Body* bodyA;
+	b2Body* bodyB;
+	int32 proxyIdA;
+	int32 proxyIdB;
+	int32 typePair;
+};
 
 // Delegate of b2World.
 class b2ContactManager
 {
 public:
-	b2ContactManager();
+	b2ContactManager(b2AllocatorInterface* allocator = NULL);
+	~b2ContactManager();
 
 	// Broad-phase callback.
 	void AddPair(void* proxyUserDataA, void* proxyUserDataB);
@@ -39,14 +57,65 @@ public:
 
 	void Destroy(b2Contact* c);
 
-	void Collide();
-            
+	// Destroy all the contacts, sensor overlaps and proxies at once. The body edges
+	// are left dangling and no listener is called.
+	void Clear();
+
+	// Append a contact to the dense array. This does not connect the body edges.
+	void Link(b2Contact* c);
+
+	// Destroy a contact whose fixtures live on. Its impulses are kept to warm
+	// start a new contact if the fixtures touch again.
+	void Retire(b2Contact* c);
+
+	// Update the contact manifolds. A positive speculative time adds speculative
+	// points to contacts that may touch within that time.
+	void Collide(float32 speculativeTime);
+
+	void DestroySensor(b2SensorOverlap* s);
+
+	// Update the sensor overlaps. This runs once per time step after the solver.
+	void UpdateSensors();
+
+	// Layer matrix test. This runs before any contact bookkeeping so that
+	// non-interacting pairs cost a single table lookup.
+	bool ShouldCollideLayers(const b2Fixture* fixtureA, const b2Fixture* fixtureB) const;
+
+	b2AllocatorInterface* m_memory;
 	b2BroadPhase m_broadPhase;
-	b2Contact* m_contactList;
+
+	// Contacts are kept dense and destroyed by swap-remove, so any range
+	// [begin, end) of this array may be processed independently.
+	b2ContactRef* m_contacts;
 	int32 m_contactCount;
+	int32 m_contactCapacity;
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
+
+	// Contacts gathered for the narrow-phase, then bucketed by shape-pair type.
+	b2Contact** m_collideBuffer;
+	b2Contact** m_sortedBuffer;
+	int32 m_collideCapacity;
+
+	// Impulses of recently retired contacts.
+	b2ImpulseCache m_impulseCache;
+
+	b2SensorOverlap* m_sensorList;
+	int32 m_sensorCount;
+
+	// Sensor overlaps gathered for the overlap pass.
+	b2SensorOverlap** m_sensorBuffer;
+	int32 m_sensorCapacity;
+
+	void AddSensorPair(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB);
+
+	// Compute the overlap state of a range of gathered sensor overlaps. The
+	// overlaps are independent, so ranges may be processed in parallel.
+	void ComputeSensorOverlaps(int32 begin, int32 end);
+
+	// Bit j of m_layerMatrix[i] is set if layer i collides with layer j.
+	uint32 m_layerMatrix[b2_maxCollisionLayers];
 };
 
 #endif
@@ -18,11 +18,14 @@
 
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Dynamics/b2SensorOverlap.h>
 #include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Collision/Shapes/b2CapsuleShape.h>
 #include <Box2D/Collision/Shapes/b2CircleShape.h>
 #include <Box2D/Collision/Shapes/b2EdgeShape.h>
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
 #include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2CompoundShape.h>
 #include <Box2D/Collision/b2BroadPhase.h>
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Common/b2BlockAllocator.h>
@@ -46,8 +49,10 @@ void b2Fixture::Create(b2BlockAllocator* allocator, b2Body* body, const b2Fixtur
 
 	m_body = body;
 	m_next = NULL;
+	m_id = body->GetWorld()->m_fixtureIdCount++;
 
 	m_filter = def->filter;
+	b2Assert(m_filter.layer < b2_maxCollisionLayers);
 
 	m_isSensor = def->isSensor;
 
@@ -111,6 +116,22 @@ void b2Fixture::Destroy(b2BlockAllocator* allocator)
 		}
 		break;
 
+	case b2Shape::e_compound:
+		{
+			b2CompoundShape* s = (b2CompoundShape*)m_shape;
+			s->~b2CompoundShape();
+			allocator->Free(s, sizeof(b2CompoundShape));
+		}
+		break;
+
+	case b2Shape::e_capsule:
+		{
+			b2CapsuleShape* s = (b2CapsuleShape*)m_shape;
+			s->~b2CapsuleShape();
+			allocator->Free(s, sizeof(b2CapsuleShape));
+		}
+		break;
+
 	default:
 		b2Assert(false);
 		break;
@@ -149,7 +170,7 @@ void b2Fixture::DestroyProxies(b2BroadPhase* broadPhase)
 	m_proxyCount = 0;
 }
 
-void b2Fixture::Synchronize(b2BroadPhase* broadPhase, const b2Transform& transform1, const b2Transform& transform2)
+void b2Fixture::Synchronize(b2BroadPhase* broadPhase, const b2Transform& transform1, const b2Transform& transform2, const b2Vec2& prediction)
 {
 	if (m_proxyCount == 0)
 	{	
@@ -167,6 +188,14 @@ void b2Fixture::Synchronize(b2BroadPhase* broadPhase, const b2Transform& transfo
 	
 		proxy->aabb.Combine(aabb1, aabb2);
 
+		if (prediction.x != 0.0f || prediction.y != 0.0f)
+		{
+			b2AABB aabb3;
+			aabb3.lowerBound = aabb2.lowerBound + prediction;
+			aabb3.upperBound = aabb2.upperBound + prediction;
+			proxy->aabb.Combine(aabb3);
+		}
+
 		b2Vec2 displacement = transform2.p - transform1.p;
 
 		broadPhase->MoveProxy(proxy->proxyId, proxy->aabb, displacement);
@@ -175,6 +204,7 @@ void b2Fixture::Synchronize(b2BroadPhase* broadPhase, const b2Transform& transfo
 
 void b2Fixture::SetFilterData(const b2Filter& filter)
 {
+	b2Assert(filter.layer < b2_maxCollisionLayers);
 	m_filter = filter;
 
 	Refilter();
@@ -202,6 +232,19 @@ void b2Fixture::Refilter()
 		edge = edge->next;
 	}
 
+	// Flag associated sensor overlaps for filtering.
+	b2SensorEdge* sensorEdge = m_body->GetSensorList();
+	while (sensorEdge)
+	{
+		b2SensorOverlap* overlap = sensorEdge->overlap;
+		if (overlap->GetFixtureA() == this || overlap->GetFixtureB() == this)
+		{
+			overlap->FlagForFiltering();
+		}
+
+		sensorEdge = sensorEdge->next;
+	}
+
 	b2World* world = m_body->GetWorld();
 
 	if (world == NULL)
@@ -223,6 +266,10 @@ void b2Fixture::SetSensor(bool sensor)
 	{
 		m_body->SetAwake(true);
 		m_isSensor = sensor;
+
+		// Sensors and solid fixtures use different pair types, so the
+		// existing pairs are filtered out and new ones created.
+		Refilter();
 	}
 }
 
@@ -236,6 +283,7 @@ void b2Fixture::Dump(int32 bodyIndex)
 	b2Log("    fd.filter.categoryBits = uint16(%d);\n", m_filter.categoryBits);
 	b2Log("    fd.filter.maskBits = uint16(%d);\n", m_filter.maskBits);
 	b2Log("    fd.filter.groupIndex = int16(%d);\n", m_filter.groupIndex);
+	b2Log("    fd.filter.layer = uint8(%d);\n", m_filter.layer);
 
 	switch (m_shape->m_type)
 	{
@@ -289,6 +337,40 @@ void b2Fixture::Dump(int32 bodyIndex)
 			b2Log("    shape.m_nextVertex.Set(%.15lef, %.15lef);\n", s->m_nextVertex.x, s->m_nextVertex.y);
 			b2Log("    shape.m_hasPrevVertex = bool(%d);\n", s->m_hasPrevVertex);
 			b2Log("    shape.m_hasNextVertex = bool(%d);\n", s->m_hasNextVertex);
+			if (s->HasTree())
+			{
+				b2Log("    shape.BuildTree();\n");
+			}
+		}
+		break;
+
+	case b2Shape::e_compound:
+		{
+			b2CompoundShape* s = (b2CompoundShape*)m_shape;
+			b2Log("    b2CompoundShape shape;\n");
+			b2Log("    b2PolygonShape polygons[%d];\n", s->m_count);
+			for (int32 i = 0; i < s->m_count; ++i)
+			{
+				const b2PolygonShape* p = s->m_polygons + i;
+				b2Log("    {\n");
+				b2Log("      b2Vec2 vs[%d];\n", b2_maxPolygonVertices);
+				for (int32 j = 0; j < p->m_count; ++j)
+				{
+					b2Log("      vs[%d].Set(%.15lef, %.15lef);\n", j, p->m_vertices[j].x, p->m_vertices[j].y);
+				}
+				b2Log("      polygons[%d].Set(vs, %d);\n", i, p->m_count);
+				b2Log("    }\n");
+			}
+			b2Log("    shape.Create(polygons, %d);\n", s->m_count);
+		}
+		break;
+
+	case b2Shape::e_capsule:
+		{
+			b2CapsuleShape* s = (b2CapsuleShape*)m_shape;
+			b2Log("    b2CapsuleShape shape;\n");
+			b2Log("    shape.Set(b2Vec2(%.15lef, %.15lef), b2Vec2(%.15lef, %.15lef), %.15lef);\n",
+				s->m_vertex1.x, s->m_vertex1.y, s->m_vertex2.x, s->m_vertex2.y, s->m_radius);
 		}
 		break;
 
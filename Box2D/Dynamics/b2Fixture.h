@@ -36,6 +36,7 @@ struct b2Filter
 		categoryBits = 0x0001;
 		maskBits = 0xFFFF;
 		groupIndex = 0;
+		layer = 0;
 	}
 
 	/// The collision category bits. Normally you would just set one bit.
@@ -49,6 +50,11 @@ struct b2Filter
 	/// or always collide (positive). Zero means no collision group. Non-zero group
 	/// filtering always wins against the mask bits.
 	int16 groupIndex;
+
+	/// The collision layer in [0, b2_maxCollisionLayers). Layer pairs disabled in the
+	/// world layer matrix never create contacts. Non-zero group filtering always wins
+	/// against the layer matrix. @see b2World::SetLayerCollision
+	uint8 layer;
 };
 
 /// A fixture definition is used to create a fixture. This class defines an
@@ -213,7 +219,8 @@ protected:
 	void CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf);
 	void DestroyProxies(b2BroadPhase* broadPhase);
 
-	void Synchronize(b2BroadPhase* broadPhase, const b2Transform& xf1, const b2Transform& xf2);
+	// The prediction extends the proxies by the translation expected over the next step.
+	void Synchronize(b2BroadPhase* broadPhase, const b2Transform& xf1, const b2Transform& xf2, const b2Vec2& prediction);
 
 	float32 m_density;
 
@@ -232,6 +239,9 @@ protected:
 
 	bool m_isSensor;
 
+	// Unique within the world and never reused. The impulse cache keys on it.
+	uint32 m_id;
+
 	void* m_userData;
 };
 
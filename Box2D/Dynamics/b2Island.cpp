@@ -27,6 +27,9 @@
 #include <Box2D/Common/b2StackAllocator.h>
 #include <Box2D/Common/b2Timer.h>
 
+#include <memory.h>
+#include <algorithm>
+
 /*
 Position Correction Notes
 =========================
@@ -168,11 +171,13 @@ b2Island::b2Island(
 
 	m_velocities = (b2Velocity*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Velocity));
 	m_positions = (b2Position*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Position));
+	m_levels = (int32*)m_allocator->Allocate(m_bodyCapacity * sizeof(int32));
 }
 
 b2Island::~b2Island()
 {
 	// Warning: the order should reverse the constructor order.
+	m_allocator->Free(m_levels);
 	m_allocator->Free(m_positions);
 	m_allocator->Free(m_velocities);
 	m_allocator->Free(m_joints);
@@ -182,6 +187,19 @@ b2Island::~b2Island()
 
 void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep)
 {
+	SortJoints();
+
+	if (step.contactOrdering || step.shockPropagation)
+	{
+		OrderContacts(gravity);
+	}
+
+	if (step.softStepCount > 0)
+	{
+		SolveSoftStep(profile, step, gravity, allowSleep);
+		return;
+	}
+
 	b2Timer timer;
 
 	float32 h = step.dt;
@@ -190,21 +208,22 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* b = m_bodies[i];
+		b2Sweep& sweep = b->Sweep();
 
-		b2Vec2 c = b->m_sweep.c;
-		float32 a = b->m_sweep.a;
-		b2Vec2 v = b->m_linearVelocity;
-		float32 w = b->m_angularVelocity;
+		b2Vec2 c = sweep.c;
+		float32 a = sweep.a;
+		b2Vec2 v = b->LinearVelocity();
+		float32 w = b->AngularVelocity();
 
 		// Store positions for continuous collision.
-		b->m_sweep.c0 = b->m_sweep.c;
-		b->m_sweep.a0 = b->m_sweep.a;
+		sweep.c0 = sweep.c;
+		sweep.a0 = sweep.a;
 
 		if (b->m_type == b2_dynamicBody)
 		{
 			// Integrate velocities.
-			v += h * (b->m_gravityScale * gravity + b->m_invMass * b->m_force);
-			w += h * b->m_invI * b->m_torque;
+			v += h * (b->m_gravityScale * gravity + b->m_invMass * b->Force());
+			w += h * b->m_invI * b->Torque();
 
 			// Apply damping.
 			// ODE: dv/dt + c * v = 0
@@ -248,27 +267,35 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 		contactSolver.WarmStart();
 	}
 	
-	for (int32 i = 0; i < m_jointCount; ++i)
-	{
-		m_joints[i]->InitVelocityConstraints(solverData);
-	}
+	InitJointVelocities(solverData);
 
 	profile->solveInit = timer.GetMilliseconds();
 
-	// Solve velocity constraints
+	// Solve velocity constraints. Stop once a pass no longer changes the
+	// velocities noticeably. Joints and contacts are measured by the linear and
+	// angular velocity change of their bodies.
 	timer.Reset();
-	for (int32 i = 0; i < step.velocityIterations; ++i)
+	float32 linearTolerance = b2_linearResidual * step.inv_dt;
+	float32 angularTolerance = b2_angularResidual * step.inv_dt;
+	int32 velocityIterations = 0;
+	while (velocityIterations < step.velocityIterations)
 	{
-		for (int32 j = 0; j < m_jointCount; ++j)
+		float32 linearResidual = 0.0f;
+		float32 angularResidual = 0.0f;
+		SolveJointVelocities(solverData, &linearResidual, &angularResidual);
+		contactSolver.SolveVelocityConstraints(&linearResidual, &angularResidual);
+		++velocityIterations;
+
+		if (velocityIterations >= b2_minVelocityIterations &&
+			linearResidual < linearTolerance && angularResidual < angularTolerance)
 		{
-			m_joints[j]->SolveVelocityConstraints(solverData);
+			break;
 		}
-
-		contactSolver.SolveVelocityConstraints();
 	}
 
 	// Store impulses for warm starting
 	contactSolver.StoreImpulses();
+
 	profile->solveVelocity = timer.GetMilliseconds();
 
 	// Integrate positions
@@ -307,18 +334,15 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	// Solve position constraints
 	timer.Reset();
 	bool positionSolved = false;
-	for (int32 i = 0; i < step.positionIterations; ++i)
+	int32 positionIterations = 0;
+	while (positionIterations < step.positionIterations)
 	{
 		bool contactsOkay = contactSolver.SolvePositionConstraints();
+		bool jointsOkay = SolveJointPositions(solverData);
 
-		bool jointsOkay = true;
-		for (int32 i = 0; i < m_jointCount; ++i)
-		{
-			bool jointOkay = m_joints[i]->SolvePositionConstraints(solverData);
-			jointsOkay = jointsOkay && jointOkay;
-		}
+		++positionIterations;
 
-		if (contactsOkay && jointsOkay)
+		if (contactsOkay && jointsOkay && positionIterations >= b2_minPositionIterations)
 		{
 			// Exit early if the position errors are small.
 			positionSolved = true;
@@ -326,59 +350,450 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 		}
 	}
 
+	if (step.shockPropagation)
+	{
+		// A final pass carries the corrections up from the supports.
+		contactSolver.SolveShockPositionConstraints(m_levels);
+	}
+
 	// Copy state buffers back to the bodies
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* body = m_bodies[i];
-		body->m_sweep.c = m_positions[i].c;
-		body->m_sweep.a = m_positions[i].a;
-		body->m_linearVelocity = m_velocities[i].v;
-		body->m_angularVelocity = m_velocities[i].w;
+		b2Sweep& sweep = body->Sweep();
+		sweep.c = m_positions[i].c;
+		sweep.a = m_positions[i].a;
+		body->LinearVelocity() = m_velocities[i].v;
+		body->AngularVelocity() = m_velocities[i].w;
 		body->SynchronizeTransform();
 	}
 
 	profile->solvePosition = timer.GetMilliseconds();
+	profile->velocityIterations = velocityIterations;
+	profile->positionIterations = positionIterations;
 
-	Report(contactSolver.m_velocityConstraints);
+	Report(contactSolver.m_velocityConstraints, contactSolver.m_count);
 
 	if (allowSleep)
 	{
-		float32 minSleepTime = b2_maxFloat;
+		UpdateSleep(h, positionSolved);
+	}
+}
+
+void b2Island::SolveSoftStep(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep)
+{
+	b2Timer timer;
+
+	int32 substepCount = step.softStepCount;
+	float32 h = step.dt / substepCount;
+
+	// Initialize the body state.
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		b2Body* b = m_bodies[i];
+		b2Sweep& sweep = b->Sweep();
+
+		// Store positions for continuous collision.
+		sweep.c0 = sweep.c;
+		sweep.a0 = sweep.a;
 
-		const float32 linTolSqr = b2_linearSleepTolerance * b2_linearSleepTolerance;
-		const float32 angTolSqr = b2_angularSleepTolerance * b2_angularSleepTolerance;
+		m_positions[i].c = sweep.c;
+		m_positions[i].a = sweep.a;
+		m_velocities[i].v = b->LinearVelocity();
+		m_velocities[i].w = b->AngularVelocity();
+	}
 
+	// Joints see the substep as their time step.
+	b2SolverData solverData;
+	solverData.step = step;
+	solverData.step.dt = h;
+	solverData.step.inv_dt = 1.0f / h;
+	solverData.positions = m_positions;
+	solverData.velocities = m_velocities;
+
+	b2ContactSolverDef contactSolverDef;
+	contactSolverDef.step = solverData.step;
+	contactSolverDef.contacts = m_contacts;
+	contactSolverDef.count = m_contactCount;
+	contactSolverDef.positions = m_positions;
+	contactSolverDef.velocities = m_velocities;
+	contactSolverDef.allocator = m_allocator;
+
+	b2ContactSolver contactSolver(&contactSolverDef);
+	contactSolver.InitializeVelocityConstraints();
+	contactSolver.PrepareSoftConstraints(h);
+
+	profile->solveInit = timer.GetMilliseconds();
+
+	// The soft step does not stop early, the residuals are not used.
+	float32 linearResidual = 0.0f;
+	float32 angularResidual = 0.0f;
+
+	// Each substep integrates velocities, solves every constraint once with soft
+	// bias, integrates positions, corrects the joint positions once and then relaxes
+	// the constraints without bias. The accumulated impulses carry over from one
+	// substep to the next.
+	timer.Reset();
+	for (int32 substep = 0; substep < substepCount; ++substep)
+	{
 		for (int32 i = 0; i < m_bodyCount; ++i)
 		{
 			b2Body* b = m_bodies[i];
-			if (b->GetType() == b2_staticBody)
+			if (b->m_type != b2_dynamicBody)
 			{
 				continue;
 			}
 
-			if ((b->m_flags & b2Body::e_autoSleepFlag) == 0 ||
-				b->m_angularVelocity * b->m_angularVelocity > angTolSqr ||
-				b2Dot(b->m_linearVelocity, b->m_linearVelocity) > linTolSqr)
+			b2Vec2 v = m_velocities[i].v;
+			float32 w = m_velocities[i].w;
+
+			v += h * (b->m_gravityScale * gravity + b->m_invMass * b->Force());
+			w += h * b->m_invI * b->Torque();
+
+			v *= 1.0f / (1.0f + h * b->m_linearDamping);
+			w *= 1.0f / (1.0f + h * b->m_angularDamping);
+
+			m_velocities[i].v = v;
+			m_velocities[i].w = w;
+		}
+
+		// The step's impulses are only scaled on the first substep.
+		if (substep > 0)
+		{
+			solverData.step.dtRatio = 1.0f;
+			solverData.step.warmStarting = true;
+		}
+
+		InitJointVelocities(solverData);
+
+		if (solverData.step.warmStarting)
+		{
+			contactSolver.WarmStart();
+		}
+
+		SolveJointVelocities(solverData, &linearResidual, &angularResidual);
+		contactSolver.SolveSoftVelocityConstraints(true);
+
+		// Integrate positions. The velocity limits are those of the full step.
+		for (int32 i = 0; i < m_bodyCount; ++i)
+		{
+			b2Vec2 v = m_velocities[i].v;
+			float32 w = m_velocities[i].w;
+
+			b2Vec2 translation = step.dt * v;
+			if (b2Dot(translation, translation) > b2_maxTranslationSquared)
 			{
-				b->m_sleepTime = 0.0f;
-				minSleepTime = 0.0f;
+				float32 ratio = b2_maxTranslation / translation.Length();
+				v *= ratio;
 			}
-			else
+
+			float32 rotation = step.dt * w;
+			if (rotation * rotation > b2_maxRotationSquared)
 			{
-				b->m_sleepTime += h;
-				minSleepTime = b2Min(minSleepTime, b->m_sleepTime);
+				float32 ratio = b2_maxRotation / b2Abs(rotation);
+				w *= ratio;
 			}
+
+			m_positions[i].c += h * v;
+			m_positions[i].a += h * w;
+			m_velocities[i].v = v;
+			m_velocities[i].w = w;
 		}
 
-		if (minSleepTime >= b2_timeToSleep && positionSolved)
+		SolveJointPositions(solverData);
+
+		SolveJointVelocities(solverData, &linearResidual, &angularResidual);
+		contactSolver.SolveSoftVelocityConstraints(false);
+	}
+
+	contactSolver.ApplyRestitution();
+	contactSolver.StoreImpulses();
+	profile->solveVelocity = timer.GetMilliseconds();
+
+	// Contacts correct their own overlap. Joints still get position iterations.
+	timer.Reset();
+	bool positionSolved = false;
+	int32 positionIterations = 0;
+	while (positionIterations < step.positionIterations)
+	{
+		bool jointsOkay = SolveJointPositions(solverData);
+		++positionIterations;
+
+		if (jointsOkay && positionIterations >= b2_minPositionIterations)
 		{
-			for (int32 i = 0; i < m_bodyCount; ++i)
+			positionSolved = true;
+			break;
+		}
+	}
+
+	// Copy state buffers back to the bodies
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		b2Body* body = m_bodies[i];
+		b2Sweep& sweep = body->Sweep();
+		sweep.c = m_positions[i].c;
+		sweep.a = m_positions[i].a;
+		body->LinearVelocity() = m_velocities[i].v;
+		body->AngularVelocity() = m_velocities[i].w;
+		body->SynchronizeTransform();
+	}
+
+	profile->solvePosition = timer.GetMilliseconds();
+	profile->velocityIterations = substepCount;
+	profile->positionIterations = positionIterations;
+
+	Report(contactSolver.m_velocityConstraints, contactSolver.m_count);
+
+	if (allowSleep)
+	{
+		UpdateSleep(step.dt, positionSolved);
+	}
+}
+
+void b2Island::UpdateSleep(float32 h, bool positionSolved)
+{
+	float32 minSleepTime = b2_maxFloat;
+
+	const float32 linTolSqr = b2_linearSleepTolerance * b2_linearSleepTolerance;
+	const float32 angTolSqr = b2_angularSleepTolerance * b2_angularSleepTolerance;
+
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		b2Body* b = m_bodies[i];
+		if (b->GetType() == b2_staticBody)
+		{
+			continue;
+		}
+
+		if ((b->m_flags & b2Body::e_autoSleepFlag) == 0 ||
+			b->AngularVelocity() * b->AngularVelocity() > angTolSqr ||
+			b2Dot(b->LinearVelocity(), b->LinearVelocity()) > linTolSqr)
+		{
+			b->m_sleepTime = 0.0f;
+			minSleepTime = 0.0f;
+		}
+		else
+		{
+			b->m_sleepTime += h;
+			minSleepTime = b2Min(minSleepTime, b->m_sleepTime);
+		}
+	}
+
+	if (minSleepTime >= b2_timeToSleep && positionSolved)
+	{
+		for (int32 i = 0; i < m_bodyCount; ++i)
+		{
+			b2Body* b = m_bodies[i];
+			b->SetAwake(false);
+		}
+	}
+}
+
+void b2Island::SortJoints()
+{
+	// Counting sort by joint type.
+	const int32 typeCount = e_motorJoint + 1;
+	int32 starts[typeCount + 1] = { 0 };
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		b2Assert(0 <= m_joints[i]->m_type && m_joints[i]->m_type < typeCount);
+		++starts[m_joints[i]->m_type + 1];
+	}
+
+	if (m_jointCount == 0 || starts[m_joints[0]->m_type + 1] == m_jointCount)
+	{
+		// Already a single run.
+		return;
+	}
+
+	for (int32 i = 0; i < typeCount; ++i)
+	{
+		starts[i + 1] += starts[i];
+	}
+
+	b2Joint** sorted = (b2Joint**)m_allocator->Allocate(m_jointCount * sizeof(b2Joint*));
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		sorted[starts[m_joints[i]->m_type]++] = m_joints[i];
+	}
+
+	memcpy(m_joints, sorted, m_jointCount * sizeof(b2Joint*));
+	m_allocator->Free(sorted);
+}
+
+struct b2ContactOrder
+{
+	int32 level;
+	float32 height;
+	int32 index;
+};
+
+static bool b2ContactOrderLess(const b2ContactOrder& a, const b2ContactOrder& b)
+{
+	if (a.level != b.level)
+	{
+		return a.level < b.level;
+	}
+
+	if (a.height != b.height)
+	{
+		return a.height < b.height;
+	}
+
+	return a.index < b.index;
+}
+
+void b2Island::OrderContacts(const b2Vec2& gravity)
+{
+	// Bodies without a contact path to a support stay above every reached level.
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		m_levels[i] = m_bodies[i]->m_type == b2_dynamicBody ? m_bodyCount : 0;
+	}
+
+	if (m_contactCount == 0)
+	{
+		return;
+	}
+
+	// Build the contact graph of the island.
+	int32* offsets = (int32*)m_allocator->Allocate((m_bodyCount + 1) * sizeof(int32));
+	int32* adjacency = (int32*)m_allocator->Allocate(2 * m_contactCount * sizeof(int32));
+	int32* queue = (int32*)m_allocator->Allocate(m_bodyCount * sizeof(int32));
+
+	memset(offsets, 0, (m_bodyCount + 1) * sizeof(int32));
+	for (int32 i = 0; i < m_contactCount; ++i)
+	{
+		++offsets[m_contacts[i]->GetFixtureA()->GetBody()->m_islandIndex + 1];
+		++offsets[m_contacts[i]->GetFixtureB()->GetBody()->m_islandIndex + 1];
+	}
+
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		offsets[i + 1] += offsets[i];
+	}
+
+	for (int32 i = 0; i < m_contactCount; ++i)
+	{
+		int32 indexA = m_contacts[i]->GetFixtureA()->GetBody()->m_islandIndex;
+		int32 indexB = m_contacts[i]->GetFixtureB()->GetBody()->m_islandIndex;
+		adjacency[offsets[indexA]++] = indexB;
+		adjacency[offsets[indexB]++] = indexA;
+	}
+
+	// The fill advanced each offset to the start of the next body.
+	for (int32 i = m_bodyCount; i > 0; --i)
+	{
+		offsets[i] = offsets[i - 1];
+	}
+	offsets[0] = 0;
+
+	// Breadth-first search from the supports.
+	int32 queueCount = 0;
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		if (m_levels[i] == 0)
+		{
+			queue[queueCount++] = i;
+		}
+	}
+
+	for (int32 head = 0; head < queueCount; ++head)
+	{
+		int32 index = queue[head];
+		for (int32 i = offsets[index]; i < offsets[index + 1]; ++i)
+		{
+			int32 other = adjacency[i];
+			if (m_levels[other] == m_bodyCount)
 			{
-				b2Body* b = m_bodies[i];
-				b->SetAwake(false);
+				m_levels[other] = m_levels[index] + 1;
+				queue[queueCount++] = other;
 			}
 		}
 	}
+
+	// Sort by the lower level of the two bodies, then by the height of the lower
+	// body along gravity.
+	b2ContactOrder* order = (b2ContactOrder*)m_allocator->Allocate(m_contactCount * sizeof(b2ContactOrder));
+	for (int32 i = 0; i < m_contactCount; ++i)
+	{
+		b2Body* bodyA = m_contacts[i]->GetFixtureA()->GetBody();
+		b2Body* bodyB = m_contacts[i]->GetFixtureB()->GetBody();
+		float32 heightA = -b2Dot(gravity, bodyA->Sweep().c);
+		float32 heightB = -b2Dot(gravity, bodyB->Sweep().c);
+
+		order[i].level = b2Min(m_levels[bodyA->m_islandIndex], m_levels[bodyB->m_islandIndex]);
+		order[i].height = b2Min(heightA, heightB);
+		order[i].index = i;
+	}
+
+	std::sort(order, order + m_contactCount, b2ContactOrderLess);
+
+	b2Contact** sorted = (b2Contact**)m_allocator->Allocate(m_contactCount * sizeof(b2Contact*));
+	for (int32 i = 0; i < m_contactCount; ++i)
+	{
+		sorted[i] = m_contacts[order[i].index];
+	}
+
+	memcpy(m_contacts, sorted, m_contactCount * sizeof(b2Contact*));
+
+	m_allocator->Free(sorted);
+	m_allocator->Free(order);
+	m_allocator->Free(queue);
+	m_allocator->Free(adjacency);
+	m_allocator->Free(offsets);
+}
+
+void b2Island::InitJointVelocities(const b2SolverData& data)
+{
+	int32 i = 0;
+	while (i < m_jointCount)
+	{
+		int32 j = i + 1;
+		while (j < m_jointCount && m_joints[j]->m_type == m_joints[i]->m_type)
+		{
+			++j;
+		}
+
+		b2Joint::InitVelocityRun(m_joints + i, j - i, data);
+		i = j;
+	}
+}
+
+void b2Island::SolveJointVelocities(const b2SolverData& data, float32* linearResidual, float32* angularResidual)
+{
+	int32 i = 0;
+	while (i < m_jointCount)
+	{
+		int32 j = i + 1;
+		while (j < m_jointCount && m_joints[j]->m_type == m_joints[i]->m_type)
+		{
+			++j;
+		}
+
+		b2Joint::SolveVelocityRun(m_joints + i, j - i, data, linearResidual, angularResidual);
+		i = j;
+	}
+}
+
+bool b2Island::SolveJointPositions(const b2SolverData& data)
+{
+	bool jointsOkay = true;
+	int32 i = 0;
+	while (i < m_jointCount)
+	{
+		int32 j = i + 1;
+		while (j < m_jointCount && m_joints[j]->m_type == m_joints[i]->m_type)
+		{
+			++j;
+		}
+
+		bool runOkay = b2Joint::SolvePositionRun(m_joints + i, j - i, data);
+		jointsOkay = jointsOkay && runOkay;
+		i = j;
+	}
+
+	return jointsOkay;
 }
 
 void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB)
@@ -390,10 +805,10 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* b = m_bodies[i];
-		m_positions[i].c = b->m_sweep.c;
-		m_positions[i].a = b->m_sweep.a;
-		m_velocities[i].v = b->m_linearVelocity;
-		m_velocities[i].w = b->m_angularVelocity;
+		m_positions[i].c = b->Sweep().c;
+		m_positions[i].a = b->Sweep().a;
+		m_velocities[i].v = b->LinearVelocity();
+		m_velocities[i].w = b->AngularVelocity();
 	}
 
 	b2ContactSolverDef contactSolverDef;
@@ -449,19 +864,22 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 #endif
 
 	// Leap of faith to new safe state.
-	m_bodies[toiIndexA]->m_sweep.c0 = m_positions[toiIndexA].c;
-	m_bodies[toiIndexA]->m_sweep.a0 = m_positions[toiIndexA].a;
-	m_bodies[toiIndexB]->m_sweep.c0 = m_positions[toiIndexB].c;
-	m_bodies[toiIndexB]->m_sweep.a0 = m_positions[toiIndexB].a;
+	m_bodies[toiIndexA]->Sweep().c0 = m_positions[toiIndexA].c;
+	m_bodies[toiIndexA]->Sweep().a0 = m_positions[toiIndexA].a;
+	m_bodies[toiIndexB]->Sweep().c0 = m_positions[toiIndexB].c;
+	m_bodies[toiIndexB]->Sweep().a0 = m_positions[toiIndexB].a;
 
 	// No warm starting is needed for TOI events because warm
 	// starting impulses were applied in the discrete solver.
 	contactSolver.InitializeVelocityConstraints();
 
-	// Solve velocity constraints.
+	// Solve velocity constraints. The TOI solve does not stop early, the residuals
+	// are not used.
+	float32 linearResidual = 0.0f;
+	float32 angularResidual = 0.0f;
 	for (int32 i = 0; i < subStep.velocityIterations; ++i)
 	{
-		contactSolver.SolveVelocityConstraints();
+		contactSolver.SolveVelocityConstraints(&linearResidual, &angularResidual);
 	}
 
 	// Don't store the TOI contact forces for warm starting
@@ -503,28 +921,30 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 
 		// Sync bodies
 		b2Body* body = m_bodies[i];
-		body->m_sweep.c = c;
-		body->m_sweep.a = a;
-		body->m_linearVelocity = v;
-		body->m_angularVelocity = w;
+		b2Sweep& sweep = body->Sweep();
+		sweep.c = c;
+		sweep.a = a;
+		body->LinearVelocity() = v;
+		body->AngularVelocity() = w;
 		body->SynchronizeTransform();
 	}
 
-	Report(contactSolver.m_velocityConstraints);
+	Report(contactSolver.m_velocityConstraints, contactSolver.m_count);
 }
 
-void b2Island::Report(const b2ContactVelocityConstraint* constraints)
+void b2Island::Report(const b2ContactVelocityConstraint* constraints, int32 count)
 {
 	if (m_listener == NULL)
 	{
 		return;
 	}
 
-	for (int32 i = 0; i < m_contactCount; ++i)
+	// There is one constraint per contact manifold.
+	for (int32 i = 0; i < count; ++i)
 	{
-		b2Contact* c = m_contacts[i];
-
 		const b2ContactVelocityConstraint* vc = constraints + i;
+
+		b2Contact* c = m_contacts[vc->contactIndex];
 		
 		b2ContactImpulse impulse;
 		impulse.count = vc->pointCount;
@@ -69,7 +69,25 @@ public:
 		m_joints[m_jointCount++] = joint;
 	}
 
-	void Report(const b2ContactVelocityConstraint* constraints);
+	void Report(const b2ContactVelocityConstraint* constraints, int32 count);
+
+	// Sort the joints by type, keeping their order within a type. Each run of one
+	// type is then solved through b2Joint's run kernels.
+	void SortJoints();
+
+	// Sort the contacts bottom-up, starting from the contacts with static and
+	// kinematic bodies. Fills m_levels with each body's contact distance from
+	// such a support.
+	void OrderContacts(const b2Vec2& gravity);
+	void InitJointVelocities(const b2SolverData& data);
+	void SolveJointVelocities(const b2SolverData& data, float32* linearResidual, float32* angularResidual);
+	bool SolveJointPositions(const b2SolverData& data);
+
+	// Substepping solver with soft contacts, see b2World::SetSoftStepCount.
+	void SolveSoftStep(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep);
+
+	// Advance the sleep timers and put the island to sleep once every body has rested.
+	void UpdateSleep(float32 h, bool positionSolved);
 
 	b2StackAllocator* m_allocator;
 	b2ContactListener* m_listener;
@@ -80,6 +98,7 @@ public:
 
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
+	int32* m_levels;
 
 	int32 m_bodyCount;
 	int32 m_jointCount;
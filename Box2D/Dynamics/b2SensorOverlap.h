@@ -0,0 +1,161 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SENSOR_OVERLAP_H
+#define B2_SENSOR_OVERLAP_H
+
+#include <Box2D/Collision/b2Distance.h>
+
+class b2Body;
+class b2Fixture;
+class b2SensorOverlap;
+
+/// A sensor edge is used to connect bodies and sensor overlaps together.
+/// A sensor edge belongs to a doubly linked list maintained in each
+/// attached body. Each sensor overlap has two sensor nodes, one for each
+/// attached body.
+struct b2SensorEdge
+{
+	b2Body* other;				///< provides quick access to the other body attached.
+	b2SensorOverlap* overlap;	///< the sensor overlap
+	b2SensorEdge* prev;			///< the previous sensor edge in the body's sensor list
+	b2SensorEdge* next;			///< the next sensor edge in the body's sensor list
+};
+
+/// A sensor overlap exists for each overlapping AABB in the broad-phase where at
+/// least one fixture is a sensor (except if filtered). Unlike b2Contact it has no
+/// manifold and never reaches the solver. Sensor overlaps are updated once per time
+/// step, after the solver, against the final body transforms.
+class b2SensorOverlap
+{
+public:
+
+	/// Are the fixtures touching?
+	bool IsTouching() const;
+
+	/// Get the next sensor overlap in the world's sensor overlap list.
+	b2SensorOverlap* GetNext();
+	const b2SensorOverlap* GetNext() const;
+
+	/// Get fixture A. At least one of the two fixtures is a sensor.
+	b2Fixture* GetFixtureA();
+	const b2Fixture* GetFixtureA() const;
+
+	/// Get the child primitive index for fixture A.
+	int32 GetChildIndexA() const;
+
+	/// Get fixture B.
+	b2Fixture* GetFixtureB();
+	const b2Fixture* GetFixtureB() const;
+
+	/// Get the child primitive index for fixture B.
+	int32 GetChildIndexB() const;
+
+protected:
+	friend class b2ContactManager;
+	friend class b2World;
+	friend class b2Body;
+	friend class b2Fixture;
+
+	// Flags stored in m_flags
+	enum
+	{
+		// Set when the shapes are touching.
+		e_touchingFlag		= 0x0001,
+
+		// This overlap needs filtering because a fixture filter was changed.
+		e_filterFlag		= 0x0002,
+
+		// The shapes touch at the end of this step. Set by the overlap pass.
+		e_overlapFlag		= 0x0004
+	};
+
+	/// Flag this overlap for filtering. Filtering will occur the next time step.
+	void FlagForFiltering();
+
+	uint32 m_flags;
+
+	// World list pointers.
+	b2SensorOverlap* m_prev;
+	b2SensorOverlap* m_next;
+
+	// Nodes for connecting bodies.
+	b2SensorEdge m_nodeA;
+	b2SensorEdge m_nodeB;
+
+	b2Fixture* m_fixtureA;
+	b2Fixture* m_fixtureB;
+
+	int32 m_indexA;
+	int32 m_indexB;
+
+	// Warm starts the GJK overlap test.
+	b2SimplexCache m_simplexCache;
+};
+
+inline bool b2SensorOverlap::IsTouching() const
+{
+	return (m_flags & e_touchingFlag) == e_touchingFlag;
+}
+
+inline b2SensorOverlap* b2SensorOverlap::GetNext()
+{
+	return m_next;
+}
+
+inline const b2SensorOverlap* b2SensorOverlap::GetNext() const
+{
+	return m_next;
+}
+
+inline b2Fixture* b2SensorOverlap::GetFixtureA()
+{
+	return m_fixtureA;
+}
+
+inline const b2Fixture* b2SensorOverlap::GetFixtureA() const
+{
+	return m_fixtureA;
+}
+
+inline int32 b2SensorOverlap::GetChildIndexA() const
+{
+	return m_indexA;
+}
+
+inline b2Fixture* b2SensorOverlap::GetFixtureB()
+{
+	return m_fixtureB;
+}
+
+inline const b2Fixture* b2SensorOverlap::GetFixtureB() const
+{
+	return m_fixtureB;
+}
+
+inline int32 b2SensorOverlap::GetChildIndexB() const
+{
+	return m_indexB;
+}
+
+inline void b2SensorOverlap::FlagForFiltering()
+{
+	m_flags |= e_filterFlag;
+}
+
+#endif
@@ -32,6 +32,16 @@ struct b2Profile
 	float32 solvePosition;
 	float32 broadphase;
 	float32 solveTOI;
+	float32 sensors;
+	int32 gjkCalls;		///< GJK distance queries in the step
+	int32 gjkIters;		///< GJK iterations in the step
+	int32 islandCount;			///< islands solved in the step
+	int32 velocityIterations;	///< velocity iterations used, summed over the islands
+	int32 positionIterations;	///< position iterations used, summed over the islands
+	int32 maxVelocityIterations;	///< most velocity iterations used by one island
+	int32 maxPositionIterations;	///< most position iterations used by one island
+	int32 stackPeak;			///< most stack allocator bytes in use at once in the step
+	int32 stackFallbacks;		///< stack allocations in the step that did not fit the stack
 };
 
 /// This is an internal structure.
@@ -43,6 +53,10 @@ struct b2TimeStep
 	int32 velocityIterations;
 	int32 positionIterations;
 	bool warmStarting;
+	bool speculative;	// contacts may carry points that are not yet touching
+	int32 softStepCount;	// substeps of the soft step solver (0 for the iterative solver)
+	bool contactOrdering;	// solve contacts bottom-up from the static supports
+	bool shockPropagation;	// treat supporting bodies as immovable in the final passes
 };
 
 /// This is an internal structure.
@@ -20,21 +20,28 @@
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2Island.h>
+#include <Box2D/Dynamics/b2SensorOverlap.h>
 #include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
 #include <Box2D/Collision/b2Collision.h>
+#include <Box2D/Collision/b2Distance.h>
 #include <Box2D/Collision/b2BroadPhase.h>
+#include <Box2D/Collision/Shapes/b2CapsuleShape.h>
 #include <Box2D/Collision/Shapes/b2CircleShape.h>
 #include <Box2D/Collision/Shapes/b2EdgeShape.h>
 #include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2CompoundShape.h>
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
 #include <Box2D/Common/b2Draw.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <Box2D/Common/b2Timer.h>
 #include <new>
 
-b2World::b2World(const b2Vec2& gravity)
+b2World::b2World(const b2Vec2& gravity, b2AllocatorInterface* allocator)
+	: m_blockAllocator(allocator), m_stackAllocator(allocator), m_contactManager(allocator),
+	m_bodyStorage(allocator)
 {
 	m_destructionListener = NULL;
 	m_debugDraw = NULL;
@@ -44,10 +51,16 @@ b2World::b2World(const b2Vec2& gravity)
 
 	m_bodyCount = 0;
 	m_jointCount = 0;
+	m_fixtureIdCount = 0;
+	m_jointIdCount = 0;
 
 	m_warmStarting = true;
 	m_continuousPhysics = true;
 	m_subStepping = false;
+	m_speculativeContacts = false;
+	m_softStepCount = 0;
+	m_contactOrdering = false;
+	m_shockPropagation = false;
 
 	m_stepComplete = true;
 
@@ -65,6 +78,9 @@ b2World::b2World(const b2Vec2& gravity)
 
 b2World::~b2World()
 {
+	// Some contacts keep manifolds outside the block allocator.
+	m_contactManager.Clear();
+
 	// Some shapes allocate using b2Alloc.
 	b2Body* b = m_bodyList;
 	while (b)
@@ -94,6 +110,42 @@ void b2World::SetContactFilter(b2ContactFilter* filter)
 	m_contactManager.m_contactFilter = filter;
 }
 
+void b2World::SetLayerCollision(int32 layerA, int32 layerB, bool flag)
+{
+	b2Assert(0 <= layerA && layerA < b2_maxCollisionLayers);
+	b2Assert(0 <= layerB && layerB < b2_maxCollisionLayers);
+
+	if (GetLayerCollision(layerA, layerB) == flag)
+	{
+		return;
+	}
+
+	uint32* matrix = m_contactManager.m_layerMatrix;
+	if (flag)
+	{
+		matrix[layerA] |= (1u << layerB);
+		matrix[layerB] |= (1u << layerA);
+	}
+	else
+	{
+		matrix[layerA] &= ~(1u << layerB);
+		matrix[layerB] &= ~(1u << layerA);
+	}
+
+	// Refilter the fixtures in both layers. This flags their contacts for filtering
+	// and touches their proxies so that newly enabled pairs may be created.
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			if (f->m_filter.layer == layerA || f->m_filter.layer == layerB)
+			{
+				f->Refilter();
+			}
+		}
+	}
+}
+
 void b2World::SetContactListener(b2ContactListener* listener)
 {
 	m_contactManager.m_contactListener = listener;
@@ -165,6 +217,16 @@ void b2World::DestroyBody(b2Body* b)
 	}
 	b->m_contactList = NULL;
 
+	// Delete the attached sensor overlaps.
+	b2SensorEdge* se = b->m_sensorList;
+	while (se)
+	{
+		b2SensorEdge* se0 = se;
+		se = se->next;
+		m_contactManager.DestroySensor(se0->overlap);
+	}
+	b->m_sensorList = NULL;
+
 	// Delete the attached fixtures. This destroys broad-phase proxies.
 	b2Fixture* f = b->m_fixtureList;
 	while (f)
@@ -209,6 +271,303 @@ void b2World::DestroyBody(b2Body* b)
 	m_blockAllocator.Free(b, sizeof(b2Body));
 }
 
+void b2World::CreateBodies(const b2BodyDef* defs, int32 count, b2Body** bodies)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_bodyStorage.Reserve(count);
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		void* mem = m_blockAllocator.Allocate(sizeof(b2Body));
+		b2Body* b = new (mem) b2Body(defs + i, this);
+
+		// Add to world doubly linked list.
+		b->m_prev = NULL;
+		b->m_next = m_bodyList;
+		if (m_bodyList)
+		{
+			m_bodyList->m_prev = b;
+		}
+		m_bodyList = b;
+
+		bodies[i] = b;
+	}
+
+	m_bodyCount += count;
+}
+
+void b2World::CreateFixtures(b2Body* const* bodies, const b2FixtureDef* defs, int32 count, b2Fixture** fixtures)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	b2Fixture** created = (b2Fixture**)m_stackAllocator.Allocate(count * sizeof(b2Fixture*));
+
+	bool massChanged = false;
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* body = bodies[i];
+		b2Assert(body->m_world == this);
+
+		void* memory = m_blockAllocator.Allocate(sizeof(b2Fixture));
+		b2Fixture* fixture = new (memory) b2Fixture;
+		fixture->Create(&m_blockAllocator, body, defs + i);
+
+		fixture->m_next = body->m_fixtureList;
+		body->m_fixtureList = fixture;
+		++body->m_fixtureCount;
+
+		fixture->m_body = body;
+
+		created[i] = fixture;
+		if (fixtures)
+		{
+			fixtures[i] = fixture;
+		}
+
+		// Adjust mass properties at the end of the body's run of fixtures.
+		massChanged = massChanged || fixture->m_density > 0.0f;
+		if (i + 1 == count || bodies[i + 1] != body)
+		{
+			if (massChanged && (body->m_flags & b2Body::e_editFlag))
+			{
+				body->m_flags |= b2Body::e_massDirtyFlag;
+			}
+			else if (massChanged)
+			{
+				body->ResetMassData();
+			}
+			massChanged = false;
+		}
+	}
+
+	CreateProxies(created, count);
+	m_stackAllocator.Free(created);
+
+	// Let the world know we have new fixtures. This will cause new contacts
+	// to be created at the beginning of the next time step.
+	m_flags |= e_newFixture;
+}
+
+void b2World::CreateProxies(b2Fixture* const* fixtures, int32 count)
+{
+	int32 proxyCount = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Assert(fixtures[i]->m_proxyCount == 0);
+		if ((fixtures[i]->m_body->m_flags & (b2Body::e_activeFlag | b2Body::e_editFlag)) == b2Body::e_activeFlag)
+		{
+			proxyCount += fixtures[i]->m_shape->GetChildCount();
+		}
+	}
+
+	b2AABB* aabbs = (b2AABB*)m_stackAllocator.Allocate(proxyCount * sizeof(b2AABB));
+	void** userData = (void**)m_stackAllocator.Allocate(proxyCount * sizeof(void*));
+	int32* proxyIds = (int32*)m_stackAllocator.Allocate(proxyCount * sizeof(int32));
+
+	// Fill in the proxies, then add them to the broad-phase together.
+	int32 proxyIndex = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Fixture* fixture = fixtures[i];
+		b2Body* body = fixture->m_body;
+		if ((body->m_flags & (b2Body::e_activeFlag | b2Body::e_editFlag)) != b2Body::e_activeFlag)
+		{
+			continue;
+		}
+
+		fixture->m_proxyCount = fixture->m_shape->GetChildCount();
+		for (int32 j = 0; j < fixture->m_proxyCount; ++j)
+		{
+			b2FixtureProxy* proxy = fixture->m_proxies + j;
+			fixture->m_shape->ComputeAABB(&proxy->aabb, body->m_xf, j);
+			proxy->fixture = fixture;
+			proxy->childIndex = j;
+
+			aabbs[proxyIndex] = proxy->aabb;
+			userData[proxyIndex] = proxy;
+			++proxyIndex;
+		}
+	}
+
+	b2Assert(proxyIndex == proxyCount);
+	m_contactManager.m_broadPhase.CreateProxies(aabbs, userData, proxyCount, proxyIds);
+	for (int32 i = 0; i < proxyCount; ++i)
+	{
+		((b2FixtureProxy*)userData[i])->proxyId = proxyIds[i];
+	}
+
+	m_stackAllocator.Free(proxyIds);
+	m_stackAllocator.Free(userData);
+	m_stackAllocator.Free(aabbs);
+}
+
+void b2World::DestroyBodies(b2Body* const* bodies, int32 count)
+{
+	b2Assert(m_bodyCount >= count);
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	int32 proxyCount = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		for (b2Fixture* f = bodies[i]->m_fixtureList; f; f = f->m_next)
+		{
+			proxyCount += f->m_proxyCount;
+		}
+	}
+
+	int32* proxyIds = (int32*)m_stackAllocator.Allocate(proxyCount * sizeof(int32));
+	int32 proxyIndex = 0;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* b = bodies[i];
+
+		// Delete the attached joints.
+		b2JointEdge* je = b->m_jointList;
+		while (je)
+		{
+			b2JointEdge* je0 = je;
+			je = je->next;
+
+			if (m_destructionListener)
+			{
+				m_destructionListener->SayGoodbye(je0->joint);
+			}
+
+			DestroyJoint(je0->joint);
+
+			b->m_jointList = je;
+		}
+		b->m_jointList = NULL;
+
+		// Delete the attached contacts.
+		b2ContactEdge* ce = b->m_contactList;
+		while (ce)
+		{
+			b2ContactEdge* ce0 = ce;
+			ce = ce->next;
+			m_contactManager.Destroy(ce0->contact);
+		}
+		b->m_contactList = NULL;
+
+		// Delete the attached sensor overlaps.
+		b2SensorEdge* se = b->m_sensorList;
+		while (se)
+		{
+			b2SensorEdge* se0 = se;
+			se = se->next;
+			m_contactManager.DestroySensor(se0->overlap);
+		}
+		b->m_sensorList = NULL;
+
+		// Gather the broad-phase proxies.
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			for (int32 j = 0; j < f->m_proxyCount; ++j)
+			{
+				proxyIds[proxyIndex++] = f->m_proxies[j].proxyId;
+				f->m_proxies[j].proxyId = b2BroadPhase::e_nullProxy;
+			}
+			f->m_proxyCount = 0;
+		}
+	}
+
+	b2Assert(proxyIndex == proxyCount);
+	m_contactManager.m_broadPhase.DestroyProxies(proxyIds, proxyCount);
+	m_stackAllocator.Free(proxyIds);
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* b = bodies[i];
+
+		// Delete the attached fixtures.
+		b2Fixture* f = b->m_fixtureList;
+		while (f)
+		{
+			b2Fixture* f0 = f;
+			f = f->m_next;
+
+			if (m_destructionListener)
+			{
+				m_destructionListener->SayGoodbye(f0);
+			}
+
+			f0->Destroy(&m_blockAllocator);
+			f0->~b2Fixture();
+			m_blockAllocator.Free(f0, sizeof(b2Fixture));
+		}
+		b->m_fixtureList = NULL;
+		b->m_fixtureCount = 0;
+
+		// Remove world body list.
+		if (b->m_prev)
+		{
+			b->m_prev->m_next = b->m_next;
+		}
+
+		if (b->m_next)
+		{
+			b->m_next->m_prev = b->m_prev;
+		}
+
+		if (b == m_bodyList)
+		{
+			m_bodyList = b->m_next;
+		}
+
+		b->~b2Body();
+		m_blockAllocator.Free(b, sizeof(b2Body));
+	}
+
+	m_bodyCount -= count;
+}
+
+void b2World::Clear()
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_contactManager.Clear();
+
+	// Some shapes allocate using b2Alloc.
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			f->m_proxyCount = 0;
+			f->Destroy(&m_blockAllocator);
+		}
+	}
+
+	// Everything else lives in the block allocator.
+	m_blockAllocator.Clear();
+	m_bodyStorage.Clear();
+
+	m_bodyList = NULL;
+	m_jointList = NULL;
+	m_bodyCount = 0;
+	m_jointCount = 0;
+
+	m_flags &= ~e_newFixture;
+	m_stepComplete = true;
+}
+
 b2Joint* b2World::CreateJoint(const b2JointDef* def)
 {
 	b2Assert(IsLocked() == false);
@@ -218,6 +577,7 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 	}
 
 	b2Joint* j = b2Joint::Create(def, &m_blockAllocator);
+	j->m_id = m_jointIdCount++;
 
 	// Connect to the world list.
 	j->m_prev = NULL;
@@ -262,6 +622,17 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 
 			edge = edge->next;
 		}
+
+		b2SensorEdge* sensorEdge = bodyB->GetSensorList();
+		while (sensorEdge)
+		{
+			if (sensorEdge->other == bodyA)
+			{
+				sensorEdge->overlap->FlagForFiltering();
+			}
+
+			sensorEdge = sensorEdge->next;
+		}
 	}
 
 	// Note: creating a joint doesn't wake the bodies.
@@ -361,6 +732,17 @@ void b2World::DestroyJoint(b2Joint* j)
 
 			edge = edge->next;
 		}
+
+		b2SensorEdge* sensorEdge = bodyB->GetSensorList();
+		while (sensorEdge)
+		{
+			if (sensorEdge->other == bodyA)
+			{
+				sensorEdge->overlap->FlagForFiltering();
+			}
+
+			sensorEdge = sensorEdge->next;
+		}
 	}
 }
 
@@ -388,6 +770,11 @@ void b2World::Solve(const b2TimeStep& step)
 	m_profile.solveInit = 0.0f;
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
+	m_profile.islandCount = 0;
+	m_profile.velocityIterations = 0;
+	m_profile.positionIterations = 0;
+	m_profile.maxVelocityIterations = 0;
+	m_profile.maxPositionIterations = 0;
 
 	// Size the island for the worst case.
 	b2Island island(m_bodyCount,
@@ -401,9 +788,9 @@ void b2World::Solve(const b2TimeStep& step)
 	{
 		b->m_flags &= ~b2Body::e_islandFlag;
 	}
-	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	for (int32 i = 0; i < m_contactManager.m_contactCount; ++i)
 	{
-		c->m_flags &= ~b2Contact::e_islandFlag;
+		m_contactManager.m_contacts[i].contact->m_flags &= ~b2Contact::e_islandFlag;
 	}
 	for (b2Joint* j = m_jointList; j; j = j->m_next)
 	{
@@ -532,6 +919,11 @@ void b2World::Solve(const b2TimeStep& step)
 		m_profile.solveInit += profile.solveInit;
 		m_profile.solveVelocity += profile.solveVelocity;
 		m_profile.solvePosition += profile.solvePosition;
+		m_profile.islandCount += 1;
+		m_profile.velocityIterations += profile.velocityIterations;
+		m_profile.positionIterations += profile.positionIterations;
+		m_profile.maxVelocityIterations = b2Max(m_profile.maxVelocityIterations, profile.velocityIterations);
+		m_profile.maxPositionIterations = b2Max(m_profile.maxPositionIterations, profile.positionIterations);
 
 		// Post solve cleanup.
 		for (int32 i = 0; i < island.m_bodyCount; ++i)
@@ -573,6 +965,163 @@ void b2World::Solve(const b2TimeStep& step)
 	}
 }
 
+// Get the tree of a shape that has many primitives under a single child. This is
+// a compound or a chain with a tree.
+static const b2StaticTree* b2GetPrimitiveTree(const b2Shape* shape)
+{
+	if (shape->GetType() == b2Shape::e_compound)
+	{
+		return &((const b2CompoundShape*)shape)->m_tree;
+	}
+
+	if (shape->GetType() == b2Shape::e_chain && ((const b2ChainShape*)shape)->HasTree())
+	{
+		return &((const b2ChainShape*)shape)->m_tree;
+	}
+
+	return NULL;
+}
+
+static void b2TreeTimeOfImpact(b2TOIOutput* output, b2TOIInput* input,
+								const b2Shape* shapeA, int32 indexA,
+								const b2Shape* shapeB, int32 indexB);
+
+// Finds the earliest time of impact over the primitives of a shape that are near
+// the other shape during the sweep.
+struct b2TreeTOICallback
+{
+	bool QueryCallback(int32 primitive)
+	{
+		b2EdgeShape edgeShape;
+		const b2Shape* primitiveShape;
+		if (treeShape->GetType() == b2Shape::e_compound)
+		{
+			primitiveShape = ((const b2CompoundShape*)treeShape)->GetShape(primitive);
+		}
+		else
+		{
+			((const b2ChainShape*)treeShape)->GetChildEdge(&edgeShape, primitive);
+			primitiveShape = &edgeShape;
+		}
+
+		if (treeIsA)
+		{
+			b2TreeTimeOfImpact(output, input, primitiveShape, 0, shape, index);
+		}
+		else
+		{
+			b2TreeTimeOfImpact(output, input, shape, index, primitiveShape, 0);
+		}
+
+		return true;
+	}
+
+	const b2Shape* treeShape;
+	const b2Shape* shape;
+	int32 index;
+	bool treeIsA;
+	b2TOIInput* input;
+	b2TOIOutput* output;
+};
+
+// Bound a shape in the frame of a tree over the whole sweep. The boxes at both ends
+// are grown by how far rotation can carry a point off the straight line between its
+// end positions. A point at distance r from a center that turns by da stays within
+// r * |da| / 2 of that line. The turn of the tree frame moves the path of the shape
+// center in the same way.
+static void b2ComputeSweptAABB(b2AABB* aabb, const b2Shape* shape, int32 index,
+							   const b2Sweep& sweep, const b2Sweep& treeSweep)
+{
+	b2Transform xf0, xf1, treeXf0, treeXf1;
+	sweep.GetTransform(&xf0, 0.0f);
+	sweep.GetTransform(&xf1, 1.0f);
+	treeSweep.GetTransform(&treeXf0, 0.0f);
+	treeSweep.GetTransform(&treeXf1, 1.0f);
+
+	b2AABB aabb0, aabb1;
+	shape->ComputeAABB(&aabb0, b2MulT(treeXf0, xf0), index);
+	shape->ComputeAABB(&aabb1, b2MulT(treeXf1, xf1), index);
+	aabb->Combine(aabb0, aabb1);
+
+	float32 treeTurn = b2Abs(treeSweep.a - treeSweep.a0);
+	float32 relativeTurn = b2Abs((sweep.a - sweep.a0) - (treeSweep.a - treeSweep.a0));
+	if (treeTurn == 0.0f && relativeTurn == 0.0f)
+	{
+		return;
+	}
+
+	// The reach of the shape from the center of its sweep.
+	b2Transform identity;
+	identity.SetIdentity();
+	b2AABB local;
+	shape->ComputeAABB(&local, identity, index);
+	b2Vec2 lower = local.lowerBound - sweep.localCenter;
+	b2Vec2 upper = local.upperBound - sweep.localCenter;
+	float32 reach = b2Sqrt(b2Max(lower.x * lower.x, upper.x * upper.x) + b2Max(lower.y * lower.y, upper.y * upper.y));
+
+	// The distance between the two centers is largest at one end of the sweep.
+	float32 separation = b2Max(b2Distance(sweep.c0, treeSweep.c0), b2Distance(sweep.c, treeSweep.c));
+
+	float32 margin = 0.5f * (reach * relativeTurn + separation * treeTurn);
+	b2Vec2 r(margin, margin);
+	aabb->lowerBound -= r;
+	aabb->upperBound += r;
+}
+
+// A compound or a chain with a tree is a single child, so find the earliest time of
+// impact over the primitives near the other shape. The output must be initialized
+// to the separated state at tMax. The input tMax shrinks as impacts are found.
+static void b2TreeTimeOfImpact(b2TOIOutput* output, b2TOIInput* input,
+								const b2Shape* shapeA, int32 indexA,
+								const b2Shape* shapeB, int32 indexB)
+{
+	const b2StaticTree* treeA = b2GetPrimitiveTree(shapeA);
+	const b2StaticTree* treeB = b2GetPrimitiveTree(shapeB);
+
+	if (treeA == NULL && treeB == NULL)
+	{
+		input->proxyA.Set(shapeA, indexA);
+		input->proxyB.Set(shapeB, indexB);
+
+		b2TOIOutput primitiveOutput;
+		b2TimeOfImpact(&primitiveOutput, input);
+
+		if (primitiveOutput.state == b2TOIOutput::e_touching && primitiveOutput.t < output->t)
+		{
+			*output = primitiveOutput;
+			input->tMax = primitiveOutput.t;
+		}
+
+		return;
+	}
+
+	b2TreeTOICallback callback;
+	callback.input = input;
+	callback.output = output;
+	callback.treeIsA = treeA != NULL;
+
+	if (treeA)
+	{
+		callback.treeShape = shapeA;
+		callback.shape = shapeB;
+		callback.index = indexB;
+
+		b2AABB aabb;
+		b2ComputeSweptAABB(&aabb, shapeB, indexB, input->sweepB, input->sweepA);
+		treeA->Query(&callback, aabb);
+	}
+	else
+	{
+		callback.treeShape = shapeB;
+		callback.shape = shapeA;
+		callback.index = indexA;
+
+		b2AABB aabb;
+		b2ComputeSweptAABB(&aabb, shapeA, indexA, input->sweepA, input->sweepB);
+		treeB->Query(&callback, aabb);
+	}
+}
+
 // Find TOI contacts and solve them.
 void b2World::SolveTOI(const b2TimeStep& step)
 {
@@ -583,11 +1132,13 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		for (b2Body* b = m_bodyList; b; b = b->m_next)
 		{
 			b->m_flags &= ~b2Body::e_islandFlag;
-			b->m_sweep.alpha0 = 0.0f;
+			b->Sweep().alpha0 = 0.0f;
 		}
 
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+		for (int32 i = 0; i < m_contactManager.m_contactCount; ++i)
 		{
+			b2Contact* c = m_contactManager.m_contacts[i].contact;
+
 			// Invalidate TOI
 			c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
 			c->m_toiCount = 0;
@@ -602,8 +1153,10 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		b2Contact* minContact = NULL;
 		float32 minAlpha = 1.0f;
 
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+		for (int32 i = 0; i < m_contactManager.m_contactCount; ++i)
 		{
+			b2Contact* c = m_contactManager.m_contacts[i].contact;
+
 			// Is this contact disabled?
 			if (c->IsEnabled() == false)
 			{
@@ -652,6 +1205,14 @@ void b2World::SolveTOI(const b2TimeStep& step)
 				bool collideA = bA->IsBullet() || typeA != b2_dynamicBody;
 				bool collideB = bB->IsBullet() || typeB != b2_dynamicBody;
 
+				// Speculative points keep other bodies from tunnelling, so only
+				// bullets need the time of impact.
+				if (m_speculativeContacts && c->CanSpeculate())
+				{
+					collideA = bA->IsBullet();
+					collideB = bB->IsBullet();
+				}
+
 				// Are these two non-bullet dynamic bodies?
 				if (collideA == false && collideB == false)
 				{
@@ -660,17 +1221,17 @@ void b2World::SolveTOI(const b2TimeStep& step)
 
 				// Compute the TOI for this contact.
 				// Put the sweeps onto the same time interval.
-				float32 alpha0 = bA->m_sweep.alpha0;
+				float32 alpha0 = bA->Sweep().alpha0;
 
-				if (bA->m_sweep.alpha0 < bB->m_sweep.alpha0)
+				if (bA->Sweep().alpha0 < bB->Sweep().alpha0)
 				{
-					alpha0 = bB->m_sweep.alpha0;
-					bA->m_sweep.Advance(alpha0);
+					alpha0 = bB->Sweep().alpha0;
+					bA->Sweep().Advance(alpha0);
 				}
-				else if (bB->m_sweep.alpha0 < bA->m_sweep.alpha0)
+				else if (bB->Sweep().alpha0 < bA->Sweep().alpha0)
 				{
-					alpha0 = bA->m_sweep.alpha0;
-					bB->m_sweep.Advance(alpha0);
+					alpha0 = bA->Sweep().alpha0;
+					bB->Sweep().Advance(alpha0);
 				}
 
 				b2Assert(alpha0 < 1.0f);
@@ -680,14 +1241,23 @@ void b2World::SolveTOI(const b2TimeStep& step)
 
 				// Compute the time of impact in interval [0, minTOI]
 				b2TOIInput input;
-				input.proxyA.Set(fA->GetShape(), indexA);
-				input.proxyB.Set(fB->GetShape(), indexB);
-				input.sweepA = bA->m_sweep;
-				input.sweepB = bB->m_sweep;
+				input.sweepA = bA->Sweep();
+				input.sweepB = bB->Sweep();
 				input.tMax = 1.0f;
 
 				b2TOIOutput output;
-				b2TimeOfImpact(&output, &input);
+				if (b2GetPrimitiveTree(fA->GetShape()) || b2GetPrimitiveTree(fB->GetShape()))
+				{
+					output.state = b2TOIOutput::e_separated;
+					output.t = input.tMax;
+					b2TreeTimeOfImpact(&output, &input, fA->GetShape(), indexA, fB->GetShape(), indexB);
+				}
+				else
+				{
+					input.proxyA.Set(fA->GetShape(), indexA);
+					input.proxyB.Set(fB->GetShape(), indexB);
+					b2TimeOfImpact(&output, &input);
+				}
 
 				// Beta is the fraction of the remaining portion of the .
 				float32 beta = output.t;
@@ -725,14 +1295,14 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		b2Body* bA = fA->GetBody();
 		b2Body* bB = fB->GetBody();
 
-		b2Sweep backup1 = bA->m_sweep;
-		b2Sweep backup2 = bB->m_sweep;
+		b2Sweep backup1 = bA->Sweep();
+		b2Sweep backup2 = bB->Sweep();
 
 		bA->Advance(minAlpha);
 		bB->Advance(minAlpha);
 
 		// The TOI contact likely has some new contact points.
-		minContact->Update(m_contactManager.m_contactListener);
+		minContact->Update(m_contactManager.m_contactListener, 0.0f);
 		minContact->m_flags &= ~b2Contact::e_toiFlag;
 		++minContact->m_toiCount;
 
@@ -741,8 +1311,8 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		{
 			// Restore the sweeps.
 			minContact->SetEnabled(false);
-			bA->m_sweep = backup1;
-			bB->m_sweep = backup2;
+			bA->Sweep() = backup1;
+			bB->Sweep() = backup2;
 			bA->SynchronizeTransform();
 			bB->SynchronizeTransform();
 			continue;
@@ -805,19 +1375,19 @@ void b2World::SolveTOI(const b2TimeStep& step)
 					}
 
 					// Tentatively advance the body to the TOI.
-					b2Sweep backup = other->m_sweep;
+					b2Sweep backup = other->Sweep();
 					if ((other->m_flags & b2Body::e_islandFlag) == 0)
 					{
 						other->Advance(minAlpha);
 					}
 
 					// Update the contact points
-					contact->Update(m_contactManager.m_contactListener);
+					contact->Update(m_contactManager.m_contactListener, 0.0f);
 
 					// Was the contact disabled by the user?
 					if (contact->IsEnabled() == false)
 					{
-						other->m_sweep = backup;
+						other->Sweep() = backup;
 						other->SynchronizeTransform();
 						continue;
 					}
@@ -825,7 +1395,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 					// Are there contact points?
 					if (contact->IsTouching() == false)
 					{
-						other->m_sweep = backup;
+						other->Sweep() = backup;
 						other->SynchronizeTransform();
 						continue;
 					}
@@ -860,6 +1430,10 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		subStep.positionIterations = 20;
 		subStep.velocityIterations = step.velocityIterations;
 		subStep.warmStarting = false;
+		subStep.speculative = false;
+		subStep.softStepCount = 0;
+		subStep.contactOrdering = false;
+		subStep.shockPropagation = false;
 		island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
 
 		// Reset island flags and synchronize broad-phase proxies.
@@ -897,6 +1471,9 @@ void b2World::SolveTOI(const b2TimeStep& step)
 void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations)
 {
 	b2Timer stepTimer;
+	uint32 gjkCalls = b2_gjkCalls;
+	uint32 gjkIters = b2_gjkIters;
+	m_stackAllocator.ResetPeak();
 
 	// If new fixtures were added, we need to find the new contacts.
 	if (m_flags & e_newFixture)
@@ -923,11 +1500,15 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	step.dtRatio = m_inv_dt0 * dt;
 
 	step.warmStarting = m_warmStarting;
+	step.speculative = m_speculativeContacts;
+	step.softStepCount = m_softStepCount;
+	step.contactOrdering = m_contactOrdering;
+	step.shockPropagation = m_shockPropagation;
 	
 	// Update contacts. This is where some contacts are destroyed.
 	{
 		b2Timer timer;
-		m_contactManager.Collide();
+		m_contactManager.Collide(m_speculativeContacts ? step.dt : 0.0f);
 		m_profile.collide = timer.GetMilliseconds();
 	}
 
@@ -947,6 +1528,13 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 		m_profile.solveTOI = timer.GetMilliseconds();
 	}
 
+	// Update sensor overlaps against the final transforms.
+	{
+		b2Timer timer;
+		m_contactManager.UpdateSensors();
+		m_profile.sensors = timer.GetMilliseconds();
+	}
+
 	if (step.dt > 0.0f)
 	{
 		m_inv_dt0 = step.inv_dt;
@@ -959,16 +1547,16 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 
 	m_flags &= ~e_locked;
 
+	m_profile.gjkCalls = int32(b2_gjkCalls - gjkCalls);
+	m_profile.gjkIters = int32(b2_gjkIters - gjkIters);
+	m_profile.stackPeak = m_stackAllocator.GetPeakAllocation();
+	m_profile.stackFallbacks = m_stackAllocator.GetFallbackCount();
 	m_profile.step = stepTimer.GetMilliseconds();
 }
 
 void b2World::ClearForces()
 {
-	for (b2Body* body = m_bodyList; body; body = body->GetNext())
-	{
-		body->m_force.SetZero();
-		body->m_torque = 0.0f;
-	}
+	m_bodyStorage.ClearForces();
 }
 
 struct b2WorldQueryWrapper
@@ -1085,6 +1673,42 @@ void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color
 			m_debugDraw->DrawSolidPolygon(vertices, vertexCount, color);
 		}
 		break;
+
+	case b2Shape::e_compound:
+		{
+			b2CompoundShape* compound = (b2CompoundShape*)fixture->GetShape();
+			for (int32 i = 0; i < compound->m_count; ++i)
+			{
+				const b2PolygonShape* poly = compound->m_polygons + i;
+				int32 vertexCount = poly->m_count;
+				b2Vec2 vertices[b2_maxPolygonVertices];
+
+				for (int32 j = 0; j < vertexCount; ++j)
+				{
+					vertices[j] = b2Mul(xf, poly->m_vertices[j]);
+				}
+
+				m_debugDraw->DrawSolidPolygon(vertices, vertexCount, color);
+			}
+		}
+		break;
+
+	case b2Shape::e_capsule:
+		{
+			b2CapsuleShape* capsule = (b2CapsuleShape*)fixture->GetShape();
+			float32 radius = capsule->m_radius;
+			b2Vec2 v1 = b2Mul(xf, capsule->m_vertex1);
+			b2Vec2 v2 = b2Mul(xf, capsule->m_vertex2);
+			b2Vec2 axis = b2Mul(xf.q, b2Vec2(1.0f, 0.0f));
+
+			b2Vec2 normal = b2Cross(v2 - v1, 1.0f);
+			normal.Normalize();
+			m_debugDraw->DrawSolidCircle(v1, radius, axis, color);
+			m_debugDraw->DrawSolidCircle(v2, radius, axis, color);
+			m_debugDraw->DrawSegment(v1 + radius * normal, v2 + radius * normal, color);
+			m_debugDraw->DrawSegment(v1 - radius * normal, v2 - radius * normal, color);
+		}
+		break;
             
     default:
         break;
@@ -1183,7 +1807,7 @@ void b2World::DrawDebugData()
 	if (flags & b2Draw::e_pairBit)
 	{
 		b2Color color(0.3f, 0.9f, 0.9f);
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->GetNext())
+		for (int32 i = 0; i < m_contactManager.m_contactCount; ++i)
 		{
 			//b2Fixture* fixtureA = c->GetFixtureA();
 			//b2Fixture* fixtureB = c->GetFixtureB();
@@ -1236,6 +1860,410 @@ void b2World::DrawDebugData()
 	}
 }
 
+int32 b2World::TrimMemory()
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return 0;
+	}
+
+	return m_blockAllocator.Trim();
+}
+
+// The state of a body that does not live in the body storage.
+struct b2BodySnapshot
+{
+	b2BodyHandle handle;
+	b2BodyType type;
+	uint16 flags;
+	b2Transform xf;
+	float32 mass, invMass;
+	float32 I, invI;
+	float32 sleepTime;
+	int32 fixtureCount;
+};
+
+// The state of a contact. The manifolds of chain and compound contacts follow it.
+// The fixture pointers are safe to use on restore once the fixture ids match.
+struct b2ContactSnapshot
+{
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+	int32 indexA;
+	int32 indexB;
+	uint32 flags;
+	b2Manifold manifold;
+	b2Transform relativeXf;
+	int32 toiCount;
+	float32 toi;
+	float32 friction;
+	float32 restitution;
+	float32 tangentSpeed;
+};
+
+// The state of a sensor overlap.
+struct b2SensorSnapshot
+{
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+	int32 indexA;
+	int32 indexB;
+	uint32 flags;
+	b2SimplexCache simplexCache;
+};
+
+void b2World::Snapshot(b2Snapshot* snapshot) const
+{
+	b2Assert(IsLocked() == false);
+
+	const b2BodyStorage& storage = m_bodyStorage;
+	const b2ContactManager& manager = m_contactManager;
+	int32 bodyCount = storage.m_count;
+
+	snapshot->Clear();
+	snapshot->Write(bodyCount);
+	snapshot->Write(m_jointCount);
+	snapshot->Write(m_flags & e_newFixture);
+	snapshot->Write(m_inv_dt0);
+	snapshot->Write(m_stepComplete);
+
+	// Bodies, in storage order. The body handles and the fixture and joint ids are
+	// only used to check that the structure of the world has not changed. Pointers
+	// would not do, a new body or fixture may reuse the memory of a destroyed one.
+	snapshot->Write(storage.m_sweeps, bodyCount * sizeof(b2Sweep));
+	snapshot->Write(storage.m_linearVelocities, bodyCount * sizeof(b2Vec2));
+	snapshot->Write(storage.m_angularVelocities, bodyCount * sizeof(float32));
+	snapshot->Write(storage.m_forces, bodyCount * sizeof(b2Vec2));
+	snapshot->Write(storage.m_torques, bodyCount * sizeof(float32));
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		const b2Body* b = storage.m_bodies[i];
+
+		b2BodySnapshot state = b2BodySnapshot();
+		state.handle = b->GetHandle();
+		state.type = b->m_type;
+		state.flags = b->m_flags;
+		state.xf = b->m_xf;
+		state.mass = b->m_mass;
+		state.invMass = b->m_invMass;
+		state.I = b->m_I;
+		state.invI = b->m_invI;
+		state.sleepTime = b->m_sleepTime;
+		state.fixtureCount = b->m_fixtureCount;
+		snapshot->Write(state);
+
+		for (const b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			snapshot->Write(f->m_id);
+			snapshot->Write(f->m_proxyCount);
+			snapshot->Write(f->m_proxies, f->m_proxyCount * sizeof(b2FixtureProxy));
+		}
+	}
+
+	// Joints are copied whole. The user data is left alone on restore.
+	for (const b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		snapshot->Write(j->m_id);
+		snapshot->Write(j->m_type);
+		snapshot->Write(j, b2Joint::GetSize(j->m_type));
+	}
+
+	// Contacts, in the order of the contact array.
+	snapshot->Write(manager.m_contactCount);
+	for (int32 i = 0; i < manager.m_contactCount; ++i)
+	{
+		const b2Contact* c = manager.m_contacts[i].contact;
+
+		b2ContactSnapshot state = b2ContactSnapshot();
+		state.fixtureA = c->m_fixtureA;
+		state.fixtureB = c->m_fixtureB;
+		state.indexA = c->m_indexA;
+		state.indexB = c->m_indexB;
+		state.flags = c->m_flags;
+		state.manifold = c->m_manifold;
+		state.relativeXf = c->m_relativeXf;
+		state.toiCount = c->m_toiCount;
+		state.toi = c->m_toi;
+		state.friction = c->m_friction;
+		state.restitution = c->m_restitution;
+		state.tangentSpeed = c->m_tangentSpeed;
+		snapshot->Write(state);
+
+		c->SaveState(snapshot);
+	}
+
+	// The contact edges of each body, as indices into the contact array. The islands
+	// are built by walking these lists, so their order matters.
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		const b2Body* b = storage.m_bodies[i];
+
+		int32 edgeCount = 0;
+		for (const b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+		{
+			++edgeCount;
+		}
+
+		snapshot->Write(edgeCount);
+		for (const b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+		{
+			snapshot->Write(ce->contact->m_managerIndex);
+		}
+	}
+
+	// Sensor overlaps, in list order. The body sensor lists are built in the same
+	// order as the world list, so they need not be saved.
+	snapshot->Write(manager.m_sensorCount);
+	for (const b2SensorOverlap* s = manager.m_sensorList; s; s = s->m_next)
+	{
+		b2SensorSnapshot state = b2SensorSnapshot();
+		state.fixtureA = s->m_fixtureA;
+		state.fixtureB = s->m_fixtureB;
+		state.indexA = s->m_indexA;
+		state.indexB = s->m_indexB;
+		state.flags = s->m_flags;
+		state.simplexCache = s->m_simplexCache;
+		snapshot->Write(state);
+	}
+
+	manager.m_broadPhase.SaveState(snapshot);
+	manager.m_impulseCache.SaveState(snapshot);
+}
+
+bool b2World::Restore(const b2Snapshot* snapshot)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return false;
+	}
+
+	b2BodyStorage& storage = m_bodyStorage;
+	b2ContactManager& manager = m_contactManager;
+
+	b2SnapshotReader reader(snapshot);
+	int32 bodyCount = reader.Read<int32>();
+	int32 jointCount = reader.Read<int32>();
+	if (bodyCount != storage.m_count || jointCount != m_jointCount)
+	{
+		return false;
+	}
+
+	// Check the bodies, fixtures and joints before anything is changed.
+	{
+		b2SnapshotReader check = reader;
+		check.Skip(sizeof(int32) + sizeof(float32) + sizeof(bool));
+
+		check.Skip(bodyCount * (2 * sizeof(b2Vec2) + 2 * sizeof(float32) + sizeof(b2Sweep)));
+
+		for (int32 i = 0; i < bodyCount; ++i)
+		{
+			const b2Body* b = storage.m_bodies[i];
+			b2BodySnapshot state = check.Read<b2BodySnapshot>();
+			b2BodyHandle handle = b->GetHandle();
+			if (state.handle.index != handle.index || state.handle.generation != handle.generation ||
+				state.type != b->m_type || state.fixtureCount != b->m_fixtureCount)
+			{
+				return false;
+			}
+
+			for (const b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+			{
+				uint32 id = check.Read<uint32>();
+				int32 proxyCount = check.Read<int32>();
+				if (id != f->m_id || (proxyCount != 0 && proxyCount != f->m_shape->GetChildCount()))
+				{
+					return false;
+				}
+
+				check.Skip(proxyCount * sizeof(b2FixtureProxy));
+			}
+		}
+
+		for (const b2Joint* j = m_jointList; j; j = j->m_next)
+		{
+			uint32 id = check.Read<uint32>();
+			b2JointType type = check.Read<b2JointType>();
+			if (id != j->m_id || type != j->m_type)
+			{
+				return false;
+			}
+
+			check.Skip(b2Joint::GetSize(type));
+		}
+	}
+
+	// The contacts and sensor overlaps are rebuilt from the snapshot. This also empties
+	// the broad-phase and the impulse cache, which are restored last.
+	manager.Clear();
+
+	if (reader.Read<int32>())
+	{
+		m_flags |= e_newFixture;
+	}
+	else
+	{
+		m_flags &= ~e_newFixture;
+	}
+	m_inv_dt0 = reader.Read<float32>();
+	m_stepComplete = reader.Read<bool>();
+
+	reader.Read(storage.m_sweeps, bodyCount * sizeof(b2Sweep));
+	reader.Read(storage.m_linearVelocities, bodyCount * sizeof(b2Vec2));
+	reader.Read(storage.m_angularVelocities, bodyCount * sizeof(float32));
+	reader.Read(storage.m_forces, bodyCount * sizeof(b2Vec2));
+	reader.Read(storage.m_torques, bodyCount * sizeof(float32));
+
+	// A pending batch edit is not part of the simulation state.
+	const uint16 editFlags = b2Body::e_editFlag | b2Body::e_massDirtyFlag;
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2Body* b = storage.m_bodies[i];
+		b2BodySnapshot state = reader.Read<b2BodySnapshot>();
+		b->m_flags = (state.flags & ~editFlags) | (b->m_flags & editFlags);
+		b->m_xf = state.xf;
+		b->m_mass = state.mass;
+		b->m_invMass = state.invMass;
+		b->m_I = state.I;
+		b->m_invI = state.invI;
+		b->m_sleepTime = state.sleepTime;
+		b->m_contactList = NULL;
+		b->m_sensorList = NULL;
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			reader.Skip(sizeof(uint32));
+			f->m_proxyCount = reader.Read<int32>();
+			reader.Read(f->m_proxies, f->m_proxyCount * sizeof(b2FixtureProxy));
+		}
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		reader.Skip(sizeof(uint32) + sizeof(b2JointType));
+
+		void* userData = j->m_userData;
+		reader.Read(j, b2Joint::GetSize(j->m_type));
+		j->m_userData = userData;
+	}
+
+	int32 contactCount = reader.Read<int32>();
+	for (int32 i = 0; i < contactCount; ++i)
+	{
+		b2ContactSnapshot state = reader.Read<b2ContactSnapshot>();
+
+		b2Contact* c = b2Contact::Create(state.fixtureA, state.indexA, state.fixtureB, state.indexB, &m_blockAllocator);
+		b2Assert(c->m_fixtureA == state.fixtureA && c->m_fixtureB == state.fixtureB);
+		c->m_flags = state.flags;
+		c->m_manifold = state.manifold;
+		c->m_relativeXf = state.relativeXf;
+		c->m_toiCount = state.toiCount;
+		c->m_toi = state.toi;
+		c->m_friction = state.friction;
+		c->m_restitution = state.restitution;
+		c->m_tangentSpeed = state.tangentSpeed;
+		c->RestoreState(&reader);
+
+		c->m_nodeA.contact = c;
+		c->m_nodeA.other = state.fixtureB->m_body;
+		c->m_nodeB.contact = c;
+		c->m_nodeB.other = state.fixtureA->m_body;
+
+		manager.Link(c);
+	}
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2Body* b = storage.m_bodies[i];
+		int32 edgeCount = reader.Read<int32>();
+
+		b2ContactEdge* prev = NULL;
+		for (int32 k = 0; k < edgeCount; ++k)
+		{
+			b2Contact* c = manager.m_contacts[reader.Read<int32>()].contact;
+			b2ContactEdge* edge = c->m_fixtureA->m_body == b ? &c->m_nodeA : &c->m_nodeB;
+
+			edge->prev = prev;
+			edge->next = NULL;
+			if (prev != NULL)
+			{
+				prev->next = edge;
+			}
+			else
+			{
+				b->m_contactList = edge;
+			}
+			prev = edge;
+		}
+	}
+
+	// Append the sensor overlaps to the world list, then prepend them to the body lists
+	// from the back so both lists keep their saved order.
+	int32 sensorCount = reader.Read<int32>();
+	b2SensorOverlap* tail = NULL;
+	for (int32 i = 0; i < sensorCount; ++i)
+	{
+		b2SensorSnapshot state = reader.Read<b2SensorSnapshot>();
+
+		void* mem = m_blockAllocator.Allocate(sizeof(b2SensorOverlap));
+		b2SensorOverlap* s = new (mem) b2SensorOverlap;
+		s->m_flags = state.flags;
+		s->m_fixtureA = state.fixtureA;
+		s->m_fixtureB = state.fixtureB;
+		s->m_indexA = state.indexA;
+		s->m_indexB = state.indexB;
+		s->m_simplexCache = state.simplexCache;
+
+		s->m_prev = tail;
+		s->m_next = NULL;
+		if (tail != NULL)
+		{
+			tail->m_next = s;
+		}
+		else
+		{
+			manager.m_sensorList = s;
+		}
+		tail = s;
+	}
+	manager.m_sensorCount = sensorCount;
+
+	for (b2SensorOverlap* s = tail; s; s = s->m_prev)
+	{
+		b2Body* bodyA = s->m_fixtureA->m_body;
+		b2Body* bodyB = s->m_fixtureB->m_body;
+
+		s->m_nodeA.overlap = s;
+		s->m_nodeA.other = bodyB;
+		s->m_nodeA.prev = NULL;
+		s->m_nodeA.next = bodyA->m_sensorList;
+		if (bodyA->m_sensorList != NULL)
+		{
+			bodyA->m_sensorList->prev = &s->m_nodeA;
+		}
+		bodyA->m_sensorList = &s->m_nodeA;
+
+		s->m_nodeB.overlap = s;
+		s->m_nodeB.other = bodyA;
+		s->m_nodeB.prev = NULL;
+		s->m_nodeB.next = bodyB->m_sensorList;
+		if (bodyB->m_sensorList != NULL)
+		{
+			bodyB->m_sensorList->prev = &s->m_nodeB;
+		}
+		bodyB->m_sensorList = &s->m_nodeB;
+	}
+
+	manager.m_broadPhase.RestoreState(&reader);
+	manager.m_impulseCache.RestoreState(&reader);
+	b2Assert(reader.IsDone());
+
+	return true;
+}
+
 int32 b2World::GetProxyCount() const
 {
 	return m_contactManager.m_broadPhase.GetProxyCount();
@@ -1267,8 +2295,8 @@ void b2World::ShiftOrigin(const b2Vec2& newOrigin)
 	for (b2Body* b = m_bodyList; b; b = b->m_next)
 	{
 		b->m_xf.p -= newOrigin;
-		b->m_sweep.c0 -= newOrigin;
-		b->m_sweep.c -= newOrigin;
+		b->Sweep().c0 -= newOrigin;
+		b->Sweep().c -= newOrigin;
 	}
 
 	for (b2Joint* j = m_jointList; j; j = j->m_next)
@@ -23,17 +23,21 @@
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Common/b2StackAllocator.h>
 #include <Box2D/Dynamics/b2ContactManager.h>
+#include <Box2D/Dynamics/b2BodyStorage.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
 
 struct b2AABB;
 struct b2BodyDef;
 struct b2Color;
+struct b2FixtureDef;
 struct b2JointDef;
 class b2Body;
 class b2Draw;
 class b2Fixture;
 class b2Joint;
+class b2SensorOverlap;
+class b2Snapshot;
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -43,7 +47,9 @@ class b2World
 public:
 	/// Construct a world object.
 	/// @param gravity the world gravity vector.
-	b2World(const b2Vec2& gravity);
+	/// @param allocator the source of the world's memory, or NULL to use b2Alloc and
+	/// b2Free. The allocator is owned by you and must outlive the world.
+	b2World(const b2Vec2& gravity, b2AllocatorInterface* allocator = NULL);
 
 	/// Destruct the world. All physics entities are destroyed and all heap memory is released.
 	~b2World();
@@ -57,6 +63,16 @@ public:
 	/// owned by you and must remain in scope. 
 	void SetContactFilter(b2ContactFilter* filter);
 
+	/// Enable/disable collision between two collision layers. All layer pairs collide
+	/// by default. Disabled pairs are rejected before a contact is created, so they
+	/// never reach the contact filter. Non-zero group filtering always wins against
+	/// the layer matrix. Existing contacts are re-filtered at the next time step.
+	/// @see b2Filter::layer
+	void SetLayerCollision(int32 layerA, int32 layerB, bool flag);
+
+	/// Do fixtures in these two collision layers collide?
+	bool GetLayerCollision(int32 layerA, int32 layerB) const;
+
 	/// Register a contact event listener. The listener is owned by you and must
 	/// remain in scope.
 	void SetContactListener(b2ContactListener* listener);
@@ -77,6 +93,30 @@ public:
 	/// @warning This function is locked during callbacks.
 	void DestroyBody(b2Body* body);
 
+	/// Create a batch of rigid bodies. This is equivalent to calling CreateBody for
+	/// each definition, but reserves the body storage once.
+	/// @param bodies receives the created bodies
+	/// @warning This function is locked during callbacks.
+	void CreateBodies(const b2BodyDef* defs, int32 count, b2Body** bodies);
+
+	/// Create a batch of fixtures. Fixture i is attached to bodies[i]. The broad-phase
+	/// proxies of the whole batch are built in one pass, and the mass of a body is
+	/// computed once for each run of its fixtures, so keep the fixtures of a body together.
+	/// @param fixtures receives the created fixtures, or may be NULL
+	/// @warning This function is locked during callbacks.
+	void CreateFixtures(b2Body* const* bodies, const b2FixtureDef* defs, int32 count, b2Fixture** fixtures);
+
+	/// Destroy a batch of rigid bodies. This is equivalent to calling DestroyBody for
+	/// each body, but removes their broad-phase proxies in one pass.
+	/// @warning This automatically deletes all associated shapes and joints.
+	/// @warning This function is locked during callbacks.
+	void DestroyBodies(b2Body* const* bodies, int32 count);
+
+	/// Destroy all the bodies, joints and contacts by resetting the world's allocators.
+	/// Unlike DestroyBody, no destruction listener is called. Body handles stop resolving.
+	/// @warning This function is locked during callbacks.
+	void Clear();
+
 	/// Create a joint to constrain bodies together. No reference to the definition
 	/// is retained. This may cause the connected bodies to cease colliding.
 	/// @warning This function is locked during callbacks.
@@ -127,6 +167,11 @@ public:
 	b2Body* GetBodyList();
 	const b2Body* GetBodyList() const;
 
+	/// Get the body of a handle from b2Body::GetHandle.
+	/// @return the body, or NULL if it was destroyed.
+	b2Body* GetBody(b2BodyHandle handle);
+	const b2Body* GetBody(b2BodyHandle handle) const;
+
 	/// Get the world joint list. With the returned joint, use b2Joint::GetNext to get
 	/// the next joint in the world list. A NULL joint indicates the end of the list.
 	/// @return the head of the world joint list.
@@ -141,6 +186,12 @@ public:
 	b2Contact* GetContactList();
 	const b2Contact* GetContactList() const;
 
+	/// Get the world sensor overlap list. Sensor overlaps exist for each sensor
+	/// fixture pair that overlaps in the broad-phase. Use b2SensorOverlap::IsTouching
+	/// to check for actual overlap.
+	b2SensorOverlap* GetSensorOverlapList();
+	const b2SensorOverlap* GetSensorOverlapList() const;
+
 	/// Enable/disable sleep.
 	void SetAllowSleeping(bool flag);
 	bool GetAllowSleeping() const { return m_allowSleep; }
@@ -157,6 +208,36 @@ public:
 	void SetSubStepping(bool flag) { m_subStepping = flag; }
 	bool GetSubStepping() const { return m_subStepping; }
 
+	/// Enable/disable speculative contacts. Contacts get a point as soon as the shapes
+	/// may touch within the next step and the velocity solver keeps them from closing
+	/// the gap too far. Continuous collision is then only used for bullets and for
+	/// contacts with a compound shape or a chain tree. Begin contact events may be
+	/// reported up to one step before the shapes actually touch.
+	void SetSpeculativeContacts(bool flag) { m_speculativeContacts = flag; }
+	bool GetSpeculativeContacts() const { return m_speculativeContacts; }
+
+	/// Set the number of soft step substeps. Zero, the default, uses the iterative
+	/// solver. Otherwise each island step is split into this many substeps that solve
+	/// every constraint once with soft contacts and then relax them. The velocity
+	/// iterations passed to Step are ignored and the position iterations only apply to
+	/// joints. Four substeps are a good start. Contact impulses reported to PostSolve
+	/// are those of the last substep.
+	void SetSoftStepCount(int32 count) { b2Assert(count >= 0); m_softStepCount = count; }
+	int32 GetSoftStepCount() const { return m_softStepCount; }
+
+	/// Enable/disable contact ordering. Each island then solves its contacts bottom-up,
+	/// starting from the contacts with static and kinematic bodies, so stacks converge
+	/// in fewer iterations.
+	void SetContactOrdering(bool flag) { m_contactOrdering = flag; }
+	bool GetContactOrdering() const { return m_contactOrdering; }
+
+	/// Enable/disable shock propagation. This orders the contacts like SetContactOrdering
+	/// and adds a final position pass that treats the supporting body of each contact as
+	/// immovable. Overlap in stacks is then corrected from the ground up within one step
+	/// and stacks come to rest sooner. The soft step solver ignores this flag.
+	void SetShockPropagation(bool flag) { m_shockPropagation = flag; }
+	bool GetShockPropagation() const { return m_shockPropagation; }
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
@@ -169,6 +250,9 @@ public:
 	/// Get the number of contacts (each may have 0 or more contact points).
 	int32 GetContactCount() const;
 
+	/// Get the number of sensor overlaps.
+	int32 GetSensorOverlapCount() const;
+
 	/// Get the height of the dynamic tree.
 	int32 GetTreeHeight() const;
 
@@ -205,6 +289,27 @@ public:
 	/// Get the current profile.
 	const b2Profile& GetProfile() const;
 
+	/// Return the memory of fully free allocator chunks to the system. A world that
+	/// once held many bodies or contacts otherwise keeps its peak footprint. Call this
+	/// now and then, for example after a level is unloaded.
+	/// @warning this should be called outside of a time step.
+	/// @return the number of bytes released.
+	int32 TrimMemory();
+
+	/// Save the simulation state of the world: body positions and velocities, forces,
+	/// sleep state, joints, contacts with their manifolds and impulses, and the broad-phase.
+	/// Settings such as gravity, damping and listeners are not saved.
+	/// @warning this should be called outside of a time step.
+	void Snapshot(b2Snapshot* snapshot) const;
+
+	/// Bring the world back to a snapshot. Stepping a restored world gives the same results,
+	/// bit for bit, as stepping the world when the snapshot was taken. The world must have
+	/// the same bodies, fixtures and joints it had then. Contacts may have come and gone.
+	/// No listener is called.
+	/// @warning this should be called outside of a time step.
+	/// @return false, leaving the world unchanged, if the bodies, fixtures or joints differ.
+	bool Restore(const b2Snapshot* snapshot);
+
 	/// Dump the world into the log file.
 	/// @warning this should be called outside of a time step.
 	void Dump();
@@ -227,6 +332,10 @@ private:
 	void Solve(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
 
+	// Add the proxies of a batch of fixtures to the broad-phase in one pass. The
+	// fixtures of inactive bodies and of bodies in an edit are skipped.
+	void CreateProxies(b2Fixture* const* fixtures, int32 count);
+
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
 
@@ -237,12 +346,19 @@ private:
 
 	b2ContactManager m_contactManager;
 
+	b2BodyStorage m_bodyStorage;
+
 	b2Body* m_bodyList;
 	b2Joint* m_jointList;
 
 	int32 m_bodyCount;
 	int32 m_jointCount;
 
+	// The ids of the next fixture and joint. Ids are not reused, so a cleared world
+	// keeps counting.
+	uint32 m_fixtureIdCount;
+	uint32 m_jointIdCount;
+
 	b2Vec2 m_gravity;
 	bool m_allowSleep;
 
@@ -257,6 +373,10 @@ private:
 	bool m_warmStarting;
 	bool m_continuousPhysics;
 	bool m_subStepping;
+	bool m_speculativeContacts;
+	int32 m_softStepCount;
+	bool m_contactOrdering;
+	bool m_shockPropagation;
 
 	bool m_stepComplete;
 
@@ -273,6 +393,16 @@ inline const b2Body* b2World::GetBodyList() const
 	return m_bodyList;
 }
 
+inline b2Body* b2World::GetBody(b2BodyHandle handle)
+{
+	return m_bodyStorage.GetBody(handle);
+}
+
+inline const b2Body* b2World::GetBody(b2BodyHandle handle) const
+{
+	return m_bodyStorage.GetBody(handle);
+}
+
 inline b2Joint* b2World::GetJointList()
 {
 	return m_jointList;
@@ -285,12 +415,22 @@ inline const b2Joint* b2World::GetJointList() const
 
 inline b2Contact* b2World::GetContactList()
 {
-	return m_contactManager.m_contactList;
+	return m_contactManager.m_contactCount > 0 ? m_contactManager.m_contacts[0].contact : NULL;
 }
 
 inline const b2Contact* b2World::GetContactList() const
 {
-	return m_contactManager.m_contactList;
+	return m_contactManager.m_contactCount > 0 ? m_contactManager.m_contacts[0].contact : NULL;
+}
+
+inline b2SensorOverlap* b2World::GetSensorOverlapList()
+{
+	return m_contactManager.m_sensorList;
+}
+
+inline const b2SensorOverlap* b2World::GetSensorOverlapList() const
+{
+	return m_contactManager.m_sensorList;
 }
 
 inline int32 b2World::GetBodyCount() const
@@ -308,6 +448,11 @@ inline int32 b2World::GetContactCount() const
 	return m_contactManager.m_contactCount;
 }
 
+inline int32 b2World::GetSensorOverlapCount() const
+{
+	return m_contactManager.m_sensorCount;
+}
+
 inline void b2World::SetGravity(const b2Vec2& gravity)
 {
 	m_gravity = gravity;
@@ -341,6 +486,13 @@ inline bool b2World::GetAutoClearForces() const
 	return (m_flags & e_clearForces) == e_clearForces;
 }
 
+inline bool b2World::GetLayerCollision(int32 layerA, int32 layerB) const
+{
+	b2Assert(0 <= layerA && layerA < b2_maxCollisionLayers);
+	b2Assert(0 <= layerB && layerB < b2_maxCollisionLayers);
+	return (m_contactManager.m_layerMatrix[layerA] & (1u << layerB)) != 0;
+}
+
 inline const b2ContactManager& b2World::GetContactManager() const
 {
 	return m_contactManager;
@@ -27,6 +27,7 @@ class b2Fixture;
 class b2Body;
 class b2Joint;
 class b2Contact;
+class b2SensorOverlap;
 struct b2ContactResult;
 struct b2Manifold;
 
@@ -84,11 +85,21 @@ public:
 	virtual ~b2ContactListener() {}
 
 	/// Called when two fixtures begin to touch.
+	/// Note: this is not called for sensors, see BeginSensorOverlap.
 	virtual void BeginContact(b2Contact* contact) { B2_NOT_USED(contact); }
 
 	/// Called when two fixtures cease to touch.
+	/// Note: this is not called for sensors, see EndSensorOverlap.
 	virtual void EndContact(b2Contact* contact) { B2_NOT_USED(contact); }
 
+	/// Called when a sensor begins to overlap another fixture. Sensor overlaps
+	/// are updated once per time step, after the solver.
+	virtual void BeginSensorOverlap(b2SensorOverlap* overlap) { B2_NOT_USED(overlap); }
+
+	/// Called when a sensor ceases to overlap another fixture. This is also called
+	/// when a touching overlap is destroyed.
+	virtual void EndSensorOverlap(b2SensorOverlap* overlap) { B2_NOT_USED(overlap); }
+
 	/// This is called after a contact is updated. This allows you to inspect a
 	/// contact before it goes to the solver. If you are careful, you can modify the
 	/// contact manifold (e.g. disable contact).
@@ -111,6 +122,7 @@ public:
 	/// arbitrarily large if the sub-step is small. Hence the impulse is provided explicitly
 	/// in a separate data structure.
 	/// Note: this is only called for contacts that are touching, solid, and awake.
+	/// Note: this is called once per manifold, see b2Contact::GetManifoldCount.
 	virtual void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse)
 	{
 		B2_NOT_USED(contact);
@@ -9,31 +9,46 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    Box2D/Collision/Shapes/b2CapsuleShape.cpp \
     Box2D/Collision/Shapes/b2ChainShape.cpp \
     Box2D/Collision/Shapes/b2CircleShape.cpp \
+    Box2D/Collision/Shapes/b2CompoundShape.cpp \
     Box2D/Collision/Shapes/b2EdgeShape.cpp \
     Box2D/Collision/Shapes/b2PolygonShape.cpp \
     Box2D/Collision/b2BroadPhase.cpp \
+    Box2D/Collision/b2CollideCapsule.cpp \
     Box2D/Collision/b2CollideCircle.cpp \
     Box2D/Collision/b2CollideEdge.cpp \
     Box2D/Collision/b2CollidePolygon.cpp \
     Box2D/Collision/b2Collision.cpp \
     Box2D/Collision/b2Distance.cpp \
     Box2D/Collision/b2DynamicTree.cpp \
+    Box2D/Collision/b2StaticTree.cpp \
     Box2D/Collision/b2TimeOfImpact.cpp \
+    Box2D/Common/b2AllocatorInterface.cpp \
     Box2D/Common/b2BlockAllocator.cpp \
     Box2D/Common/b2Draw.cpp \
     Box2D/Common/b2Math.cpp \
     Box2D/Common/b2Settings.cpp \
+    Box2D/Common/b2Snapshot.cpp \
     Box2D/Common/b2StackAllocator.cpp \
     Box2D/Common/b2Timer.cpp \
+    Box2D/Dynamics/Contacts/b2CapsuleAndCircleContact.cpp \
+    Box2D/Dynamics/Contacts/b2CapsuleContact.cpp \
+    Box2D/Dynamics/Contacts/b2ChainAndCapsuleContact.cpp \
     Box2D/Dynamics/Contacts/b2ChainAndCircleContact.cpp \
     Box2D/Dynamics/Contacts/b2ChainAndPolygonContact.cpp \
+    Box2D/Dynamics/Contacts/b2ChainContact.cpp \
     Box2D/Dynamics/Contacts/b2CircleContact.cpp \
+    Box2D/Dynamics/Contacts/b2CompoundContact.cpp \
     Box2D/Dynamics/Contacts/b2Contact.cpp \
     Box2D/Dynamics/Contacts/b2ContactSolver.cpp \
+    Box2D/Dynamics/Contacts/b2EdgeAndCapsuleContact.cpp \
     Box2D/Dynamics/Contacts/b2EdgeAndCircleContact.cpp \
     Box2D/Dynamics/Contacts/b2EdgeAndPolygonContact.cpp \
+    Box2D/Dynamics/Contacts/b2ImpulseCache.cpp \
+    Box2D/Dynamics/Contacts/b2ManifoldSet.cpp \
+    Box2D/Dynamics/Contacts/b2PolygonAndCapsuleContact.cpp \
     Box2D/Dynamics/Contacts/b2PolygonAndCircleContact.cpp \
     Box2D/Dynamics/Contacts/b2PolygonContact.cpp \
     Box2D/Dynamics/Joints/b2DistanceJoint.cpp \
@@ -49,6 +64,7 @@ SOURCES += \
     Box2D/Dynamics/Joints/b2WeldJoint.cpp \
     Box2D/Dynamics/Joints/b2WheelJoint.cpp \
     Box2D/Dynamics/b2Body.cpp \
+    Box2D/Dynamics/b2BodyStorage.cpp \
     Box2D/Dynamics/b2ContactManager.cpp \
     Box2D/Dynamics/b2Fixture.cpp \
     Box2D/Dynamics/b2Island.cpp \
@@ -65,8 +81,10 @@ SOURCES += \
 
 HEADERS += \
     Box2D/Box2D.h \
+    Box2D/Collision/Shapes/b2CapsuleShape.h \
     Box2D/Collision/Shapes/b2ChainShape.h \
     Box2D/Collision/Shapes/b2CircleShape.h \
+    Box2D/Collision/Shapes/b2CompoundShape.h \
     Box2D/Collision/Shapes/b2EdgeShape.h \
     Box2D/Collision/Shapes/b2PolygonShape.h \
     Box2D/Collision/Shapes/b2Shape.h \
@@ -74,21 +92,33 @@ HEADERS += \
     Box2D/Collision/b2Collision.h \
     Box2D/Collision/b2Distance.h \
     Box2D/Collision/b2DynamicTree.h \
+    Box2D/Collision/b2StaticTree.h \
     Box2D/Collision/b2TimeOfImpact.h \
+    Box2D/Common/b2AllocatorInterface.h \
     Box2D/Common/b2BlockAllocator.h \
     Box2D/Common/b2Draw.h \
     Box2D/Common/b2GrowableStack.h \
     Box2D/Common/b2Math.h \
     Box2D/Common/b2Settings.h \
+    Box2D/Common/b2Snapshot.h \
     Box2D/Common/b2StackAllocator.h \
     Box2D/Common/b2Timer.h \
+    Box2D/Dynamics/Contacts/b2CapsuleAndCircleContact.h \
+    Box2D/Dynamics/Contacts/b2CapsuleContact.h \
+    Box2D/Dynamics/Contacts/b2ChainAndCapsuleContact.h \
     Box2D/Dynamics/Contacts/b2ChainAndCircleContact.h \
     Box2D/Dynamics/Contacts/b2ChainAndPolygonContact.h \
+    Box2D/Dynamics/Contacts/b2ChainContact.h \
     Box2D/Dynamics/Contacts/b2CircleContact.h \
+    Box2D/Dynamics/Contacts/b2CompoundContact.h \
     Box2D/Dynamics/Contacts/b2Contact.h \
     Box2D/Dynamics/Contacts/b2ContactSolver.h \
+    Box2D/Dynamics/Contacts/b2EdgeAndCapsuleContact.h \
     Box2D/Dynamics/Contacts/b2EdgeAndCircleContact.h \
     Box2D/Dynamics/Contacts/b2EdgeAndPolygonContact.h \
+    Box2D/Dynamics/Contacts/b2ImpulseCache.h \
+    Box2D/Dynamics/Contacts/b2ManifoldSet.h \
+    Box2D/Dynamics/Contacts/b2PolygonAndCapsuleContact.h \
     Box2D/Dynamics/Contacts/b2PolygonAndCircleContact.h \
     Box2D/Dynamics/Contacts/b2PolygonContact.h \
     Box2D/Dynamics/Joints/b2DistanceJoint.h \
@@ -104,9 +134,11 @@ HEADERS += \
     Box2D/Dynamics/Joints/b2WeldJoint.h \
     Box2D/Dynamics/Joints/b2WheelJoint.h \
     Box2D/Dynamics/b2Body.h \
+    Box2D/Dynamics/b2BodyStorage.h \
     Box2D/Dynamics/b2ContactManager.h \
     Box2D/Dynamics/b2Fixture.h \
     Box2D/Dynamics/b2Island.h \
+    Box2D/Dynamics/b2SensorOverlap.h \
     Box2D/Dynamics/b2TimeStep.h \
     Box2D/Dynamics/b2World.h \
     Box2D/Dynamics/b2WorldCallbacks.h \